@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace curve {
+
+typedef unsigned __int128 u128;
+
+// Newton steps allowed per stableswap solve, keeps the cpu cost of a hop fixed
+const int STABLE_ITERATIONS = 32;
+
+// floor(sqrt(n)) by integer Newton iteration, exact where a double sqrt of a
+// product of two reserves is not
+inline uint64_t isqrt(u128 n)
+{
+    if (n < 2)
+    {
+        return (uint64_t)n;
+    }
+    // start from a power of two no smaller than the root, Newton then decreases to it
+    int bits = 0;
+    for (u128 m = n; m > 0; m >>= 1)
+    {
+        bits++;
+    }
+    u128 x = (u128)1 << ((bits + 1) / 2);
+    u128 y = (x + n / x) / 2;
+    while (y < x)
+    {
+        x = y;
+        y = (x + n / x) / 2;
+    }
+    return (uint64_t)x;
+}
+
+// Virtual reserve offsets of a range bound pool: with real reserves x, y and
+// the price of token1 in token2 (raw units) bounded to [pa, pb], the pool
+// trades as x*y=k on (x + a, y + b) where a = L/sqrt(pb), b = L*sqrt(pa).
+// The offsets are whole units, so a swap keeps k exactly in 128 bits.
+struct range_t
+{
+    uint64_t a;
+    uint64_t b;
+};
+
+// largest offset, the largest asset amount: (x + a) * (y + b) fits 128 bits
+const double RANGE_OFFSET_MAX = 4611686018427387903.0;
+
+// L of a range bound pool, the root of (x + a) * (y + b) before the offsets
+// are rounded
+inline double range_liquidity(double x, double y, double pa, double pb)
+{
+    double sa = std::sqrt(pa);
+    double sb = std::sqrt(pb);
+    double c = 1 - sa / sb;
+    double m = x * sa + y / sb;
+    return (m + std::sqrt(m * m + 4 * c * x * y)) / (2 * c);
+}
+
+inline range_t range_offsets(double x, double y, double pa, double pb)
+{
+    double sa = std::sqrt(pa);
+    double sb = std::sqrt(pb);
+    double l = range_liquidity(x, y, pa, pb);
+
+    return range_t{(uint64_t)std::floor(std::min(l / sb, RANGE_OFFSET_MAX)),
+                   (uint64_t)std::floor(std::min(l * sa, RANGE_OFFSET_MAX))};
+}
+
+// reserves the stableswap maths is evaluated for without 128 bit overflow:
+// below 2^51 in total and within 1:1000 of each other, past which the peg is gone
+inline bool stable_bounded(u128 x, u128 y)
+{
+    return x + y < ((u128)1 << 51) && x * 1000 >= y && y * 1000 >= x;
+}
+
+// StableSwap invariant of a two token pool with both reserves in the same
+// precision: ann * (x + y) + d = ann * d + d^3 / (4 * x * y), ann = amp * 2.
+// Returns 0 when the iteration does not converge.
+inline u128 stable_d(u128 x, u128 y, uint64_t amp)
+{
+    u128 s = x + y;
+    if (s == 0)
+        return 0;
+
+    u128 ann = (u128)amp * 2;
+    u128 d = s;
+    for (int i = 0; i < STABLE_ITERATIONS; i++)
+    {
+        u128 dp = d * d / (x * 2) * d / (y * 2);
+        u128 prev = d;
+        d = (ann * s + dp * 2) * d / ((ann - 1) * d + 3 * dp);
+        if ((d > prev ? d - prev : prev - d) <= 1)
+            return d;
+    }
+    return 0;
+}
+
+// the other reserve once one side moves to x with the invariant held at d,
+// 0 when the iteration does not converge
+inline u128 stable_y(u128 x, u128 d, uint64_t amp)
+{
+    u128 ann = (u128)amp * 2;
+    u128 c = d * d / (x * 2) * d / (ann * 2);
+    u128 b = x + d / ann;
+    u128 y = d;
+    for (int i = 0; i < STABLE_ITERATIONS; i++)
+    {
+        u128 prev = y;
+        y = (y * y + c) / (2 * y + b - d);
+        if ((y > prev ? y - prev : prev - y) <= 1)
+            return y;
+    }
+    return 0;
+}
+
+// marginal price of x in y on the stableswap curve
+inline double stable_price(double x, double y, double d, uint64_t amp)
+{
+    double ann = amp * 2.0;
+    double d3 = d * d * d / 4;
+    return (ann + d3 / (x * x * y)) / (ann + d3 / (x * y * y));
+}
+
+} // namespace curve
@@ -0,0 +1,455 @@
+#pragma once
+
+// Compact log events emitted by onesgamedefi through a single `event(bytes)`
+// inline action per transaction action. Frame layout:
+//
+//   version:u8  { type:u8  size:u8  fields... }*
+//
+// size counts the field bytes, so a reader steps over types it does not
+// know and over fields appended to types it does. Version 1 frames have no
+// size byte and are still read. Names and symbols are fixed 8 byte little
+// endian, weights are the raw 4 bytes of the float, every other integer is
+// a LEB128 varint. This header has no eosio dependency so off-chain readers
+// can include it directly.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace events {
+
+const uint8_t VERSION = 2;
+
+enum type : uint8_t
+{
+    SWAP = 1,
+    LIQUIDITY = 2,
+    NEWLIQUIDITY = 3,
+    WEIGHT = 4,
+    MARKET = 5,
+    FEE = 6,
+    CURVE = 7,
+};
+
+// liquidity event kinds
+const uint8_t DEPOSIT = 1;
+const uint8_t WITHDRAW = 2;
+
+struct swap_event
+{
+    uint64_t account;
+    uint64_t third_id;
+    uint64_t liquidity_id;
+    uint8_t direction;
+    uint64_t in_amount;
+    uint64_t out_amount;
+    uint64_t fee_amount;
+};
+
+struct liquidity_event
+{
+    uint64_t account;
+    uint64_t liquidity_id;
+    uint8_t kind;
+    uint64_t amount1;
+    uint64_t amount2;
+    uint64_t liquidity_token;
+    uint64_t balance1;
+    uint64_t balance2;
+    uint64_t balance_ltoken;
+};
+
+struct newliquidity_event
+{
+    uint64_t liquidity_id;
+    uint64_t contract1;
+    uint64_t symbol1;
+    uint64_t contract2;
+    uint64_t symbol2;
+};
+
+struct weight_event
+{
+    uint64_t liquidity_id;
+    uint8_t kind;
+    float weight;
+};
+
+// a settled market mining position; reward_amount is 0 when nothing was mined
+struct market_event
+{
+    uint64_t mine_id;
+    uint64_t venue;
+    uint64_t liquidity_id;
+    uint64_t in_amount1;
+    uint64_t in_amount2;
+    uint64_t out_amount1;
+    uint64_t out_amount2;
+    uint64_t reward_amount;
+    uint64_t reward_symbol;
+    uint32_t begin_time;
+    uint32_t end_time;
+};
+
+// fees of a pool in basis points, as set by updatefee
+struct fee_event
+{
+    uint64_t liquidity_id;
+    uint64_t swap_fee;
+    uint64_t fund_fee;
+    uint64_t divd_fee;
+};
+
+// pricing curve of a pool, as set by setcurve
+struct curve_event
+{
+    uint64_t liquidity_id;
+    uint8_t kind;
+    uint64_t param1;
+    uint64_t param2;
+};
+
+class writer
+{
+public:
+    bool empty() const { return data.size() <= 1; }
+    void clear() { data.assign(1, (char)VERSION); }
+
+    void put(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            data.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        data.push_back((char)v);
+    }
+
+    void put_byte(uint8_t v) { data.push_back((char)v); }
+
+    // starts an event, finish() fills in its size once the fields are written;
+    // the largest event, market, stays well under the 255 bytes a size holds
+    size_t begin(uint8_t type)
+    {
+        put_byte(type);
+        put_byte(0);
+        return data.size();
+    }
+
+    void finish(size_t start) { data[start - 1] = (char)(data.size() - start); }
+
+    void put_fixed(uint64_t v)
+    {
+        for (int i = 0; i < 8; i++, v >>= 8)
+            data.push_back((char)(v & 0xff));
+    }
+
+    void put_float(float v)
+    {
+        char b[4];
+        memcpy(b, &v, 4);
+        data.insert(data.end(), b, b + 4);
+    }
+
+    void add(const swap_event &e)
+    {
+        size_t start = begin(SWAP);
+        put_fixed(e.account);
+        put(e.third_id);
+        put(e.liquidity_id);
+        put_byte(e.direction);
+        put(e.in_amount);
+        put(e.out_amount);
+        put(e.fee_amount);
+        finish(start);
+    }
+
+    void add(const liquidity_event &e)
+    {
+        size_t start = begin(LIQUIDITY);
+        put_fixed(e.account);
+        put(e.liquidity_id);
+        put_byte(e.kind);
+        put(e.amount1);
+        put(e.amount2);
+        put(e.liquidity_token);
+        put(e.balance1);
+        put(e.balance2);
+        put(e.balance_ltoken);
+        finish(start);
+    }
+
+    void add(const newliquidity_event &e)
+    {
+        size_t start = begin(NEWLIQUIDITY);
+        put(e.liquidity_id);
+        put_fixed(e.contract1);
+        put_fixed(e.symbol1);
+        put_fixed(e.contract2);
+        put_fixed(e.symbol2);
+        finish(start);
+    }
+
+    void add(const weight_event &e)
+    {
+        size_t start = begin(WEIGHT);
+        put(e.liquidity_id);
+        put_byte(e.kind);
+        put_float(e.weight);
+        finish(start);
+    }
+
+    void add(const market_event &e)
+    {
+        size_t start = begin(MARKET);
+        put(e.mine_id);
+        put_fixed(e.venue);
+        put(e.liquidity_id);
+        put(e.in_amount1);
+        put(e.in_amount2);
+        put(e.out_amount1);
+        put(e.out_amount2);
+        put(e.reward_amount);
+        put_fixed(e.reward_symbol);
+        put(e.begin_time);
+        put(e.end_time);
+        finish(start);
+    }
+
+    void add(const fee_event &e)
+    {
+        size_t start = begin(FEE);
+        put(e.liquidity_id);
+        put(e.swap_fee);
+        put(e.fund_fee);
+        put(e.divd_fee);
+        finish(start);
+    }
+
+    void add(const curve_event &e)
+    {
+        size_t start = begin(CURVE);
+        put(e.liquidity_id);
+        put_byte(e.kind);
+        put(e.param1);
+        put(e.param2);
+        finish(start);
+    }
+
+    std::vector<char> data = std::vector<char>(1, (char)VERSION);
+};
+
+// Reads events in place from a frame; ok() turns false on a truncated or
+// unknown frame and stays false.
+class reader
+{
+public:
+    reader(const char *data, size_t size) : pos(data), end(data + size), body(nullptr)
+    {
+        version = size > 0 ? (uint8_t)*pos++ : 0;
+        valid = version == 1 || version == VERSION;
+    }
+
+    bool ok() const { return valid; }
+    bool done() const { return !valid || (body ? body : pos) >= end; }
+
+    // type of the next event, to be followed by the matching read() or skip()
+    uint8_t next()
+    {
+        // fields left unread are newer than this reader
+        if (body)
+            pos = body;
+        body = nullptr;
+
+        uint8_t type = get_byte();
+        if (version > 1)
+        {
+            uint8_t size = get_byte();
+            if (end - pos < size)
+                valid = false;
+            else
+                body = pos + size;
+        }
+        return type;
+    }
+
+    void read(swap_event &e)
+    {
+        e.account = get_fixed();
+        e.third_id = get();
+        e.liquidity_id = get();
+        e.direction = get_byte();
+        e.in_amount = get();
+        e.out_amount = get();
+        e.fee_amount = get();
+    }
+
+    void read(liquidity_event &e)
+    {
+        e.account = get_fixed();
+        e.liquidity_id = get();
+        e.kind = get_byte();
+        e.amount1 = get();
+        e.amount2 = get();
+        e.liquidity_token = get();
+        e.balance1 = get();
+        e.balance2 = get();
+        e.balance_ltoken = get();
+    }
+
+    void read(newliquidity_event &e)
+    {
+        e.liquidity_id = get();
+        e.contract1 = get_fixed();
+        e.symbol1 = get_fixed();
+        e.contract2 = get_fixed();
+        e.symbol2 = get_fixed();
+    }
+
+    void read(weight_event &e)
+    {
+        e.liquidity_id = get();
+        e.kind = get_byte();
+        e.weight = get_float();
+    }
+
+    void read(market_event &e)
+    {
+        e.mine_id = get();
+        e.venue = get_fixed();
+        e.liquidity_id = get();
+        e.in_amount1 = get();
+        e.in_amount2 = get();
+        e.out_amount1 = get();
+        e.out_amount2 = get();
+        e.reward_amount = get();
+        e.reward_symbol = get_fixed();
+        e.begin_time = get();
+        e.end_time = get();
+    }
+
+    void read(fee_event &e)
+    {
+        e.liquidity_id = get();
+        e.swap_fee = get();
+        e.fund_fee = get();
+        e.divd_fee = get();
+    }
+
+    void read(curve_event &e)
+    {
+        e.liquidity_id = get();
+        e.kind = get_byte();
+        e.param1 = get();
+        e.param2 = get();
+    }
+
+    // skips the body of an event of the given type, next() steps over it in
+    // version 2; false if a version 1 frame holds a type this reader does not know
+    bool skip(uint8_t type)
+    {
+        if (version > 1)
+            return valid;
+
+        swap_event s;
+        liquidity_event l;
+        newliquidity_event n;
+        weight_event w;
+        market_event m;
+        fee_event f;
+        curve_event c;
+        switch (type)
+        {
+        case SWAP:
+            read(s);
+            return valid;
+        case LIQUIDITY:
+            read(l);
+            return valid;
+        case NEWLIQUIDITY:
+            read(n);
+            return valid;
+        case WEIGHT:
+            read(w);
+            return valid;
+        case MARKET:
+            read(m);
+            return valid;
+        case FEE:
+            read(f);
+            return valid;
+        case CURVE:
+            read(c);
+            return valid;
+        }
+        valid = false;
+        return false;
+    }
+
+private:
+    // fields of a version 2 event stop at its size
+    const char *limit() const { return body ? body : end; }
+
+    uint64_t get()
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (pos >= limit())
+                break;
+            uint8_t b = (uint8_t)*pos++;
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        valid = false;
+        return 0;
+    }
+
+    uint8_t get_byte()
+    {
+        if (pos >= limit())
+        {
+            valid = false;
+            return 0;
+        }
+        return (uint8_t)*pos++;
+    }
+
+    uint64_t get_fixed()
+    {
+        if (limit() - pos < 8)
+        {
+            valid = false;
+            pos = limit();
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++)
+            v |= (uint64_t)(uint8_t)pos[i] << (8 * i);
+        pos += 8;
+        return v;
+    }
+
+    float get_float()
+    {
+        float v = 0;
+        if (limit() - pos < 4)
+        {
+            valid = false;
+            pos = limit();
+            return v;
+        }
+        memcpy(&v, pos, 4);
+        pos += 4;
+        return v;
+    }
+
+    const char *pos;
+    const char *end;
+    const char *body; // end of the current event's fields, version 2 on
+    uint8_t version;
+    bool valid;
+};
+
+} // namespace events
@@ -8,27 +8,30 @@
 
 #define ONES_MINE_ACCOUNT "onesgamemine"
 #define ONES_PLAY_ACCOUNT "onesgameplay"
-#define ONES_LOG_ACCOUNT "onesgamelogs"
 
 #define DEFI_TYPE_LIQUIDITY 1
 #define DEFI_TYPE_SWAP 2
 #define DEFI_TYPE_PAIR 3
 
+#define DEFI_CURVE_PRODUCT 0
+#define DEFI_CURVE_RANGE 1
+#define DEFI_CURVE_STABLE 2
+
 #define ONES_FUND_ACCOUNT "onesgamefund"
 #define ONES_DIVD_ACCOUNT "onesgamedivd"
 
-#define BOX_DEFI_ACCOUNT "swap.defi"
-#define BOX_TOKEN_ACCOUNT "token.defi"
-#define BOX_LPTOKEN_ACCOUNT "lptoken.defi"
-#define BOX_TOKEN_SYMBOL symbol("BOX", 6)
+// permission onflash is sent with, linked to each callback's onflash only
+#define ONES_FLASH_PERMISSION "flash"
 
-#define DFS_DEFI_ACCOUNT "defisswapcnt"
-#define DFS_TOKEN_ACCOUNT "minedfstoken"
-#define DFS_TOKEN_SYMBOL symbol("DFS", 4)
+// default fees, in basis points
+const uint64_t ONES_SWAP_FEE = 10;
+const uint64_t ONES_FUND_FEE = 10;
+const uint64_t ONES_DIVD_FEE = 10;
+const uint64_t ONES_FEE_BASE = 10000;
+const uint64_t ONES_FEE_MAX = 1000;
 
-const float_t ONES_SWAP_FEE = 0.001;
-const float_t ONES_FUND_FEE = 0.001;
-const float_t ONES_DIVD_FEE = 0.001;
+// pools with an LP token symbol, "LP" and at most five letters
+const uint64_t LP_SYMBOL_IDS = 26 * 26 * 26 * 26 * 26;
 
 void onesgame::newliquidity(name account, token_t token1, token_t token2)
 {
@@ -62,16 +65,23 @@ void onesgame::newliquidity(name account, token_t token1, token_t token2)
         t.liquidity_id = liquidity_id;
         t.token1 = iseos ? token2 : token1;
         t.token2 = iseos ? token1 : token2;
+        t.reserve1 = 0;
+        t.reserve2 = 0;
         t.liquidity_token = 0;
         t.swap_weight = 0;
         t.liquidity_weight = 0;
         t.timestamp = now();
     });
 
-    eosio::action(eosio::permission_level{get_self(), "active"_n},
-                  eosio::name(ONES_LOG_ACCOUNT), "newliquidity"_n,
-                  make_tuple(liquidity_id, iseos ? token2 : token1,iseos ? token1 : token2))
-        .send();
+    const token_t &first = iseos ? token2 : token1;
+    const token_t &second = iseos ? token1 : token2;
+    _events.add(events::newliquidity_event{
+        .liquidity_id = liquidity_id,
+        .contract1 = first.address.value,
+        .symbol1 = first.symbol.raw(),
+        .contract2 = second.address.value,
+        .symbol2 = second.symbol.raw()});
+    _emit();
 
     eosio::action(eosio::permission_level{get_self(), "active"_n},
                   eosio::name(ONES_MINE_ACCOUNT), "newliquidity"_n,
@@ -123,11 +133,18 @@ void onesgame::transfer(name from, name to, asset quantity, string memo)
     eosio_assert(quantity.is_valid(), "invalid quantity");
     eosio_assert(quantity.amount > 0, "must transfer positive quantity");
 
-    if (from == name(BOX_DEFI_ACCOUNT) || from == name(BOX_LPTOKEN_ACCOUNT))
-        return _handle_box(from, to, quantity, memo);
+    tb_market_sender _market_sender(get_self(), get_self().value);
+    auto sender = _market_sender.find(from.value);
+    if (sender != _market_sender.end())
+    {
+        tb_market_venue _market_venue(get_self(), get_self().value);
+        return _handle_venue(_market_venue.get(sender->venue.value, "venue does not exist"), from, quantity, memo);
+    }
 
-    if (from == name(DFS_DEFI_ACCOUNT) || from == name(DFS_TOKEN_ACCOUNT))
-        return _handle_dfs(from, to, quantity, memo);
+    // mining rewards of this contract: the claim vaultclaim sends pays the vaults'
+    // liquidity, swaps the vaults make themselves are airdropped as they happen
+    if (from == name(ONES_MINE_ACCOUNT) && (memo == "market mine" || memo == "swap mine"))
+        return this->_vaultmined(quantity);
 
     std::vector<std::string> params;
     utils::split(memo, ',', params);
@@ -141,14 +158,22 @@ void onesgame::transfer(name from, name to, asset quantity, string memo)
         return this->swap(from, quantity, params);
     if (action == "addliquidity")
         return this->_addliquidity(from, to, quantity, memo);
-
-    if (action != "marketsettle")
-        return this->_transfer_to(name(ONES_PLAY_ACCOUNT), this->code, quantity, memo);
+    if (action == "zap")
+        return this->_zapin(from, quantity, params);
+    if (action == "flashrepay")
+        return this->_flashrepay(quantity, params);
+    if (action == "marketsettle")
+        return this->_marketcredit(quantity, params);
+    if (action == "vault")
+        return this->_vaultdeposit(from, quantity, params);
+    if (action == "vaultreward")
+        return this->_vaultreward(from, quantity, params);
+
+    return this->_transfer_to(name(ONES_PLAY_ACCOUNT), this->code, quantity, memo);
 }
 
-void onesgame::_swaplog(name account, uint64_t third_id, uint64_t liquidity_id,
-                        token_t in_token, token_t out_token, asset in_asset,
-                        asset out_asset, asset fee, float_t price)
+void onesgame::_swaplog(name account, uint64_t third_id, uint64_t liquidity_id, uint8_t direction,
+                        asset in_asset, asset out_asset, asset fee)
 {
 
     uint64_t swap_id = this->_get_swap_id();
@@ -166,71 +191,72 @@ void onesgame::_swaplog(name account, uint64_t third_id, uint64_t liquidity_id,
         t.third_id = third_id;
         t.account = account;
         t.liquidity_id = liquidity_id;
-        t.in_token = in_token;
-        t.out_token = out_token;
-        t.in_asset = in_asset;
-        t.out_asset = out_asset;
-        t.price = price;
-        t.trx_id = _get_trx_id();
+        t.direction = direction;
+        t.in_amount = in_asset.amount;
+        t.out_amount = out_asset.amount;
         t.timestamp = now();
     });
 
-    eosio::action(eosio::permission_level{get_self(), "active"_n},
-                  eosio::name(ONES_LOG_ACCOUNT), "swaplog"_n,
-                  make_tuple(account, third_id, liquidity_id,
-                             in_token, out_token, in_asset, out_asset, fee, price))
-        .send();
+    _events.add(events::swap_event{
+        .account = account.value,
+        .third_id = third_id,
+        .liquidity_id = liquidity_id,
+        .direction = direction,
+        .in_amount = (uint64_t)in_asset.amount,
+        .out_amount = (uint64_t)out_asset.amount,
+        .fee_amount = (uint64_t)fee.amount});
 }
 
 void onesgame::_liquiditylog(name account, uint64_t liquidity_id, string type,
-                             token_t in_token, token_t out_token,
                              asset in_asset, asset out_asset, uint64_t liquidity_token,
                              asset in_balance, asset out_balance, uint64_t balance_ltoken)
 {
+    _events.add(events::liquidity_event{
+        .account = account.value,
+        .liquidity_id = liquidity_id,
+        .kind = type == "deposit" ? events::DEPOSIT : events::WITHDRAW,
+        .amount1 = (uint64_t)in_asset.amount,
+        .amount2 = (uint64_t)out_asset.amount,
+        .liquidity_token = liquidity_token,
+        .balance1 = (uint64_t)in_balance.amount,
+        .balance2 = (uint64_t)out_balance.amount,
+        .balance_ltoken = balance_ltoken});
+}
 
-    eosio::action(eosio::permission_level{get_self(), "active"_n},
-                  eosio::name(ONES_LOG_ACCOUNT), "liquiditylog"_n,
-                  make_tuple(account, liquidity_id, type,
-                             in_token, out_token, in_asset, out_asset, liquidity_token,
-                             in_balance, out_balance, balance_ltoken))
-        .send();
+// sends everything logged by the current action as one event notification
+void onesgame::_emit()
+{
+    if (_events.empty())
+        return;
 
     eosio::action(eosio::permission_level{get_self(), "active"_n},
-                  eosio::name(ONES_MINE_ACCOUNT), "liquiditylog"_n,
-                  make_tuple(account, liquidity_id, type,
-                             in_token, out_token, in_asset, out_asset, liquidity_token,
-                             in_balance, out_balance, balance_ltoken))
+                  get_self(), "event"_n, make_tuple(_events.data))
         .send();
+    _events.clear();
 }
 
-checksum256 onesgame::_get_trx_id()
+void onesgame::event(std::vector<char>)
 {
-    auto tx_size = transaction_size();
-    char tx[tx_size];
-    auto read_size = read_transaction(tx, tx_size);
-    eosio_assert(tx_size == read_size, "read_transaction failed");
-    auto trx = unpack<transaction>(tx, read_size);
-
-    return sha256(tx, tx_size);
+    require_auth(get_self());
 }
 
-std::vector<eosio::action> onesgame::_get_actions()
+checksum256 onesgame::_get_trx_id()
 {
     auto tx_size = transaction_size();
     char tx[tx_size];
     auto read_size = read_transaction(tx, tx_size);
-    eosio_assert(tx_size == read_size, "read_transaction failed");
+    eosio_assert(tx_size == (size_t)read_size, "read_transaction failed");
     auto trx = unpack<transaction>(tx, read_size);
 
-    return trx.actions;
+    return sha256(tx, tx_size);
 }
+
 void onesgame::swap(name account, asset quantity, std::vector<std::string> &params)
 {
     eosio_assert(params.size() == 4, "invalid memo");
 
     std::vector<std::string> liquidity_ids;
     utils::split(params.at(3), '-', liquidity_ids);
-    uint64_t liquidity_id = 0;
     uint64_t third_id = atoll(params.at(1).c_str());
 
     uint64_t slippage = atoll(params.at(2).c_str());
@@ -239,92 +265,162 @@ void onesgame::swap(name account, asset quantity, std::vector<std::string> &para
     swapdata.quantity = quantity;
     swapdata.code = this->code;
 
+    swapdata = this->_route(account, swapdata, liquidity_ids, slippage, third_id);
+
+    this->_transfer_to(account, swapdata.code, swapdata.quantity, "swap");
+    _emit();
+}
+
+// swaps through each pool of liquidity_ids in turn, charging the fund and divd fees per hop
+onesgame::swap_t onesgame::_route(name account, swap_t swapdata, const std::vector<std::string> &liquidity_ids,
+                                  uint64_t slippage, uint64_t third_id)
+{
     for (uint64_t i = 0; i < liquidity_ids.size(); i++)
     {
-        swapdata.original_quantity =
-            asset(swapdata.quantity.amount, swapdata.quantity.symbol);
+        swapdata = this->_hop(account, swapdata, atoll(liquidity_ids.at(i).c_str()), slippage, third_id);
+    }
 
-        asset fund_fee = asset(swapdata.quantity.amount * ONES_FUND_FEE, swapdata.quantity.symbol);
-        this->_transfer_to(name(ONES_FUND_ACCOUNT), swapdata.code, fund_fee, "swap fund fee");
+    return swapdata;
+}
 
-        asset divd_fee = asset(swapdata.quantity.amount * ONES_DIVD_FEE, swapdata.quantity.symbol);
-        this->_transfer_to(name(ONES_DIVD_ACCOUNT), swapdata.code, divd_fee, "swap divd fee");
+// one hop of a route: the fund and divd fees come off the input before the pool swap
+onesgame::swap_t onesgame::_hop(name account, swap_t swapdata, uint64_t liquidity_id,
+                                uint64_t slippage, uint64_t third_id)
+{
+    swapdata.original_quantity =
+        asset(swapdata.quantity.amount, swapdata.quantity.symbol);
 
-        swapdata.quantity.amount -= swapdata.quantity.amount * ONES_FUND_FEE;
-        swapdata.quantity.amount -= swapdata.quantity.amount * ONES_DIVD_FEE;
+    st_defi_fee fee = _get_fee(liquidity_id);
 
-        liquidity_id = atoll(liquidity_ids.at(i).c_str());
-        swapdata = this->_swap(account, swapdata, liquidity_id, slippage, third_id);
-    }
+    asset fund_fee = asset((uint128_t)swapdata.quantity.amount * fee.fund_fee / ONES_FEE_BASE, swapdata.quantity.symbol);
+    this->_transfer_to(name(ONES_FUND_ACCOUNT), swapdata.code, fund_fee, "swap fund fee");
 
-    this->_transfer_to(account, swapdata.code, swapdata.quantity, "swap");
+    asset divd_fee = asset((uint128_t)swapdata.quantity.amount * fee.divd_fee / ONES_FEE_BASE, swapdata.quantity.symbol);
+    this->_transfer_to(name(ONES_DIVD_ACCOUNT), swapdata.code, divd_fee, "swap divd fee");
+
+    swapdata.quantity -= fund_fee;
+    swapdata.quantity -= divd_fee;
+
+    return this->_swap(account, swapdata, liquidity_id, slippage, third_id, fee);
+}
+
+// memo "zap,<liquidity_id>,<min_lp>" with either pool token: liquidity from a single
+// transfer, what the pool ratio leaves over is refunded
+void onesgame::_zapin(name account, asset quantity, std::vector<std::string> &params)
+{
+    eosio_assert(params.size() == 3, "invalid memo");
+    uint64_t liquidity_id = atoll(params.at(1).c_str());
+    uint64_t min_lp = atoll(params.at(2).c_str());
+
+    swap_t in;
+    in.quantity = quantity;
+    in.code = this->code;
+    zap_t zap = this->_zap(account, liquidity_id, in);
+    eosio_assert(zap.liquidity_token >= min_lp, "liquidity below min_lp");
+
+    this->_transfer_to(account, zap.token1, zap.left1, "refund");
+    this->_transfer_to(account, zap.token2, zap.left2, "refund");
+    _emit();
+}
+
+// part of amount to swap into a constant product pool holding reserve of the same
+// token, so that what remains and the swap output are in the pool ratio afterwards:
+// s = (sqrt(r^2 (2 - f)^2 + 4 (1 - f) a r) - r (2 - f)) / (2 (1 - f))
+uint64_t onesgame::_zap_amount(uint64_t reserve, uint64_t amount, uint64_t fee)
+{
+    double f = 1.0 * fee / ONES_FEE_BASE;
+    double r = reserve;
+    double b = r * (2 - f);
+    double s = (std::sqrt(b * b + 4 * (1 - f) * amount * r) - b) / (2 * (1 - f));
+    return s < amount ? (uint64_t)s : amount;
+}
+
+// swaps the zap amount of in through the pool and mints liquidity for account
+// from the rest and the output; stable and range pools use the same split, any
+// difference ends up in the leftovers
+onesgame::zap_t onesgame::_zap(name account, uint64_t liquidity_id, swap_t in)
+{
+    auto it = _defi_liquidity.find(liquidity_id);
+    eosio_assert(it != _defi_liquidity.end(), "Liquidity does not exist");
+    eosio_assert(it->liquidity_token > 0, "Liquidity is empty");
+
+    bool in_token1 = in.code == it->token1.address.value && in.quantity.symbol == it->token1.symbol;
+    bool in_token2 = in.code == it->token2.address.value && in.quantity.symbol == it->token2.symbol;
+    eosio_assert(in_token1 || in_token2, "token address error");
+
+    st_defi_fee fee = _get_fee(liquidity_id);
+    swap_t part;
+    part.code = in.code;
+    part.quantity = asset(_zap_amount(in_token1 ? it->quantity1().amount : it->quantity2().amount,
+                                      in.quantity.amount, fee.swap_fee + fee.fund_fee + fee.divd_fee),
+                          in.quantity.symbol);
+    // min_lp bounds the price, the per hop slippage check is left open
+    swap_t out = this->_hop(account, part, liquidity_id, 100, 0);
+
+    zap_t zap;
+    zap.token1 = it->token1.address.value;
+    zap.token2 = it->token2.address.value;
+    asset quantity1 = in_token1 ? in.quantity - part.quantity : out.quantity;
+    asset quantity2 = in_token1 ? out.quantity : in.quantity - part.quantity;
+    zap.left1 = quantity1;
+    zap.left2 = quantity2;
+    zap.liquidity_token = this->_mint(account, liquidity_id, zap.left1, zap.left2, false);
+    zap.left1 = quantity1 - zap.left1;
+    zap.left2 = quantity2 - zap.left2;
+    return zap;
 }
 
 onesgame::swap_t onesgame::_swap(name account, swap_t &in,
-                                 uint64_t liquidity_id, uint64_t slippage, uint64_t third_id)
+                                 uint64_t liquidity_id, uint64_t slippage, uint64_t third_id,
+                                 const st_defi_fee &fee)
 {
     auto it = _defi_liquidity.find(liquidity_id);
     eosio_assert(it != _defi_liquidity.end(), "Liquidity does not exist");
+    _check_flash(liquidity_id);
 
     onesgame::swap_t out;
 
-    token_t token1, token2;
+    uint8_t direction = 0;
+    st_defi_curve curve = _get_curve(liquidity_id);
+    curve::u128 d = 0;
 
     eosio_assert(in.code == it->token1.address.value || in.code == it->token2.address.value, "token address error");
 
     if (in.code == it->token1.address.value && in.quantity.symbol == it->token1.symbol)
     {
-        token1 = it->token1;
-        token2 = it->token2;
-        float_t alpha = (1.0 * in.quantity.amount) / it->quantity1.amount;
-        float_t r = 1 - ONES_SWAP_FEE;
-        uint64_t amount = (1.0 * (alpha * r) / (1 + alpha * r)) * it->quantity2.amount;
+        direction = 1;
+        uint64_t amount = _get_amount_out(*it, curve, true, in.quantity, fee.swap_fee, d);
 
-        out.quantity = asset(amount, it->quantity2.symbol);
+        out.quantity = asset(amount, it->quantity2().symbol);
         out.code = it->token2.address.value;
 
-        asset quantity1 = it->quantity1 + in.quantity;
-        asset quantity2 = it->quantity2 - out.quantity;
+        asset quantity1 = it->quantity1() + in.quantity;
+        asset quantity2 = it->quantity2() - out.quantity;
 
         uint64_t p1 = std::pow(10, quantity1.symbol.precision());
         uint64_t p2 = std::pow(10, quantity2.symbol.precision());
 
-        float curslippage = 1 - ((1.0 * out.quantity.amount / p2) / (1.0 * in.quantity.amount / p1)) / (it->price1);
+        float curslippage = 1 - ((1.0 * out.quantity.amount / p2) / (1.0 * in.quantity.amount / p1)) / _get_price(*it, curve, d);
         eosio_assert((slippage / 100.0) > curslippage, ("slippage exceed default " + std::to_string(curslippage)).c_str());
 
         _defi_liquidity.modify(it, _self, [&](auto &t) {
-            t.quantity1 += in.quantity;
-            t.quantity2 -= out.quantity;
-            t.price1 = (1.0 * quantity2.amount / p2) / ((1.0 * quantity1.amount) / p1);
-            t.price2 = (1.0 * quantity1.amount / p1) / ((1.0 * quantity2.amount) / p2);
+            t.reserve1 += in.quantity.amount;
+            t.reserve2 -= out.quantity.amount;
         });
     }
     else if (in.code == it->token2.address.value && in.quantity.symbol == it->token2.symbol)
     {
-        token1 = it->token2;
-        token2 = it->token1;
-
-        float_t alpha = (1.0 * in.quantity.amount) / it->quantity2.amount;
-        float_t r = 1 - ONES_SWAP_FEE;
-        uint64_t amount = (((alpha * r) / (1 + alpha * r)) * it->quantity1.amount);
-        out.quantity = asset(amount, it->quantity1.symbol);
+        direction = 2;
+        uint64_t amount = _get_amount_out(*it, curve, false, in.quantity, fee.swap_fee, d);
+        out.quantity = asset(amount, it->quantity1().symbol);
         out.code = it->token1.address.value;
 
-        asset quantity1 = it->quantity1 - out.quantity;
-        asset quantity2 = it->quantity2 + in.quantity;
-
-        uint64_t p1 = std::pow(10, quantity1.symbol.precision());
-        uint64_t p2 = std::pow(10, quantity2.symbol.precision());
-
-        float curslippage = 1 - ((1.0 * out.quantity.amount / std::pow(10, out.quantity.symbol.precision())) / (1.0 * in.quantity.amount / std::pow(10, in.quantity.symbol.precision())) / (it->price2));
+        float curslippage = 1 - ((1.0 * out.quantity.amount / std::pow(10, out.quantity.symbol.precision())) / (1.0 * in.quantity.amount / std::pow(10, in.quantity.symbol.precision())) * _get_price(*it, curve, d));
         eosio_assert((slippage / 100.0) > curslippage, ("slippage exceed default" + std::to_string(curslippage)).c_str());
 
         _defi_liquidity.modify(it, _self, [&](auto &t) {
-            t.quantity1 -= out.quantity;
-            t.quantity2 += in.quantity;
-
-            t.price1 = (1.0 * quantity2.amount / p2) / ((1.0 * quantity1.amount) / p1);
-            t.price2 = (1.0 * quantity1.amount / p1) / ((1.0 * quantity2.amount) / p2);
+            t.reserve1 -= out.quantity.amount;
+            t.reserve2 += in.quantity.amount;
         });
     }
     else
@@ -332,28 +428,181 @@ onesgame::swap_t onesgame::_swap(name account, swap_t &in,
         eosio_assert(false, "token address error");
     }
 
-    uint64_t p1 = std::pow(10, in.quantity.symbol.precision());
-    uint64_t p2 = std::pow(10, out.quantity.symbol.precision());
-
-    float_t price = (1.0 * out.quantity.amount / p2) / (1.0 * in.original_quantity.amount / p1);
-    asset fee(in.original_quantity.amount *
-                  (ONES_DIVD_FEE + ONES_FUND_FEE + ONES_SWAP_FEE),
-              in.quantity.symbol);
+    asset fee_quantity((uint128_t)in.original_quantity.amount *
+                           (fee.divd_fee + fee.fund_fee + fee.swap_fee) / ONES_FEE_BASE,
+                       in.quantity.symbol);
 
-    this->_swaplog(account, third_id, liquidity_id, token1, token2,
-                   in.original_quantity, out.quantity, fee, price);
+    this->_swaplog(account, third_id, liquidity_id, direction,
+                   in.original_quantity, out.quantity, fee_quantity);
 
     this->swapmine(account, in.code, in.original_quantity, liquidity_id);
     return out;
 }
 
+onesgame::st_defi_curve onesgame::_get_curve(uint64_t liquidity_id)
+{
+    tb_defi_curve _defi_curve(_self, _self.value);
+
+    auto it = _defi_curve.find(liquidity_id);
+    if (it == _defi_curve.end())
+        return st_defi_curve{.liquidity_id = liquidity_id, .kind = DEFI_CURVE_PRODUCT, .param1 = 0, .param2 = 0};
+
+    return *it;
+}
+
+onesgame::st_defi_fee onesgame::_get_fee(uint64_t liquidity_id)
+{
+    tb_defi_fee _defi_fee(_self, _self.value);
+
+    auto it = _defi_fee.find(liquidity_id);
+    if (it == _defi_fee.end())
+        return st_defi_fee{.liquidity_id = liquidity_id,
+                           .swap_fee = ONES_SWAP_FEE,
+                           .fund_fee = ONES_FUND_FEE,
+                           .divd_fee = ONES_DIVD_FEE};
+
+    return *it;
+}
+
+uint64_t onesgame::_get_amount_out(const st_defi_liquidity &liquidity, const st_defi_curve &curve,
+                                   bool in_token1, const asset &in_quantity, uint64_t swap_fee, curve::u128 &d)
+{
+    const asset &reserve_in = in_token1 ? liquidity.quantity1() : liquidity.quantity2();
+    const asset &reserve_out = in_token1 ? liquidity.quantity2() : liquidity.quantity1();
+
+    if (curve.kind == DEFI_CURVE_RANGE)
+    {
+        curve::range_t range = _get_range(liquidity, curve, liquidity.quantity1(), liquidity.quantity2());
+        uint128_t x = (uint128_t)reserve_in.amount + (in_token1 ? range.a : range.b);
+        uint128_t y = (uint128_t)reserve_out.amount + (in_token1 ? range.b : range.a);
+        uint128_t in = (uint128_t)in_quantity.amount * (ONES_FEE_BASE - swap_fee);
+
+        uint64_t amount = in * y / (x * ONES_FEE_BASE + in);
+        eosio_assert(amount < (uint64_t)reserve_out.amount, "swap exceeds price range");
+        return amount;
+    }
+
+    if (curve.kind == DEFI_CURVE_STABLE)
+    {
+        uint64_t rate1, rate2;
+        _get_rates(liquidity, rate1, rate2);
+        uint64_t rate_in = in_token1 ? rate1 : rate2;
+        uint64_t rate_out = in_token1 ? rate2 : rate1;
+
+        d = _get_stable_d(liquidity, curve, liquidity.quantity1(), liquidity.quantity2());
+        int64_t in = in_quantity.amount - (uint128_t)in_quantity.amount * swap_fee / ONES_FEE_BASE;
+        curve::u128 x = (curve::u128)(reserve_in.amount + in) * rate_in;
+        curve::u128 y = (curve::u128)reserve_out.amount * rate_out;
+        eosio_assert(curve::stable_bounded(x, y), "stable pool out of bounds");
+
+        curve::u128 new_y = curve::stable_y(x, d, curve.param1);
+        eosio_assert(new_y > 0, "stable curve did not converge");
+
+        if (new_y + 1 >= y)
+            return 0;
+        uint64_t amount = (y - new_y - 1) / rate_out;
+        eosio_assert(amount < (uint64_t)reserve_out.amount, "swap exceeds reserve");
+        eosio_assert(curve::stable_bounded(x, y - (curve::u128)amount * rate_out), "swap leaves the stable pool's bounds");
+        return amount;
+    }
+
+    uint128_t in = (uint128_t)in_quantity.amount * (ONES_FEE_BASE - swap_fee);
+    return in * reserve_out.amount / ((uint128_t)reserve_in.amount * ONES_FEE_BASE + in);
+}
+
+curve::range_t onesgame::_get_range(const st_defi_liquidity &liquidity, const st_defi_curve &curve,
+                                    const asset &quantity1, const asset &quantity2)
+{
+    double p1 = std::pow(10, liquidity.token1.symbol.precision());
+    double p2 = std::pow(10, liquidity.token2.symbol.precision());
+
+    return curve::range_offsets(quantity1.amount, quantity2.amount,
+                                curve.param1 / 1e8 * p2 / p1, curve.param2 / 1e8 * p2 / p1);
+}
+
+// both reserves scaled to the larger of the two precisions
+void onesgame::_get_rates(const st_defi_liquidity &liquidity, uint64_t &rate1, uint64_t &rate2)
+{
+    uint8_t precision1 = liquidity.token1.symbol.precision();
+    uint8_t precision2 = liquidity.token2.symbol.precision();
+
+    rate1 = std::pow(10, precision1 < precision2 ? precision2 - precision1 : 0);
+    rate2 = std::pow(10, precision2 < precision1 ? precision1 - precision2 : 0);
+}
+
+curve::u128 onesgame::_get_stable_d(const st_defi_liquidity &liquidity, const st_defi_curve &curve,
+                                    const asset &quantity1, const asset &quantity2)
+{
+    uint64_t rate1, rate2;
+    _get_rates(liquidity, rate1, rate2);
+
+    curve::u128 x = (curve::u128)quantity1.amount * rate1;
+    curve::u128 y = (curve::u128)quantity2.amount * rate2;
+    eosio_assert(curve::stable_bounded(x, y), "stable pool out of bounds");
+
+    curve::u128 d = curve::stable_d(x, y, curve.param1);
+    eosio_assert(d > 0, "stable curve did not converge");
+    return d;
+}
+
+// spot price of token1 in token2 from the reserves, in whole tokens
+double onesgame::_get_price(const st_defi_liquidity &liquidity, const st_defi_curve &curve, curve::u128 d)
+{
+    if (liquidity.reserve1 <= 0 || liquidity.reserve2 <= 0)
+    {
+        return 0;
+    }
+
+    double p1 = std::pow(10, liquidity.token1.symbol.precision());
+    double p2 = std::pow(10, liquidity.token2.symbol.precision());
+    double x = liquidity.reserve1;
+    double y = liquidity.reserve2;
+
+    if (curve.kind == DEFI_CURVE_RANGE)
+    {
+        curve::range_t range = _get_range(liquidity, curve, liquidity.quantity1(), liquidity.quantity2());
+        x += range.a;
+        y += range.b;
+    }
+
+    if (curve.kind == DEFI_CURVE_STABLE)
+    {
+        uint64_t rate1, rate2;
+        _get_rates(liquidity, rate1, rate2);
+
+        if (d == 0)
+            d = _get_stable_d(liquidity, curve, liquidity.quantity1(), liquidity.quantity2());
+        double price = curve::stable_price(x * rate1, y * rate2, d, curve.param1);
+
+        return price * rate1 / rate2 * p1 / p2;
+    }
+
+    return (y / p2) / (x / p1);
+}
+
 void onesgame::addliquidity(name account, uint64_t liquidity_id)
 {
     require_auth(account);
 
+    _addliq(account, liquidity_id, 0, true);
+}
+
+// addliquidity without the 10% surplus limit: the surplus is refunded and the
+// action fails below min_lp or past deadline (seconds)
+void onesgame::addliqmin(name account, uint64_t liquidity_id, uint64_t min_lp, uint32_t deadline)
+{
+    require_auth(account);
+    eosio_assert(now() <= deadline, "deadline exceeded");
+
+    _addliq(account, liquidity_id, min_lp, false);
+}
+
+void onesgame::_addliq(name account, uint64_t liquidity_id, uint64_t min_lp, bool capped)
+{
     auto defi_liquidity = _defi_liquidity.find(liquidity_id);
 
     eosio_assert(defi_liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+    _check_flash(liquidity_id);
 
     tb_defi_transfers _defi_transfer(_self, _self.value);
     checksum256 trx_id = this->_get_trx_id();
@@ -369,7 +618,7 @@ void onesgame::addliquidity(name account, uint64_t liquidity_id)
     std::vector<std::string> params1;
     utils::split(transfer_data1.memo, ',', params1);
 
-    eosio_assert(atoll(params1[1].c_str()) == liquidity_id, "Invalid add liquidity.");
+    eosio_assert((uint64_t)atoll(params1[1].c_str()) == liquidity_id, "Invalid add liquidity.");
 
     token_t token1 = defi_liquidity->token1;
     token_t token2 = defi_liquidity->token2;
@@ -392,59 +641,74 @@ void onesgame::addliquidity(name account, uint64_t liquidity_id)
     eosio_assert(quantity1.symbol == token1.symbol, "You need transfer both tokens");
     eosio_assert(quantity2.symbol == token2.symbol, "You need transfer both tokens");
 
-    uint64_t pool_id = this->_get_pool_id();
+    asset deposit1 = quantity1;
+    asset deposit2 = quantity2;
+    uint64_t minted = this->_mint(account, liquidity_id, deposit1, deposit2, capped);
+    eosio_assert(minted >= min_lp, "liquidity below min_lp");
 
-    uint64_t myliquidity_token = 0;
-    uint64_t liquidity_token = defi_liquidity->liquidity_token;
+    this->_transfer_to(account, token1.address.value, quantity1 - deposit1, "refund");
+    this->_transfer_to(account, token2.address.value, quantity2 - deposit2, "refund");
 
-    uint64_t hasSurplus = 0;
-    asset surplusQuantity;
+    _defi_transfer.erase(defi_transfer);
+    _emit();
+}
+
+// Mints liquidity for account from quantity1 and quantity2. Any part off the
+// pool ratio is left out: on return the quantities hold what was deposited.
+// capped keeps the 10% limit on that part for callers without their own bound.
+uint64_t onesgame::_mint(name account, uint64_t liquidity_id, asset &quantity1, asset &quantity2, bool capped)
+{
+    auto defi_liquidity = _defi_liquidity.find(liquidity_id);
+    eosio_assert(defi_liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+    _check_flash(liquidity_id);
 
-    uint64_t p1 = std::pow(10, quantity1.symbol.precision());
-    uint64_t p2 = std::pow(10, quantity2.symbol.precision());
+    // config.pool_id counts deposits
+    this->_get_pool_id();
 
-    float_t a1 = (1.0 * quantity1.amount) / p1;
-    float_t a2 = (1.0 * quantity2.amount) / p2;
+    uint64_t myliquidity_token = 0;
+    uint64_t liquidity_token = defi_liquidity->liquidity_token;
 
-    uint64_t precision = p1 - p2;
-    precision = precision > 0 ? precision : 0 - precision;
-    precision = std::pow(10, precision);
+    asset surplusQuantity;
 
     if (liquidity_token == 0)
     {
-        myliquidity_token = std::pow(quantity1.amount * quantity2.amount, 0.5);
+        myliquidity_token = curve::isqrt((uint128_t)quantity1.amount * quantity2.amount);
     }
     else
     {
-        float_t price = defi_liquidity->price1;
-        if ((price * a1) > a2)
+        uint128_t value1 = (uint128_t)quantity1.amount * defi_liquidity->quantity2().amount;
+        uint128_t value2 = (uint128_t)quantity2.amount * defi_liquidity->quantity1().amount;
+        if (value1 > value2)
         {
-            hasSurplus = 1;
-            uint64_t a = (a1 - a2 / price) * p1;
-            surplusQuantity = asset(a, quantity1.symbol);
+            surplusQuantity = quantity1 - asset(value2 / defi_liquidity->quantity2().amount, quantity1.symbol);
             quantity1 -= surplusQuantity;
-
-            float curslippage = 1.0 * surplusQuantity.amount / quantity1.amount;
-            eosio_assert(curslippage < 0.1, "slippage exceed default 0.10");
+            eosio_assert(!capped || surplusQuantity.amount * 10 < quantity1.amount, "slippage exceed default 0.10");
         }
-        else if ((price * a1) < a2)
+        else if (value1 < value2)
         {
-            hasSurplus = 2;
-            uint64_t a = (a2 - a1 * price) * p2;
-            surplusQuantity = asset(a, quantity2.symbol);
+            surplusQuantity = quantity2 - asset(value1 / defi_liquidity->quantity1().amount, quantity2.symbol);
             quantity2 -= surplusQuantity;
-
-            float curslippage = 1.0 * surplusQuantity.amount / quantity2.amount;
-            eosio_assert(curslippage < 0.1, "slippage exceed default 0.10");
+            eosio_assert(!capped || surplusQuantity.amount * 10 < quantity2.amount, "slippage exceed default 0.10");
         }
 
-        float_t alpha = (1.00 * quantity1.amount) /
-                        (quantity1.amount + defi_liquidity->quantity1.amount);
-        myliquidity_token =
-            (alpha / (1 - alpha)) * defi_liquidity->liquidity_token;
+        uint64_t liquidity_token1 = (uint128_t)quantity1.amount * liquidity_token / defi_liquidity->quantity1().amount;
+        uint64_t liquidity_token2 = (uint128_t)quantity2.amount * liquidity_token / defi_liquidity->quantity2().amount;
+        myliquidity_token = std::min(liquidity_token1, liquidity_token2);
     }
+    eosio_assert(myliquidity_token > 0, "Zero");
     liquidity_token += myliquidity_token;
 
+    // the rounding of small deposits would otherwise walk a stable pool off its curve
+    if (_get_curve(liquidity_id).kind == DEFI_CURVE_STABLE)
+    {
+        uint64_t rate1, rate2;
+        _get_rates(*defi_liquidity, rate1, rate2);
+        int64_t reserve1 = (defi_liquidity->liquidity_token == 0 ? 0 : defi_liquidity->reserve1) + quantity1.amount;
+        int64_t reserve2 = (defi_liquidity->liquidity_token == 0 ? 0 : defi_liquidity->reserve2) + quantity2.amount;
+        eosio_assert(curve::stable_bounded((curve::u128)reserve1 * rate1, (curve::u128)reserve2 * rate2),
+                     "deposit leaves the stable pool's bounds");
+    }
+
     tb_defi_pools pool_index(get_self(), liquidity_id);
     auto pool_itr = pool_index.find(account.value);
 
@@ -481,36 +745,26 @@ void onesgame::addliquidity(name account, uint64_t liquidity_id)
     if (defi_liquidity->liquidity_token == 0)
     {
         _defi_liquidity.modify(defi_liquidity, _self, [&](auto &t) {
-            t.quantity1 = quantity1;
-            t.quantity2 = quantity2;
-            t.price1 = (1.0 * quantity2.amount / p2) / ((1.0 * quantity1.amount) / p1);
-            t.price2 = (1.0 * quantity1.amount / p1) / ((1.0 * quantity2.amount) / p2);
+            t.reserve1 = quantity1.amount;
+            t.reserve2 = quantity2.amount;
             t.liquidity_token = liquidity_token;
         });
     }
     else
     {
         _defi_liquidity.modify(defi_liquidity, _self, [&](auto &t) {
-            t.quantity1 += quantity1;
-            t.quantity2 += quantity2;
+            t.reserve1 += quantity1.amount;
+            t.reserve2 += quantity2.amount;
             t.liquidity_token = liquidity_token;
         });
     }
 
-    this->_liquiditylog(account, liquidity_id, "deposit", token1, token2,
+    this->_liquiditylog(account, liquidity_id, "deposit",
                         quantity1, quantity2, myliquidity_token,
                         in_balance, out_balance, balance_ltoken);
 
-    if (hasSurplus == 1)
-    {
-        this->_transfer_to(account, defi_liquidity->token1.address.value, surplusQuantity, "refund");
-    }
-    else if (hasSurplus == 2)
-    {
-        this->_transfer_to(account, defi_liquidity->token2.address.value, surplusQuantity, "refund");
-    }
+    return myliquidity_token;
 
-    _defi_transfer.erase(defi_transfer);
 }
 
 void onesgame::_addliquidity(name from, name to, asset quantity, string memo)
@@ -564,13 +818,24 @@ void onesgame::subliquidity(name account, uint64_t liquidity_id, uint64_t liquid
 {
     require_auth(account);
 
-    _subliquidity(account, liquidity_id, liquidity_token, false);
+    _subliquidity(account, liquidity_id, liquidity_token, false, account, 0, 0);
+}
+
+void onesgame::subliqmin(name account, uint64_t liquidity_id, uint64_t liquidity_token,
+                         uint64_t min_amount1, uint64_t min_amount2, uint32_t deadline)
+{
+    require_auth(account);
+    eosio_assert(now() <= deadline, "deadline exceeded");
+
+    _subliquidity(account, liquidity_id, liquidity_token, false, account, min_amount1, min_amount2);
 }
 
-void onesgame::_subliquidity(name account, uint64_t liquidity_id, uint64_t liquidity_token, bool is_reserve)
+void onesgame::_subliquidity(name account, uint64_t liquidity_id, uint64_t liquidity_token, bool is_reserve,
+                             name receiver, uint64_t min_amount1, uint64_t min_amount2)
 {
     auto defi_liquidity = _defi_liquidity.find(liquidity_id);
     eosio_assert(defi_liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+    _check_flash(liquidity_id);
 
     tb_defi_pools pool_index(get_self(), liquidity_id);
     auto pool_itr = pool_index.find(account.value);
@@ -578,14 +843,15 @@ void onesgame::_subliquidity(name account, uint64_t liquidity_id, uint64_t liqui
     eosio_assert(pool_itr != pool_index.end(), "User liquidity does not exist.");
     eosio_assert(pool_itr->liquidity_token >= liquidity_token, "Insufficient liquidity");
 
-    uint64_t amount1 = (1.00 * liquidity_token / defi_liquidity->liquidity_token) *
-                       defi_liquidity->quantity1.amount;
-    uint64_t amount2 = (1.00 * liquidity_token / defi_liquidity->liquidity_token) *
-                       defi_liquidity->quantity2.amount;
+    uint64_t amount1 = (uint128_t)liquidity_token * defi_liquidity->quantity1().amount /
+                       defi_liquidity->liquidity_token;
+    uint64_t amount2 = (uint128_t)liquidity_token * defi_liquidity->quantity2().amount /
+                       defi_liquidity->liquidity_token;
 
     asset quantity1(amount1, pool_itr->quantity1.symbol);
     asset quantity2(amount2, pool_itr->quantity2.symbol);
     eosio_assert(amount1 > 0 && amount2 > 0, "Zero");
+    eosio_assert(amount1 >= min_amount1 && amount2 >= min_amount2, "amount below minimum");
 
     asset in_balance = asset(0, quantity1.symbol);
     asset out_balance = asset(0, quantity2.symbol);
@@ -609,46 +875,29 @@ void onesgame::_subliquidity(name account, uint64_t liquidity_id, uint64_t liqui
     if (defi_liquidity->liquidity_token == liquidity_token)
     {
         _defi_liquidity.modify(defi_liquidity, _self, [&](auto &t) {
-            t.quantity1 -= quantity1;
-            t.quantity2 -= quantity2;
-            t.price1 = 0;
-            t.price2 = 0;
+            t.reserve1 -= quantity1.amount;
+            t.reserve2 -= quantity2.amount;
             t.liquidity_token = 0;
         });
     }
     else
     {
-        uint64_t p1 = std::pow(10, defi_liquidity->quantity1.symbol.precision());
-        uint64_t p2 = std::pow(10, defi_liquidity->quantity2.symbol.precision());
-
         _defi_liquidity.modify(defi_liquidity, _self, [&](auto &t) {
-            t.quantity1 -= quantity1;
-            t.quantity2 -= quantity2;
-            t.price1 = ((1.0 * (defi_liquidity->quantity2.amount - quantity2.amount)) / p2) /
-                       ((1.0 * (defi_liquidity->quantity1.amount - quantity1.amount)) / p1);
-            t.price2 = ((1.0 * (defi_liquidity->quantity1.amount - quantity1.amount)) / p1) /
-                       ((1.0 * (defi_liquidity->quantity2.amount - quantity2.amount)) / p2);
+            t.reserve1 -= quantity1.amount;
+            t.reserve2 -= quantity2.amount;
             t.liquidity_token -= liquidity_token;
         });
     }
 
     if (!is_reserve)
     {
-        _transfer_to(account, defi_liquidity->token1.address.value, quantity1, "withdraw");
-        _transfer_to(account, defi_liquidity->token2.address.value, quantity2, "withdraw");
+        _transfer_to(receiver, defi_liquidity->token1.address.value, quantity1, "withdraw");
+        _transfer_to(receiver, defi_liquidity->token2.address.value, quantity2, "withdraw");
     }
     else
     {
-        // get balance 
-        accounts _ac1(defi_liquidity->token1.address, _self.value);
-        const auto itr1 = _ac1.find( defi_liquidity->token1.symbol.code().raw());
-        eosio_assert(itr1 != _ac1.end(), "token balance does not exist.");
-
-         accounts _ac2(defi_liquidity->token2.address, _self.value);
-        const auto itr2 = _ac2.find( defi_liquidity->token2.symbol.code().raw());
-        eosio_assert(itr2 != _ac2.end(), "token balance does not exist.");
-
-        eosio_assert(itr1->balance.amount > quantity1.amount && itr2->balance.amount > quantity2.amount, "balance enougth");
+        _add_reserved(defi_liquidity->token1.address, quantity1);
+        _add_reserved(defi_liquidity->token2.address, quantity2);
 
         tb_defi_queue defi_queue(get_self(),_self.value);
         auto queue_id = 1;
@@ -667,9 +916,9 @@ void onesgame::_subliquidity(name account, uint64_t liquidity_id, uint64_t liqui
         });
     }
     this->_liquiditylog(account, liquidity_id, "withdraw",
-                            defi_liquidity->token1, defi_liquidity->token2,
                             quantity1, quantity2, liquidity_token,
                             in_balance, out_balance, balance_ltoken);
+    _emit();
 }
 
 void onesgame::claim(name account, uint64_t queue_id){
@@ -690,143 +939,1133 @@ void onesgame::claim(name account, uint64_t queue_id){
     _transfer_to(account, defi_liquidity->token1.address.value, it->quantity1, "withdraw");
     _transfer_to(account, defi_liquidity->token2.address.value, it->quantity2, "withdraw");
 
+    _sub_reserved(defi_liquidity->token1.address, it->quantity1);
+    _sub_reserved(defi_liquidity->token2.address, it->quantity2);
+
     defi_queue.erase(it);
 }
 
-void onesgame::reserve(name account, uint64_t liquidity_id, uint64_t liquidity_token)
+void onesgame::processqueue(uint64_t max_items)
 {
-    require_auth(account);
-
-    _subliquidity(account, liquidity_id, liquidity_token, true);
-}
+    require_auth(name(ONES_PLAY_ACCOUNT));
 
-void onesgame::swapmine(name account, uint64_t code, asset quantity, uint64_t liquidity_id)
-{
-    auto defi_liquidity = _defi_liquidity.find(liquidity_id);
+    tb_defi_queue defi_queue(get_self(), _self.value);
 
-    float weight = defi_liquidity->swap_weight;
+    // token contract -> symbol -> account -> amount, so each account gets one
+    // transfer per token and each liability row is written once
+    std::map<name, std::map<symbol, std::map<name, int64_t>>> payouts;
+    std::map<uint64_t, std::pair<name, name>> contracts;
 
-    asset mine_quantity = asset(0, EOS_TOKEN_SYMBOL);
-    if (defi_liquidity->token1.address == name(EOS_TOKEN_ACCOUNT))
+    auto it = defi_queue.begin();
+    for (uint64_t i = 0; i < max_items && it != defi_queue.end(); i++)
     {
-        if (code == name(EOS_TOKEN_ACCOUNT).value && quantity.symbol == EOS_TOKEN_SYMBOL)
-        {
-            mine_quantity.amount = quantity.amount * weight;
-        }
-        else
+        auto cit = contracts.find(it->liquidity_id);
+        if (cit == contracts.end())
         {
-            mine_quantity.amount = quantity.amount * weight * defi_liquidity->price2;
+            auto defi_liquidity = _defi_liquidity.find(it->liquidity_id);
+            eosio_assert(defi_liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+            cit = contracts.emplace(it->liquidity_id, std::make_pair(defi_liquidity->token1.address,
+                                                                     defi_liquidity->token2.address))
+                      .first;
         }
-    }
-    else
-    {
-        token_t token1, token2;
-        token1.address = name(EOS_TOKEN_ACCOUNT);
-        token1.symbol = EOS_TOKEN_SYMBOL;
-        token2.address = name(code);
-        token2.symbol = quantity.symbol;
 
-        checksum256 digest = this->_getpair_digest(token1, token2);
-        tb_defi_pair _defi_pair(_self, _self.value);
-
-        auto itr = _defi_pair.find(utils::uint64_hash(digest));
-        if (itr == _defi_pair.end())
-            return;
-
-        auto eos_liquidity = _defi_liquidity.find(itr->liquidity_id);
-        if (eos_liquidity == _defi_liquidity.end())
-            return;
+        payouts[cit->second.first][it->quantity1.symbol][it->account] += it->quantity1.amount;
+        payouts[cit->second.second][it->quantity2.symbol][it->account] += it->quantity2.amount;
 
-        mine_quantity.amount = quantity.amount * weight * eos_liquidity->price2;
+        it = defi_queue.erase(it);
     }
 
-    if (mine_quantity.amount >= 10000)
+    for (const auto &contract : payouts)
     {
-        eosio::action(eosio::permission_level{get_self(), "active"_n},
-                      eosio::name(ONES_MINE_ACCOUNT), "mineswap"_n,
-                      make_tuple(account, mine_quantity))
-            .send();
+        for (const auto &sym : contract.second)
+        {
+            int64_t total = 0;
+            for (const auto &payout : sym.second)
+            {
+                _transfer_to(payout.first, contract.first.value, asset(payout.second, sym.first), "withdraw");
+                total += payout.second;
+            }
+            _sub_reserved(contract.first, asset(total, sym.first));
+        }
     }
 }
 
-void onesgame::updateweight(uint64_t liquidity_id, uint64_t type, float_t weight)
+void onesgame::_add_reserved(name contract, asset quantity)
 {
-    require_auth(name(ONES_PLAY_ACCOUNT));
-
-    auto it = _defi_liquidity.find(liquidity_id);
-    eosio_assert(it != _defi_liquidity.end(), "Liquidity does not exist");
-    eosio_assert(type == DEFI_TYPE_LIQUIDITY || type == DEFI_TYPE_SWAP, "type invalid");
+    tb_defi_reserved reserved(get_self(), contract.value);
 
-    if (type == DEFI_TYPE_LIQUIDITY)
+    auto it = reserved.find(quantity.symbol.code().raw());
+    if (it == reserved.end())
     {
-        _defi_liquidity.modify(it, _self, [&](auto &t) { t.liquidity_weight = weight; });
+        reserved.emplace(get_self(), [&](auto &t) { t.quantity = quantity; });
     }
     else
     {
-        _defi_liquidity.modify(it, _self, [&](auto &t) { t.swap_weight = weight; });
+        reserved.modify(it, _self, [&](auto &t) { t.quantity += quantity; });
     }
+}
 
-    eosio::action(eosio::permission_level{get_self(), "active"_n},
-                  eosio::name(ONES_LOG_ACCOUNT), "updateweight"_n,
-                  make_tuple(liquidity_id, type, weight))
-        .send();
+// funds lent out or sent to a venue must leave the queued withdrawals in the contract
+void onesgame::_check_reserved(name contract, const asset &quantity)
+{
+    tb_defi_reserved reserved(get_self(), contract.value);
 
-    eosio::action(eosio::permission_level{get_self(), "active"_n},
-                  eosio::name(ONES_MINE_ACCOUNT), "updateweight"_n,
-                  make_tuple(liquidity_id, type, weight))
-        .send();
+    auto it = reserved.find(quantity.symbol.code().raw());
+    if (it == reserved.end())
+        return;
+
+    accounts balances(contract, get_self().value);
+    auto balance = balances.find(quantity.symbol.code().raw());
+    eosio_assert(balance != balances.end() && balance->balance.amount - quantity.amount >= it->quantity.amount,
+                 "queued withdrawals not covered");
 }
 
-void onesgame::refund(name account, checksum256 trx_id)
+// queue rows created before the liability counter existed were never added
+void onesgame::_sub_reserved(name contract, asset quantity)
 {
+    tb_defi_reserved reserved(get_self(), contract.value);
 
-    require_auth(account);
-    tb_defi_transfers _defi_transfer(_self, _self.value);
-
-    auto defi_transfer = _defi_transfer.find(utils::uint64_hash(trx_id));
-    eosio_assert(defi_transfer != _defi_transfer.end(), "transfer isn't exist");
+    auto it = reserved.find(quantity.symbol.code().raw());
+    if (it == reserved.end())
+        return;
 
-    if (defi_transfer->status == 1)
+    if (it->quantity.amount <= quantity.amount)
     {
-        auto transfer_data = defi_transfer->args1;
-        _transfer_to(transfer_data.from, defi_transfer->action1.value, transfer_data.quantity, "refund");
+        reserved.erase(it);
     }
-
-    if (defi_transfer->status == 2)
+    else
     {
-        auto transfer_data1 = defi_transfer->args1;
-        _transfer_to(transfer_data1.from, defi_transfer->action1.value, transfer_data1.quantity, "refund");
-
-        auto transfer_data2 = defi_transfer->args2;
-        _transfer_to(transfer_data2.from, defi_transfer->action2.value, transfer_data2.quantity, "refund");
+        reserved.modify(it, _self, [&](auto &t) { t.quantity -= quantity; });
     }
 }
 
-void onesgame::remove(uint64_t id)
+// moves liquidity_token of from's position to to with the pro rata share of its
+// quantity1/quantity2, logged as a withdraw and a deposit event; onesgamemine reads
+// defipools at each round, so the moved liquidity mines for to from the next one
+void onesgame::lptransfer(name from, name to, uint64_t liquidity_id, uint64_t liquidity_token)
 {
-    require_auth(name(ONES_PLAY_ACCOUNT));
-
-    tb_defi_pair _defi_pair(_self, _self.value);
+    require_auth(from);
+    eosio_assert(is_account(to) && to != from && to != get_self(), "invalid account");
+    eosio_assert(liquidity_token > 0, "Zero");
 
-    auto itr = _defi_liquidity.find(id);
-    eosio_assert(itr != _defi_liquidity.end(), "liquidity isn't exist");
-    eosio_assert(itr->liquidity_token == 0, "liquidity has token");
-    _defi_liquidity.erase(itr);
+    auto defi_liquidity = _defi_liquidity.find(liquidity_id);
+    eosio_assert(defi_liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+    _check_flash(liquidity_id);
 
-    auto index = _defi_pair.get_index<"byliquidity"_n>();
-    auto it = index.find(id);
-    eosio_assert(it != index.end(), "pair isn't exist");
+    tb_defi_pools pool_index(get_self(), liquidity_id);
+    auto from_itr = pool_index.find(from.value);
+    eosio_assert(from_itr != pool_index.end(), "User liquidity does not exist.");
+    eosio_assert(from_itr->liquidity_token >= liquidity_token, "Insufficient liquidity");
 
-    index.erase(it);
-}
+    asset quantity1 = asset((uint128_t)from_itr->quantity1.amount * liquidity_token / from_itr->liquidity_token,
+                            from_itr->quantity1.symbol);
+    asset quantity2 = asset((uint128_t)from_itr->quantity2.amount * liquidity_token / from_itr->liquidity_token,
+                            from_itr->quantity2.symbol);
 
-void onesgame::_transfer_to(name to, uint64_t code, asset quantity, string memo)
-{
-    if (quantity.amount == 0)
-        return;
+    asset from_balance1 = from_itr->quantity1 - quantity1;
+    asset from_balance2 = from_itr->quantity2 - quantity2;
+    uint64_t from_ltoken = from_itr->liquidity_token - liquidity_token;
 
-    eosio::action(permission_level{get_self(), "active"_n}, eosio::name(code),
-                  "transfer"_n, make_tuple(get_self(), to, quantity, memo))
+    if (from_ltoken == 0)
+    {
+        pool_index.erase(from_itr);
+    }
+    else
+    {
+        pool_index.modify(from_itr, _self, [&](auto &t) {
+            t.quantity1 = from_balance1;
+            t.quantity2 = from_balance2;
+            t.liquidity_token = from_ltoken;
+        });
+    }
+
+    auto to_itr = pool_index.find(to.value);
+    if (to_itr == pool_index.end())
+    {
+        to_itr = pool_index.emplace(get_self(), [&](auto &t) {
+            t.account = to;
+            t.quantity1 = quantity1;
+            t.quantity2 = quantity2;
+            t.liquidity_token = liquidity_token;
+            t.timestamp = now();
+        });
+    }
+    else
+    {
+        pool_index.modify(to_itr, _self, [&](auto &t) {
+            t.quantity1 += quantity1;
+            t.quantity2 += quantity2;
+            t.liquidity_token += liquidity_token;
+        });
+    }
+
+    this->_liquiditylog(from, liquidity_id, "withdraw",
+                        quantity1, quantity2, liquidity_token,
+                        from_balance1, from_balance2, from_ltoken);
+    this->_liquiditylog(to, liquidity_id, "deposit",
+                        quantity1, quantity2, liquidity_token,
+                        to_itr->quantity1, to_itr->quantity2, to_itr->liquidity_token);
+    _emit();
+}
+
+// LP token of a pool: "LP" followed by liquidity_id in base 26 letters, precision 0
+symbol onesgame::_lp_symbol(uint64_t liquidity_id)
+{
+    eosio_assert(liquidity_id < LP_SYMBOL_IDS, "liquidity_id has no LP token symbol");
+
+    std::string code = "LP";
+    do
+    {
+        code.insert(2, 1, (char)('A' + liquidity_id % 26));
+        liquidity_id /= 26;
+    } while (liquidity_id > 0);
+    return symbol(symbol_code(code), 0);
+}
+
+uint64_t onesgame::_lp_liquidity_id(symbol sym)
+{
+    std::string code = sym.code().to_string();
+    eosio_assert(sym.precision() == 0 && code.size() > 2 && code.compare(0, 2, "LP") == 0, "invalid LP token");
+
+    uint64_t liquidity_id = 0;
+    for (uint64_t i = 2; i < code.size(); i++)
+        liquidity_id = liquidity_id * 26 + (code[i] - 'A');
+    return liquidity_id;
+}
+
+// issues the LP token of a pool in the stat/accounts layout of eosio.token;
+// wrapped shares leave defipools and count only in the token supply, so they do
+// not mine in onesgamemine until they are unwrapped
+void onesgame::lpenable(uint64_t liquidity_id)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    eosio_assert(_defi_liquidity.find(liquidity_id) != _defi_liquidity.end(), "Liquidity does not exist");
+
+    symbol sym = _lp_symbol(liquidity_id);
+    stats statstable(get_self(), sym.code().raw());
+    eosio_assert(statstable.find(sym.code().raw()) == statstable.end(), "LP token exists");
+
+    statstable.emplace(get_self(), [&](auto &s) {
+        s.supply = asset(0, sym);
+        s.max_supply = asset(asset::max_amount, sym);
+        s.issuer = get_self();
+    });
+}
+
+void onesgame::wraplp(name account, uint64_t liquidity_id, uint64_t liquidity_token)
+{
+    require_auth(account);
+    eosio_assert(liquidity_token > 0, "Zero");
+
+    auto defi_liquidity = _defi_liquidity.find(liquidity_id);
+    eosio_assert(defi_liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+    _check_flash(liquidity_id);
+
+    symbol sym = _lp_symbol(liquidity_id);
+    stats statstable(get_self(), sym.code().raw());
+    const auto &st = statstable.get(sym.code().raw(), "LP token is not enabled");
+
+    tb_defi_pools pool_index(get_self(), liquidity_id);
+    auto pool_itr = pool_index.find(account.value);
+    eosio_assert(pool_itr != pool_index.end(), "User liquidity does not exist.");
+    eosio_assert(pool_itr->liquidity_token >= liquidity_token, "Insufficient liquidity");
+
+    asset quantity1 = asset((uint128_t)pool_itr->quantity1.amount * liquidity_token / pool_itr->liquidity_token,
+                            pool_itr->quantity1.symbol);
+    asset quantity2 = asset((uint128_t)pool_itr->quantity2.amount * liquidity_token / pool_itr->liquidity_token,
+                            pool_itr->quantity2.symbol);
+    asset balance1 = pool_itr->quantity1 - quantity1;
+    asset balance2 = pool_itr->quantity2 - quantity2;
+    uint64_t balance_ltoken = pool_itr->liquidity_token - liquidity_token;
+
+    if (balance_ltoken == 0)
+    {
+        pool_index.erase(pool_itr);
+    }
+    else
+    {
+        pool_index.modify(pool_itr, _self, [&](auto &t) {
+            t.quantity1 = balance1;
+            t.quantity2 = balance2;
+            t.liquidity_token = balance_ltoken;
+        });
+    }
+
+    asset quantity = asset(liquidity_token, sym);
+    statstable.modify(st, _self, [&](auto &s) { s.supply += quantity; });
+    _add_balance(account, quantity, account);
+
+    this->_liquiditylog(account, liquidity_id, "withdraw",
+                        quantity1, quantity2, liquidity_token,
+                        balance1, balance2, balance_ltoken);
+    _emit();
+}
+
+// burns LP tokens back into a defipools position booked at the current pool ratio
+void onesgame::unwraplp(name account, uint64_t liquidity_id, uint64_t liquidity_token)
+{
+    require_auth(account);
+    eosio_assert(liquidity_token > 0, "Zero");
+
+    auto defi_liquidity = _defi_liquidity.find(liquidity_id);
+    eosio_assert(defi_liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+    _check_flash(liquidity_id);
+
+    symbol sym = _lp_symbol(liquidity_id);
+    stats statstable(get_self(), sym.code().raw());
+    const auto &st = statstable.get(sym.code().raw(), "LP token is not enabled");
+
+    asset quantity = asset(liquidity_token, sym);
+    _sub_balance(account, quantity);
+    statstable.modify(st, _self, [&](auto &s) { s.supply -= quantity; });
+
+    asset quantity1 = asset((uint128_t)defi_liquidity->quantity1().amount * liquidity_token / defi_liquidity->liquidity_token,
+                            defi_liquidity->quantity1().symbol);
+    asset quantity2 = asset((uint128_t)defi_liquidity->quantity2().amount * liquidity_token / defi_liquidity->liquidity_token,
+                            defi_liquidity->quantity2().symbol);
+
+    tb_defi_pools pool_index(get_self(), liquidity_id);
+    auto pool_itr = pool_index.find(account.value);
+    if (pool_itr == pool_index.end())
+    {
+        pool_itr = pool_index.emplace(get_self(), [&](auto &t) {
+            t.account = account;
+            t.quantity1 = quantity1;
+            t.quantity2 = quantity2;
+            t.liquidity_token = liquidity_token;
+            t.timestamp = now();
+        });
+    }
+    else
+    {
+        pool_index.modify(pool_itr, _self, [&](auto &t) {
+            t.quantity1 += quantity1;
+            t.quantity2 += quantity2;
+            t.liquidity_token += liquidity_token;
+        });
+    }
+
+    this->_liquiditylog(account, liquidity_id, "deposit",
+                        quantity1, quantity2, liquidity_token,
+                        pool_itr->quantity1, pool_itr->quantity2, pool_itr->liquidity_token);
+    _emit();
+}
+
+// eosio.token transfer of LP tokens, dispatched from apply as "transfer"
+void onesgame::lptokentransfer(name from, name to, asset quantity, string memo)
+{
+    eosio_assert(from != to, "cannot transfer to self");
+    require_auth(from);
+    eosio_assert(is_account(to), "to account does not exist");
+    eosio_assert(to != get_self(), "use unwraplp");
+
+    _lp_liquidity_id(quantity.symbol);
+    stats statstable(get_self(), quantity.symbol.code().raw());
+    const auto &st = statstable.get(quantity.symbol.code().raw(), "token with symbol does not exist");
+
+    require_recipient(from);
+    require_recipient(to);
+
+    eosio_assert(quantity.is_valid(), "invalid quantity");
+    eosio_assert(quantity.amount > 0, "must transfer positive quantity");
+    eosio_assert(quantity.symbol == st.supply.symbol, "symbol precision mismatch");
+    eosio_assert(memo.size() <= 256, "memo has more than 256 bytes");
+
+    _sub_balance(from, quantity);
+    _add_balance(to, quantity, has_auth(to) ? to : from);
+}
+
+void onesgame::_sub_balance(name owner, asset value)
+{
+    accounts from_acnts(get_self(), owner.value);
+
+    const auto &from = from_acnts.get(value.symbol.code().raw(), "no balance object found");
+    eosio_assert(from.balance.amount >= value.amount, "overdrawn balance");
+
+    if (from.balance.amount == value.amount)
+        from_acnts.erase(from);
+    else
+        from_acnts.modify(from, owner, [&](auto &a) { a.balance -= value; });
+}
+
+void onesgame::_add_balance(name owner, asset value, name ram_payer)
+{
+    accounts to_acnts(get_self(), owner.value);
+    auto to = to_acnts.find(value.symbol.code().raw());
+    if (to == to_acnts.end())
+    {
+        to_acnts.emplace(ram_payer, [&](auto &a) { a.balance = value; });
+    }
+    else
+    {
+        to_acnts.modify(to, ram_payer, [&](auto &a) { a.balance += value; });
+    }
+}
+
+void onesgame::reserve(name account, uint64_t liquidity_id, uint64_t liquidity_token)
+{
+    require_auth(account);
+
+    _subliquidity(account, liquidity_id, liquidity_token, true, account, 0, 0);
+}
+
+void onesgame::reservemin(name account, uint64_t liquidity_id, uint64_t liquidity_token,
+                          uint64_t min_amount1, uint64_t min_amount2, uint32_t deadline)
+{
+    require_auth(account);
+    eosio_assert(now() <= deadline, "deadline exceeded");
+
+    _subliquidity(account, liquidity_id, liquidity_token, true, account, min_amount1, min_amount2);
+}
+
+void onesgame::swapmine(name account, uint64_t code, asset quantity, uint64_t liquidity_id)
+{
+    auto defi_liquidity = _defi_liquidity.find(liquidity_id);
+
+    float weight = defi_liquidity->swap_weight;
+
+    asset mine_quantity = asset(0, EOS_TOKEN_SYMBOL);
+    if (defi_liquidity->token1.address == name(EOS_TOKEN_ACCOUNT))
+    {
+        if (code == name(EOS_TOKEN_ACCOUNT).value && quantity.symbol == EOS_TOKEN_SYMBOL)
+        {
+            mine_quantity.amount = quantity.amount * weight;
+        }
+        else
+        {
+            double price = _get_price(*defi_liquidity, _get_curve(liquidity_id));
+            mine_quantity.amount = price > 0 ? quantity.amount * weight / price : 0;
+        }
+    }
+    else
+    {
+        token_t token1, token2;
+        token1.address = name(EOS_TOKEN_ACCOUNT);
+        token1.symbol = EOS_TOKEN_SYMBOL;
+        token2.address = name(code);
+        token2.symbol = quantity.symbol;
+
+        checksum256 digest = this->_getpair_digest(token1, token2);
+        tb_defi_pair _defi_pair(_self, _self.value);
+
+        auto itr = _defi_pair.find(utils::uint64_hash(digest));
+        if (itr == _defi_pair.end())
+            return;
+
+        auto eos_liquidity = _defi_liquidity.find(itr->liquidity_id);
+        if (eos_liquidity == _defi_liquidity.end())
+            return;
+
+        double price = _get_price(*eos_liquidity, _get_curve(eos_liquidity->liquidity_id));
+        mine_quantity.amount = price > 0 ? quantity.amount * weight / price : 0;
+    }
+
+    if (mine_quantity.amount >= 10000)
+    {
+        eosio::action(eosio::permission_level{get_self(), "active"_n},
+                      eosio::name(ONES_MINE_ACCOUNT), "mineswap"_n,
+                      make_tuple(account, mine_quantity))
+            .send();
+    }
+}
+
+void onesgame::updateweight(uint64_t liquidity_id, uint64_t type, float_t weight)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    eosio_assert(it != _defi_liquidity.end(), "Liquidity does not exist");
+    eosio_assert(type == DEFI_TYPE_LIQUIDITY || type == DEFI_TYPE_SWAP, "type invalid");
+
+    if (type == DEFI_TYPE_LIQUIDITY)
+    {
+        _defi_liquidity.modify(it, _self, [&](auto &t) { t.liquidity_weight = weight; });
+    }
+    else
+    {
+        _defi_liquidity.modify(it, _self, [&](auto &t) { t.swap_weight = weight; });
+    }
+
+    _events.add(events::weight_event{
+        .liquidity_id = liquidity_id,
+        .kind = (uint8_t)type,
+        .weight = weight});
+    _emit();
+
+    eosio::action(eosio::permission_level{get_self(), "active"_n},
+                  eosio::name(ONES_MINE_ACCOUNT), "updateweight"_n,
+                  make_tuple(liquidity_id, type, weight))
+        .send();
+}
+
+void onesgame::updatefee(uint64_t liquidity_id, uint64_t swap_fee, uint64_t fund_fee, uint64_t divd_fee)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    eosio_assert(it != _defi_liquidity.end(), "Liquidity does not exist");
+    eosio_assert(swap_fee <= ONES_FEE_MAX && fund_fee <= ONES_FEE_MAX && divd_fee <= ONES_FEE_MAX, "fee invalid");
+
+    tb_defi_fee _defi_fee(_self, _self.value);
+    auto fee = _defi_fee.find(liquidity_id);
+
+    if (fee == _defi_fee.end())
+    {
+        _defi_fee.emplace(get_self(), [&](auto &t) {
+            t.liquidity_id = liquidity_id;
+            t.swap_fee = swap_fee;
+            t.fund_fee = fund_fee;
+            t.divd_fee = divd_fee;
+        });
+    }
+    else
+    {
+        _defi_fee.modify(fee, _self, [&](auto &t) {
+            t.swap_fee = swap_fee;
+            t.fund_fee = fund_fee;
+            t.divd_fee = divd_fee;
+        });
+    }
+
+    _events.add(events::fee_event{
+        .liquidity_id = liquidity_id,
+        .swap_fee = swap_fee,
+        .fund_fee = fund_fee,
+        .divd_fee = divd_fee});
+    _emit();
+}
+
+// Sends amount_out of either pool token to the callback contract, then calls
+// callback::onflash(account, liquidity_id, amount_out, data). The callback
+// repays with transfers memo "flashrepay,<liquidity_id>" in either token; its
+// inline actions run before the flashcheck queued here, which settles the pool.
+// onflash carries onesgamedefi@flash rather than @active, so a callback can not
+// take it for onesgamedefi's authority elsewhere; it is only satisfied for
+// callbacks whose onflash has been linked to it (make flashcallback).
+void onesgame::flashswap(name account, uint64_t liquidity_id, asset amount_out, name callback, string data)
+{
+    require_auth(account);
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    eosio_assert(it != _defi_liquidity.end(), "Liquidity does not exist");
+    eosio_assert(_get_curve(liquidity_id).kind == DEFI_CURVE_PRODUCT, "flash swap needs a constant product pool");
+    eosio_assert(is_account(callback), "invalid callback");
+    _check_flash(liquidity_id);
+
+    bool out_token1 = amount_out.symbol == it->quantity1().symbol;
+    eosio_assert(out_token1 || amount_out.symbol == it->quantity2().symbol, "symbol error");
+
+    const asset &reserve = out_token1 ? it->quantity1() : it->quantity2();
+    eosio_assert(amount_out.amount > 0 && amount_out.amount < reserve.amount, "invalid amount");
+
+    tb_defi_flash _defi_flash(_self, _self.value);
+    _defi_flash.emplace(get_self(), [&](auto &t) {
+        t.liquidity_id = liquidity_id;
+        t.account = account;
+        t.out_quantity = amount_out;
+        t.repaid1 = asset(0, it->quantity1().symbol);
+        t.repaid2 = asset(0, it->quantity2().symbol);
+    });
+
+    uint64_t code = out_token1 ? it->token1.address.value : it->token2.address.value;
+    _check_reserved(name(code), amount_out);
+    this->_transfer_to(callback, code, amount_out, "flashswap," + std::to_string(liquidity_id));
+
+    eosio::action(permission_level{get_self(), name(ONES_FLASH_PERMISSION)}, callback, "onflash"_n,
+                  make_tuple(account, liquidity_id, amount_out, data))
+        .send();
+
+    eosio::action(permission_level{get_self(), "active"_n}, get_self(), "flashcheck"_n,
+                  make_tuple(liquidity_id))
+        .send();
+}
+
+void onesgame::_flashrepay(asset quantity, std::vector<std::string> &params)
+{
+    eosio_assert(params.size() == 2, "invalid memo");
+    uint64_t liquidity_id = atoll(params.at(1).c_str());
+
+    tb_defi_flash _defi_flash(_self, _self.value);
+    auto flash = _defi_flash.find(liquidity_id);
+    eosio_assert(flash != _defi_flash.end(), "no flash swap in progress");
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    bool token1 = this->code == it->token1.address.value && quantity.symbol == it->token1.symbol;
+    bool token2 = this->code == it->token2.address.value && quantity.symbol == it->token2.symbol;
+    eosio_assert(token1 || token2, "token address error");
+
+    _defi_flash.modify(flash, _self, [&](auto &t) {
+        if (token1)
+            t.repaid1 += quantity;
+        else
+            t.repaid2 += quantity;
+    });
+}
+
+// Settles a flash swap: with the pool's total fee f in bps, the balances net of
+// f on what was paid in must keep x*y. Both sides are floored to whole units
+// before multiplying, which only errs in favour of the pool.
+void onesgame::flashcheck(uint64_t liquidity_id)
+{
+    require_auth(get_self());
+
+    tb_defi_flash _defi_flash(_self, _self.value);
+    auto flash = _defi_flash.find(liquidity_id);
+    eosio_assert(flash != _defi_flash.end(), "no flash swap in progress");
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    st_defi_fee fee = _get_fee(liquidity_id);
+    uint64_t total_fee = fee.swap_fee + fee.fund_fee + fee.divd_fee;
+
+    bool out_token1 = flash->out_quantity.symbol == it->quantity1().symbol;
+    asset quantity1 = it->quantity1() + flash->repaid1 - (out_token1 ? flash->out_quantity : asset(0, it->quantity1().symbol));
+    asset quantity2 = it->quantity2() + flash->repaid2 - (out_token1 ? asset(0, it->quantity2().symbol) : flash->out_quantity);
+    eosio_assert(quantity1.amount > 0 && quantity2.amount > 0, "invariant: negative reserve");
+
+    uint128_t adjusted1 = ((uint128_t)quantity1.amount * ONES_FEE_BASE - (uint128_t)flash->repaid1.amount * total_fee) / ONES_FEE_BASE;
+    uint128_t adjusted2 = ((uint128_t)quantity2.amount * ONES_FEE_BASE - (uint128_t)flash->repaid2.amount * total_fee) / ONES_FEE_BASE;
+    eosio_assert(adjusted1 * adjusted2 >= (uint128_t)it->quantity1().amount * it->quantity2().amount,
+                 "flash swap not repaid");
+
+    // fund and divd take their share of what was paid in, the swap fee stays in the pool
+    asset fund_fee1((uint128_t)flash->repaid1.amount * fee.fund_fee / ONES_FEE_BASE, quantity1.symbol);
+    asset divd_fee1((uint128_t)flash->repaid1.amount * fee.divd_fee / ONES_FEE_BASE, quantity1.symbol);
+    asset fund_fee2((uint128_t)flash->repaid2.amount * fee.fund_fee / ONES_FEE_BASE, quantity2.symbol);
+    asset divd_fee2((uint128_t)flash->repaid2.amount * fee.divd_fee / ONES_FEE_BASE, quantity2.symbol);
+
+    this->_transfer_to(name(ONES_FUND_ACCOUNT), it->token1.address.value, fund_fee1, "flash swap fund fee");
+    this->_transfer_to(name(ONES_DIVD_ACCOUNT), it->token1.address.value, divd_fee1, "flash swap divd fee");
+    this->_transfer_to(name(ONES_FUND_ACCOUNT), it->token2.address.value, fund_fee2, "flash swap fund fee");
+    this->_transfer_to(name(ONES_DIVD_ACCOUNT), it->token2.address.value, divd_fee2, "flash swap divd fee");
+
+    _defi_liquidity.modify(it, _self, [&](auto &t) {
+        t.reserve1 = (quantity1 - fund_fee1 - divd_fee1).amount;
+        t.reserve2 = (quantity2 - fund_fee2 - divd_fee2).amount;
+    });
+
+    // logged as a swap when paid back in the other token, plain flash loans only move reserves
+    const asset &repaid_in = out_token1 ? flash->repaid2 : flash->repaid1;
+    if (repaid_in.amount > 0)
+    {
+        asset fee_quantity((uint128_t)repaid_in.amount * total_fee / ONES_FEE_BASE, repaid_in.symbol);
+        this->_swaplog(flash->account, 0, liquidity_id, out_token1 ? 2 : 1,
+                       repaid_in, flash->out_quantity, fee_quantity);
+        this->swapmine(flash->account, out_token1 ? it->token2.address.value : it->token1.address.value,
+                       repaid_in, liquidity_id);
+    }
+
+    _defi_flash.erase(flash);
+    _emit();
+}
+
+void onesgame::_check_flash(uint64_t liquidity_id)
+{
+    tb_defi_flash _defi_flash(_self, _self.value);
+    eosio_assert(_defi_flash.find(liquidity_id) == _defi_flash.end(), "flash swap in progress");
+}
+
+void onesgame::vaultopen(uint64_t liquidity_id)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    eosio_assert(it != _defi_liquidity.end(), "Liquidity does not exist");
+
+    tb_defi_vault _defi_vault(_self, _self.value);
+    eosio_assert(_defi_vault.find(liquidity_id) == _defi_vault.end(), "vault exists");
+
+    _defi_vault.emplace(get_self(), [&](auto &t) {
+        t.liquidity_id = liquidity_id;
+        t.shares = 0;
+        t.pending1 = asset(0, it->quantity1().symbol);
+        t.pending2 = asset(0, it->quantity2().symbol);
+        t.timestamp = now();
+    });
+}
+
+// liquidity the vault of a pool holds, kept in defipools under this contract
+uint64_t onesgame::_vault_liquidity(uint64_t liquidity_id)
+{
+    tb_defi_pools pool_index(get_self(), liquidity_id);
+    auto it = pool_index.find(get_self().value);
+    return it == pool_index.end() ? 0 : it->liquidity_token;
+}
+
+// pool tokens in liquidity tokens at the pool's reserves, each side worth half of
+// what minting it with its match would give; rounded up for what the vault holds,
+// down for what is paid in, so rounding never favours a depositor
+uint64_t onesgame::_pending_value(const st_defi_liquidity &liquidity, const asset &quantity1, const asset &quantity2,
+                                  bool up)
+{
+    if (liquidity.liquidity_token == 0)
+        return 0;
+
+    uint128_t reserve1 = liquidity.quantity1().amount, reserve2 = liquidity.quantity2().amount;
+    uint128_t value1 = (uint128_t)quantity1.amount * liquidity.liquidity_token + (up ? reserve1 - 1 : 0);
+    uint128_t value2 = (uint128_t)quantity2.amount * liquidity.liquidity_token + (up ? reserve2 - 1 : 0);
+    return (value1 / reserve1 + value2 / reserve2 + (up ? 1 : 0)) / 2;
+}
+
+// memo "vault,<liquidity_id>,<min_shares>[,<account>]" with either pool token: the zap
+// amount that leaves the reserves in the pool's ratio after fees is swapped through
+// the pool, the rest minted for the vault and account credited the shares; shares
+// are priced on the vault's liquidity and pending, the zap's leftovers count as paid in
+void onesgame::_vaultdeposit(name from, asset quantity, std::vector<std::string> &params)
+{
+    eosio_assert(params.size() == 3 || params.size() == 4, "invalid memo");
+    uint64_t liquidity_id = atoll(params.at(1).c_str());
+    uint64_t min_shares = atoll(params.at(2).c_str());
+    name account = params.size() == 4 ? name(params.at(3)) : from;
+    eosio_assert(is_account(account), "invalid account");
+
+    tb_defi_vault _defi_vault(_self, _self.value);
+    auto vault = _defi_vault.find(liquidity_id);
+    eosio_assert(vault != _defi_vault.end(), "vault does not exist");
+
+    uint64_t vault_liquidity = this->_vault_liquidity(liquidity_id);
+
+    swap_t in;
+    in.quantity = quantity;
+    in.code = this->code;
+    zap_t zap = this->_zap(get_self(), liquidity_id, in);
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    uint64_t value = vault_liquidity + this->_pending_value(*it, vault->pending1, vault->pending2, true);
+    uint64_t paid = zap.liquidity_token + this->_pending_value(*it, zap.left1, zap.left2, false);
+    uint64_t shares = vault->shares == 0 || value == 0 ? paid : (uint128_t)paid * vault->shares / value;
+    eosio_assert(shares > 0 && shares >= min_shares, "shares below min_shares");
+
+    _defi_vault.modify(vault, _self, [&](auto &t) {
+        t.shares += shares;
+        t.pending1 += zap.left1;
+        t.pending2 += zap.left2;
+    });
+
+    tb_vault_shares _vault_shares(get_self(), liquidity_id);
+    auto holder = _vault_shares.find(account.value);
+    if (holder == _vault_shares.end())
+    {
+        _vault_shares.emplace(get_self(), [&](auto &t) {
+            t.account = account;
+            t.shares = shares;
+        });
+    }
+    else
+    {
+        _vault_shares.modify(holder, _self, [&](auto &t) { t.shares += shares; });
+    }
+    _emit();
+}
+
+// memo "vaultreward,<liquidity_id>" with a pool token, or
+// "vaultreward,<liquidity_id>,<slippage>,<route>" to swap another token into one first;
+// the result waits in the vault for the next compound
+void onesgame::_vaultreward(name from, asset quantity, std::vector<std::string> &params)
+{
+    eosio_assert(params.size() == 2 || params.size() == 4, "invalid memo");
+
+    swap_t reward;
+    reward.quantity = quantity;
+    reward.code = this->code;
+
+    _vaultcredit(from, atoll(params.at(1).c_str()), reward,
+                 params.size() == 4 ? atoll(params.at(2).c_str()) : 0, params.size() == 4 ? params.at(3) : "");
+}
+
+// adds reward to the pending of a vault, swapped along route ("<id>-<id>...") first
+// when it is not a pool token
+void onesgame::_vaultcredit(name from, uint64_t liquidity_id, swap_t reward, uint64_t slippage, const string &route)
+{
+    tb_defi_vault _defi_vault(_self, _self.value);
+    auto vault = _defi_vault.find(liquidity_id);
+    eosio_assert(vault != _defi_vault.end(), "vault does not exist");
+
+    if (!route.empty())
+    {
+        std::vector<std::string> liquidity_ids;
+        utils::split(route, '-', liquidity_ids);
+        reward = this->_route(from, reward, liquidity_ids, slippage, 0);
+    }
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    if (reward.code == it->token1.address.value && reward.quantity.symbol == it->token1.symbol)
+        _defi_vault.modify(vault, _self, [&](auto &t) { t.pending1 += reward.quantity; });
+    else if (reward.code == it->token2.address.value && reward.quantity.symbol == it->token2.symbol)
+        _defi_vault.modify(vault, _self, [&](auto &t) { t.pending2 += reward.quantity; });
+    else
+        eosio_assert(false, "token address error");
+    _emit();
+}
+
+// turns what is pending in a vault into liquidity for it in one action: the part
+// off the pool ratio is zapped, the matched rest minted, no shares are issued so
+// every share grows
+void onesgame::compound(uint64_t liquidity_id, uint64_t min_lp)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    tb_defi_vault _defi_vault(_self, _self.value);
+    auto vault = _defi_vault.find(liquidity_id);
+    eosio_assert(vault != _defi_vault.end(), "vault does not exist");
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    eosio_assert(it->liquidity_token > 0, "Liquidity is empty");
+
+    asset quantity1 = vault->pending1;
+    asset quantity2 = vault->pending2;
+    eosio_assert(quantity1.amount > 0 || quantity2.amount > 0, "nothing to compound");
+
+    uint128_t value1 = (uint128_t)quantity1.amount * it->quantity2().amount;
+    uint128_t value2 = (uint128_t)quantity2.amount * it->quantity1().amount;
+
+    swap_t excess;
+    if (value1 > value2)
+    {
+        excess.quantity = asset((value1 - value2) / it->quantity2().amount, quantity1.symbol);
+        excess.code = it->token1.address.value;
+    }
+    else
+    {
+        excess.quantity = asset((value2 - value1) / it->quantity1().amount, quantity2.symbol);
+        excess.code = it->token2.address.value;
+    }
+
+    uint64_t minted = 0;
+    if (excess.quantity.amount > 0)
+    {
+        zap_t zap = this->_zap(get_self(), liquidity_id, excess);
+        minted += zap.liquidity_token;
+        if (value1 > value2)
+            quantity1 -= excess.quantity;
+        else
+            quantity2 -= excess.quantity;
+        quantity1 += zap.left1;
+        quantity2 += zap.left2;
+    }
+
+    asset deposit1 = quantity1;
+    asset deposit2 = quantity2;
+    if (quantity1.amount > 0 && quantity2.amount > 0)
+    {
+        minted += this->_mint(get_self(), liquidity_id, deposit1, deposit2, false);
+    }
+    eosio_assert(minted >= min_lp, "liquidity below min_lp");
+
+    _defi_vault.modify(vault, _self, [&](auto &t) {
+        t.pending1 = quantity1 - deposit1;
+        t.pending2 = quantity2 - deposit2;
+        t.timestamp = now();
+    });
+    _emit();
+}
+
+void onesgame::vaultexit(name account, uint64_t liquidity_id, uint64_t shares)
+{
+    require_auth(account);
+
+    tb_defi_vault _defi_vault(_self, _self.value);
+    auto vault = _defi_vault.find(liquidity_id);
+    eosio_assert(vault != _defi_vault.end(), "vault does not exist");
+
+    tb_vault_shares _vault_shares(get_self(), liquidity_id);
+    auto holder = _vault_shares.find(account.value);
+    eosio_assert(holder != _vault_shares.end() && holder->shares >= shares && shares > 0, "Insufficient shares");
+
+    // the shares' part of the vault's liquidity and of what is pending in it
+    uint64_t liquidity_token = (uint128_t)shares * this->_vault_liquidity(liquidity_id) / vault->shares;
+    asset pending1((uint128_t)shares * vault->pending1.amount / vault->shares, vault->pending1.symbol);
+    asset pending2((uint128_t)shares * vault->pending2.amount / vault->shares, vault->pending2.symbol);
+
+    if (holder->shares == shares)
+        _vault_shares.erase(holder);
+    else
+        _vault_shares.modify(holder, _self, [&](auto &t) { t.shares -= shares; });
+
+    _defi_vault.modify(vault, _self, [&](auto &t) {
+        t.shares -= shares;
+        t.pending1 -= pending1;
+        t.pending2 -= pending2;
+    });
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    _transfer_to(account, it->token1.address.value, pending1, "vault exit");
+    _transfer_to(account, it->token2.address.value, pending2, "vault exit");
+
+    // shares too few for a whole liquidity token still redeem their pending
+    if (liquidity_token > 0)
+        _subliquidity(get_self(), liquidity_id, liquidity_token, false, account, 0, 0);
+}
+
+// claims what the vaults' liquidity mined in onesgamemine market rounds;
+// it comes back as "market mine" transfers, held in vaultmined
+void onesgame::vaultclaim()
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    eosio::action(permission_level{get_self(), "active"_n}, name(ONES_MINE_ACCOUNT), "claim"_n,
+                  make_tuple(get_self()))
+        .send();
+}
+
+void onesgame::_vaultmined(asset quantity)
+{
+    tb_vault_mined mined(get_self(), this->code);
+
+    auto it = mined.find(quantity.symbol.code().raw());
+    if (it == mined.end())
+        mined.emplace(get_self(), [&](auto &t) { t.quantity = quantity; });
+    else
+        mined.modify(it, _self, [&](auto &t) { t.quantity += quantity; });
+}
+
+// moves quantity of the mined rewards into the pending of a vault, swapped along
+// route when it is not one of the pool's tokens; rewards are per account in
+// onesgamemine, so the split between vaults is the caller's
+void onesgame::vaultharvest(uint64_t liquidity_id, name contract, asset quantity, uint64_t slippage, string route)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    tb_vault_mined mined(get_self(), contract.value);
+    auto it = mined.find(quantity.symbol.code().raw());
+    eosio_assert(it != mined.end() && it->quantity.symbol == quantity.symbol, "nothing mined");
+    eosio_assert(quantity.amount > 0 && quantity.amount <= it->quantity.amount, "invalid quantity");
+
+    if (quantity == it->quantity)
+        mined.erase(it);
+    else
+        mined.modify(it, _self, [&](auto &t) { t.quantity -= quantity; });
+
+    swap_t reward;
+    reward.quantity = quantity;
+    reward.code = contract.value;
+    _vaultcredit(get_self(), liquidity_id, reward, slippage, route);
+}
+
+void onesgame::setcurve(uint64_t liquidity_id, uint64_t kind, uint64_t param1, uint64_t param2)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    auto it = _defi_liquidity.find(liquidity_id);
+    eosio_assert(it != _defi_liquidity.end(), "Liquidity does not exist");
+    eosio_assert(it->liquidity_token == 0, "liquidity has token");
+    eosio_assert(kind == DEFI_CURVE_PRODUCT || kind == DEFI_CURVE_RANGE || kind == DEFI_CURVE_STABLE,
+                 "kind invalid");
+
+    if (kind == DEFI_CURVE_RANGE)
+        eosio_assert(param1 > 0 && param1 < param2, "range invalid");
+
+    if (kind == DEFI_CURVE_STABLE)
+        eosio_assert(param1 > 0 && param1 <= 10000, "amplification invalid");
+
+    _events.add(events::curve_event{
+        .liquidity_id = liquidity_id,
+        .kind = (uint8_t)kind,
+        .param1 = param1,
+        .param2 = param2});
+    _emit();
+
+    tb_defi_curve _defi_curve(_self, _self.value);
+    auto curve = _defi_curve.find(liquidity_id);
+
+    if (kind == DEFI_CURVE_PRODUCT)
+    {
+        if (curve != _defi_curve.end())
+            _defi_curve.erase(curve);
+        return;
+    }
+
+    if (curve == _defi_curve.end())
+    {
+        _defi_curve.emplace(get_self(), [&](auto &t) {
+            t.liquidity_id = liquidity_id;
+            t.kind = kind;
+            t.param1 = param1;
+            t.param2 = param2;
+        });
+    }
+    else
+    {
+        _defi_curve.modify(curve, _self, [&](auto &t) {
+            t.kind = kind;
+            t.param1 = param1;
+            t.param2 = param2;
+        });
+    }
+}
+
+void onesgame::refund(name account, checksum256 trx_id)
+{
+
+    require_auth(account);
+    tb_defi_transfers _defi_transfer(_self, _self.value);
+
+    auto defi_transfer = _defi_transfer.find(utils::uint64_hash(trx_id));
+    eosio_assert(defi_transfer != _defi_transfer.end(), "transfer isn't exist");
+
+    if (defi_transfer->status == 1)
+    {
+        auto transfer_data = defi_transfer->args1;
+        _transfer_to(transfer_data.from, defi_transfer->action1.value, transfer_data.quantity, "refund");
+    }
+
+    if (defi_transfer->status == 2)
+    {
+        auto transfer_data1 = defi_transfer->args1;
+        _transfer_to(transfer_data1.from, defi_transfer->action1.value, transfer_data1.quantity, "refund");
+
+        auto transfer_data2 = defi_transfer->args2;
+        _transfer_to(transfer_data2.from, defi_transfer->action2.value, transfer_data2.quantity, "refund");
+    }
+}
+
+// replays the NEWLIQUIDITY event of up to max_rows pools from liquidity_id on, with
+// their fee and curve when set, for indexers started after the pools were created;
+// call again from the last liquidity_id + 1 until nothing is emitted
+void onesgame::backfill(uint64_t liquidity_id, uint64_t max_rows)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    tb_defi_fee _defi_fee(_self, _self.value);
+    tb_defi_curve _defi_curve(_self, _self.value);
+
+    uint64_t i = 0;
+    for (auto it = _defi_liquidity.lower_bound(liquidity_id); i < max_rows && it != _defi_liquidity.end(); it++, i++)
+    {
+        _events.add(events::newliquidity_event{
+            .liquidity_id = it->liquidity_id,
+            .contract1 = it->token1.address.value,
+            .symbol1 = it->token1.symbol.raw(),
+            .contract2 = it->token2.address.value,
+            .symbol2 = it->token2.symbol.raw()});
+
+        auto fee = _defi_fee.find(it->liquidity_id);
+        if (fee != _defi_fee.end())
+            _events.add(events::fee_event{
+                .liquidity_id = fee->liquidity_id,
+                .swap_fee = fee->swap_fee,
+                .fund_fee = fee->fund_fee,
+                .divd_fee = fee->divd_fee});
+
+        auto curve = _defi_curve.find(it->liquidity_id);
+        if (curve != _defi_curve.end())
+            _events.add(events::curve_event{
+                .liquidity_id = curve->liquidity_id,
+                .kind = (uint8_t)curve->kind,
+                .param1 = curve->param1,
+                .param2 = curve->param2});
+    }
+    _emit();
+}
+
+// moves up to max_rows legacy rows per call: pools into liquidityv2 first, swap
+// rows need them for their direction, then swaplog rows into swaplogv2
+void onesgame::migratelog(uint64_t max_rows)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    tb_defi_liquidity_v1 legacy_liquidity(_self, _self.value);
+
+    uint64_t i = 0;
+    auto lit = legacy_liquidity.begin();
+    for (; i < max_rows && lit != legacy_liquidity.end(); i++)
+    {
+        if (_defi_liquidity.find(lit->liquidity_id) == _defi_liquidity.end())
+        {
+            _defi_liquidity.emplace(get_self(), [&](auto &t) {
+                t.liquidity_id = lit->liquidity_id;
+                t.token1 = lit->token1;
+                t.token2 = lit->token2;
+                t.reserve1 = lit->quantity1.amount;
+                t.reserve2 = lit->quantity2.amount;
+                t.liquidity_token = lit->liquidity_token;
+                t.swap_weight = lit->swap_weight;
+                t.liquidity_weight = lit->liquidity_weight;
+                t.timestamp = lit->timestamp;
+            });
+        }
+        lit = legacy_liquidity.erase(lit);
+    }
+
+    tb_swap_log swap_log(_self, _self.value);
+
+    auto it = swap_log.begin();
+    for (; i < max_rows && it != swap_log.end(); i++)
+    {
+        // a v2 row needs the pool for its direction, rows of removed pools are dropped
+        auto liquidity = _defi_liquidity.find(it->liquidity_id);
+        if (liquidity != _defi_liquidity.end() && _swap_log.find(it->swap_id) == _swap_log.end())
+        {
+            _swap_log.emplace(get_self(), [&](auto &t) {
+                t.swap_id = it->swap_id;
+                t.third_id = it->third_id;
+                t.account = it->account;
+                t.liquidity_id = it->liquidity_id;
+                t.direction = it->in_token == liquidity->token1 ? 1 : 2;
+                t.in_amount = it->in_asset.amount;
+                t.out_amount = it->out_asset.amount;
+                t.timestamp = it->timestamp;
+            });
+        }
+        it = swap_log.erase(it);
+    }
+}
+
+void onesgame::remove(uint64_t id)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    tb_defi_pair _defi_pair(_self, _self.value);
+
+    auto itr = _defi_liquidity.find(id);
+    eosio_assert(itr != _defi_liquidity.end(), "liquidity isn't exist");
+    eosio_assert(itr->liquidity_token == 0, "liquidity has token");
+    _defi_liquidity.erase(itr);
+
+    tb_defi_curve _defi_curve(_self, _self.value);
+    auto curve = _defi_curve.find(id);
+    if (curve != _defi_curve.end())
+        _defi_curve.erase(curve);
+
+    tb_defi_fee _defi_fee(_self, _self.value);
+    auto fee = _defi_fee.find(id);
+    if (fee != _defi_fee.end())
+        _defi_fee.erase(fee);
+
+    tb_defi_vault _defi_vault(_self, _self.value);
+    auto vault = _defi_vault.find(id);
+    if (vault != _defi_vault.end())
+    {
+        eosio_assert(vault->shares == 0, "vault has shares");
+        _defi_vault.erase(vault);
+    }
+
+    if (id < LP_SYMBOL_IDS)
+    {
+        symbol sym = _lp_symbol(id);
+        stats statstable(get_self(), sym.code().raw());
+        auto st = statstable.find(sym.code().raw());
+        if (st != statstable.end())
+        {
+            eosio_assert(st->supply.amount == 0, "LP token has supply");
+            statstable.erase(st);
+        }
+    }
+
+    auto index = _defi_pair.get_index<"byliquidity"_n>();
+    auto it = index.find(id);
+    eosio_assert(it != index.end(), "pair isn't exist");
+
+    index.erase(it);
+}
+
+void onesgame::_transfer_to(name to, uint64_t code, asset quantity, string memo)
+{
+    if (quantity.amount == 0)
+        return;
+
+    eosio::action(permission_level{get_self(), "active"_n}, eosio::name(code),
+                  "transfer"_n, make_tuple(get_self(), to, quantity, memo))
         .send();
 }
 
@@ -859,12 +2098,11 @@ void onesgame::marketmine(name account, uint64_t liquidity_id,
 {
     require_auth(name(ONES_PLAY_ACCOUNT));
 
-    eosio_assert(account == name(BOX_DEFI_ACCOUNT) || account == name(DFS_DEFI_ACCOUNT),
-                 "account invalid");
+    tb_market_venue _market_venue(get_self(), get_self().value);
+    auto venue = _market_venue.find(account.value);
+    eosio_assert(venue != _market_venue.end(), "account invalid");
 
     tb_market_info _market_info(get_self(), get_self().value);
-    auto info = _market_info.begin();
-    eosio_assert(info == _market_info.end(), "mine has runing");
 
     auto it = _defi_liquidity.find(liquidity_id);
     eosio_assert(it != _defi_liquidity.end(), "Liquidity does not exist");
@@ -872,7 +2110,10 @@ void onesgame::marketmine(name account, uint64_t liquidity_id,
     eosio_assert(it->token1.symbol == quantity1.symbol, "must be eos");
     eosio_assert(it->token2.symbol == quantity2.symbol, "must be usdt");
 
+    uint64_t mine_id = _new_market_id();
+
     _market_info.emplace(get_self(), [&](auto &t) {
+        t.mine_id = mine_id;
         t.liquidity_id = liquidity_id;
         t.account = account;
 
@@ -882,13 +2123,19 @@ void onesgame::marketmine(name account, uint64_t liquidity_id,
         t.out_token1 = asset(0, quantity1.symbol);
         t.out_token2 = asset(0, quantity2.symbol);
 
+        t.settled1 = asset(0, quantity1.symbol);
+        t.settled2 = asset(0, quantity2.symbol);
+
         t.liquidity_token = 0;
         t.timestamp = now();
         t.status = 0;
     });
 
-    string memo = "deposit";
-    if (account == name(BOX_DEFI_ACCOUNT))
+    _check_reserved(it->token1.address, quantity1);
+    _check_reserved(it->token2.address, quantity2);
+
+    string memo = venue->deposit_memo;
+    if (venue->deposit_id)
         memo += "," + std::to_string(to_liquidity_id);
 
     eosio::action action1 = action(
@@ -902,148 +2149,227 @@ void onesgame::marketmine(name account, uint64_t liquidity_id,
     eosio::action action3 =
         action(eosio::permission_level(get_self(), "active"_n), account,
                "deposit"_n, make_tuple(get_self(), to_liquidity_id));
-    if (account == name(BOX_DEFI_ACCOUNT))
-    {
-        action1.send();
-        action2.send();
+    if (venue->deposit_first)
         action3.send();
-    }
-    else if (account == name(DFS_DEFI_ACCOUNT))
-    {
+
+    action1.send();
+    action2.send();
+
+    if (!venue->deposit_first)
         action3.send();
-        action1.send();
-        action2.send();
-    }
 }
 
-void onesgame::marketexit(string memo, uint64_t amount)
+void onesgame::marketexit(uint64_t mine_id, string memo, uint64_t amount)
 {
     require_auth(name(ONES_PLAY_ACCOUNT));
 
     tb_market_info _market_info(get_self(), get_self().value);
-    auto info = _market_info.begin();
+    auto info = _market_info.find(mine_id);
     eosio_assert(info != _market_info.end(), "mine does not exist");
+    _set_market_active(mine_id);
 
-    if (info->account == name(BOX_DEFI_ACCOUNT))
+    tb_market_venue _market_venue(get_self(), get_self().value);
+    const auto &venue = _market_venue.get(info->account.value, "venue does not exist");
+
+    if (venue.lptoken != name())
     {
-        _marketexit_box(info->liquidity_token, info->liquidity_symbol, memo);
+        asset quantity(info->liquidity_token, info->liquidity_symbol);
+        this->_transfer_to(venue.account, venue.lptoken.value, quantity, memo);
     }
-    else if (info->account == name(DFS_DEFI_ACCOUNT))
+    else
     {
         _market_info.modify(info, _self, [&](auto &t) { t.liquidity_token = amount; });
-        _marketexit_dfs(amount, atoll(memo.c_str()));
+
+        eosio::action(permission_level{get_self(), "active"_n},
+                      venue.account, "withdraw"_n,
+                      make_tuple(get_self(), (uint64_t)atoll(memo.c_str()), amount))
+            .send();
     }
 }
 
-void onesgame::marketclaim()
+void onesgame::marketclaim(uint64_t mine_id)
 {
     require_auth(name(ONES_PLAY_ACCOUNT));
 
     tb_market_info _market_info(get_self(), get_self().value);
-    auto info = _market_info.begin();
+    auto info = _market_info.find(mine_id);
     eosio_assert(info != _market_info.end(), "mine does not exist");
+    _set_market_active(mine_id);
 
     eosio_assert(info->status == 2 && info->out_token1.amount > 0 &&
                      info->out_token2.amount > 0,
                  "mine does not exist");
 
-    if (info->account == name(BOX_DEFI_ACCOUNT))
-        _marketclaim_box();
+    tb_market_venue _market_venue(get_self(), get_self().value);
+    const auto &venue = _market_venue.get(info->account.value, "venue does not exist");
+
+    if (venue.claim != name())
+        eosio::action(permission_level{get_self(), "active"_n},
+                      venue.claim, "claim"_n,
+                      make_tuple(get_self()))
+            .send();
+}
+
+void onesgame::setvenue(st_market_venue venue)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
+
+    _setvenue(venue);
 }
 
-void onesgame::marketsettle()
+// registers the Box and DFS venues the market mine started with, venues that
+// are already registered keep their settings; a position still open in the old
+// marketinfo table moves to marketpos and becomes the active one
+void onesgame::upgrade()
 {
     require_auth(name(ONES_PLAY_ACCOUNT));
 
     tb_market_info _market_info(get_self(), get_self().value);
-    auto info = _market_info.begin();
-    eosio_assert(info != _market_info.end(), "mine does not exist");
-
-    auto liquidity = _defi_liquidity.find(info->liquidity_id);
-    eosio_assert(liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+    tb_market_info_v1 legacy_info(get_self(), get_self().value);
+    for (auto lit = legacy_info.begin(); lit != legacy_info.end();)
+    {
+        uint64_t mine_id = _new_market_id();
+        _market_info.emplace(get_self(), [&](auto &t) {
+            t.mine_id = mine_id;
+            t.liquidity_id = lit->liquidity_id;
+            t.account = lit->account;
 
-    uint64_t size = 1;
-    if ((info->out_token1.amount - info->in_token1.amount) < 0)
-        size++;
+            t.in_token1 = lit->in_token1;
+            t.in_token2 = lit->in_token2;
 
-    if ((info->out_token2.amount - info->in_token2.amount) < 0)
-        size++;
+            t.liquidity_token = lit->liquidity_token;
+            t.liquidity_symbol = lit->liquidity_symbol;
 
-    std::vector<eosio::action> actions = _get_actions();
-    eosio_assert(actions.size() == size, "You need transfer tokens");
+            t.out_token1 = lit->out_token1;
+            t.out_token2 = lit->out_token2;
 
-    if (size == 2)
-    {
-        eosio::action action1 = eosio::get_action(1, 0);
-        eosio_assert(action1.name == eosio::name("transfer"), "You need transfer tokens");
+            t.settled1 = asset(0, lit->in_token1.symbol);
+            t.settled2 = asset(0, lit->in_token2.symbol);
 
-        size_t size1 = action1.data.size();
-        auto transfer_data1 = unpack<transfer_args>(&action1.data[0], size1);
-        eosio_assert(transfer_data1.memo == "marketsettle", "Invalid marketsettle.");
+            t.profit = lit->profit;
+            t.timestamp = lit->timestamp;
+            t.status = lit->status;
+        });
+        lit = legacy_info.erase(lit);
+    }
 
-        if ((info->out_token1.amount - info->in_token1.amount) < 0)
-        {
-            eosio_assert(action1.account == liquidity->token1.address &&
-                             transfer_data1.quantity.symbol == liquidity->token1.symbol,
-                         "You need transfer token1");
-            eosio_assert((info->in_token1.amount - info->out_token1.amount) ==
-                             transfer_data1.quantity.amount,
-                         "You need transfer enough token1");
-        }
+    tb_market_venue _market_venue(get_self(), get_self().value);
+    if (_market_venue.find(name("swap.defi").value) == _market_venue.end())
+    {
+        _setvenue(st_market_venue{
+            .account = name("swap.defi"),
+            .lptoken = name("lptoken.defi"),
+            .claim = name("lptoken.defi"),
+            .reward = name("token.defi"),
+            .reward_from = name("lptoken.defi"),
+            .deposit_memo = "deposit",
+            .deposit_id = true,
+            .deposit_first = false,
+            .refund_memo = "Defibox: deposit refund",
+            .withdraw_memo = "Defibox: withdraw",
+            .lpissue_memo = "issue lp token"});
+    }
+    if (_market_venue.find(name("defisswapcnt").value) == _market_venue.end())
+    {
+        _setvenue(st_market_venue{
+            .account = name("defisswapcnt"),
+            .lptoken = name(),
+            .claim = name(),
+            .reward = name("minedfstoken"),
+            .reward_from = name("minedfstoken"),
+            .deposit_memo = "deposit",
+            .deposit_id = false,
+            .deposit_first = true,
+            .refund_memo = "refund",
+            .withdraw_memo = "withdraw",
+            .lpissue_memo = ""});
+    }
+}
 
-        if ((info->out_token2.amount - info->in_token2.amount) < 0)
+void onesgame::_setvenue(const st_market_venue &venue)
+{
+    eosio_assert(is_account(venue.account), "account invalid");
+    eosio_assert(venue.reward != name() && venue.reward_from != name(), "reward invalid");
+    eosio_assert(!venue.refund_memo.empty() && !venue.withdraw_memo.empty(), "memo invalid");
+    eosio_assert(venue.lptoken == name() || !venue.lpissue_memo.empty(), "memo invalid");
+
+    tb_market_venue _market_venue(get_self(), get_self().value);
+    tb_market_sender _market_sender(get_self(), get_self().value);
+    auto it = _market_venue.find(venue.account.value);
+    if (it == _market_venue.end())
+    {
+        _market_venue.emplace(get_self(), [&](auto &t) { t = venue; });
+    }
+    else
+    {
+        // the senders of the previous settings go first, reward_from may have changed
+        for (name sender : {it->account, it->reward_from})
         {
-            eosio_assert(action1.account == liquidity->token2.address &&
-                             transfer_data1.quantity.symbol == liquidity->token2.symbol,
-                         "You need transfer token2");
-            eosio_assert((info->in_token2.amount - info->out_token2.amount) ==
-                             transfer_data1.quantity.amount,
-                         "You need transfer enough token2");
+            auto s = _market_sender.find(sender.value);
+            if (s != _market_sender.end() && s->venue == venue.account)
+                _market_sender.erase(s);
         }
+        _market_venue.modify(it, _self, [&](auto &t) { t = venue; });
     }
-    else if (size == 3)
-    {
-        eosio::action action1 = eosio::get_action(1, 0);
-        eosio::action action2 = eosio::get_action(1, 1);
 
-        eosio_assert(action1.name == eosio::name("transfer") && action2.name == eosio::name("transfer"), "You need transfer both tokens");
+    for (name sender : {venue.account, venue.reward_from})
+    {
+        auto it = _market_sender.find(sender.value);
+        eosio_assert(it == _market_sender.end() || it->venue == venue.account, "sender used by another venue");
+        if (it == _market_sender.end())
+            _market_sender.emplace(get_self(), [&](auto &t) {
+                t.sender = sender;
+                t.venue = venue.account;
+            });
+    }
+}
 
-        size_t size1 = action1.data.size();
-        auto transfer_data1 = unpack<transfer_args>(&action1.data[0], size1);
-        eosio_assert(transfer_data1.memo == "marketsettle", "Invalid marketsettle.");
+void onesgame::rmvenue(name account)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
 
-        size_t size2 = action1.data.size();
-        auto transfer_data2 = unpack<transfer_args>(&action2.data[0], size2);
-        eosio_assert(transfer_data2.memo == "marketsettle", "Invalid marketsettle.");
+    tb_market_info _market_info(get_self(), get_self().value);
+    auto index = _market_info.get_index<"byvenue"_n>();
+    eosio_assert(index.find(account.value) == index.end(), "mine has runing");
 
-        eosio_assert(action1.account == liquidity->token1.address && transfer_data1.quantity.symbol == liquidity->token1.symbol, "You need transfer token1");
-        eosio_assert((info->in_token1.amount - info->out_token1.amount) == transfer_data1.quantity.amount, "You need transfer enough token1");
+    tb_market_venue _market_venue(get_self(), get_self().value);
+    auto it = _market_venue.find(account.value);
+    eosio_assert(it != _market_venue.end(), "venue does not exist");
 
-        eosio_assert(action2.account == liquidity->token2.address && transfer_data2.quantity.symbol == liquidity->token2.symbol, "You need transfer token2");
-        eosio_assert((info->in_token2.amount - info->out_token2.amount) == transfer_data2.quantity.amount, "You need transfer enough token2");
+    tb_market_sender _market_sender(get_self(), get_self().value);
+    for (name sender : {it->account, it->reward_from})
+    {
+        auto s = _market_sender.find(sender.value);
+        if (s != _market_sender.end() && s->venue == account)
+            _market_sender.erase(s);
     }
 
-    if ((info->out_token1.amount - info->in_token1.amount) > 0)
-        _transfer_to(name(ONES_PLAY_ACCOUNT), liquidity->token1.address.value,
-                     info->out_token1 - info->in_token1, "market");
+    _market_venue.erase(it);
+}
 
-    if ((info->out_token2.amount - info->in_token2.amount) > 0)
-        _transfer_to(name(ONES_PLAY_ACCOUNT), liquidity->token2.address.value,
-                     info->out_token2 - info->in_token2, "market");
+void onesgame::marketsettle(uint64_t mine_id)
+{
+    require_auth(name(ONES_PLAY_ACCOUNT));
 
-    tb_market_log _market_log(get_self(), get_self().value);
-    auto log = _market_log.rbegin();
-    uint64_t mine_id = 1;
-    if (log != _market_log.rend())
-        mine_id = log->mine_id + 1;
+    tb_market_info _market_info(get_self(), get_self().value);
+    auto info = _market_info.find(mine_id);
+    eosio_assert(info != _market_info.end(), "mine does not exist");
 
-    auto it = _market_log.begin();
-    while (it != _market_log.end() && mine_id > 100 && (it->mine_id < (mine_id - 100)))
-    {
-        it = _market_log.erase(it);
-    }
+    auto liquidity = _defi_liquidity.find(info->liquidity_id);
+    eosio_assert(liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+
+    // what came back plus what was credited must cover what went in, the rest is profit
+    asset net1 = info->out_token1 + info->settled1 - info->in_token1;
+    asset net2 = info->out_token2 + info->settled2 - info->in_token2;
+    eosio_assert(net1.amount >= 0, "You need transfer enough token1");
+    eosio_assert(net2.amount >= 0, "You need transfer enough token2");
+
+    _transfer_to(name(ONES_PLAY_ACCOUNT), liquidity->token1.address.value, net1, "market");
+    _transfer_to(name(ONES_PLAY_ACCOUNT), liquidity->token2.address.value, net2, "market");
 
-    _market_log.emplace(get_self(), [&](auto &t) {
+    tb_market_ring _market_ring(get_self(), get_self().value);
+
+    auto fill = [&](auto &t) {
         t.mine_id = mine_id;
         t.liquidity_id = info->liquidity_id;
         t.account = info->account;
@@ -1059,105 +2385,124 @@ void onesgame::marketsettle()
         t.liquidity_token = info->liquidity_token;
         t.begin_timestamp = info->timestamp;
         t.end_timestamp = now();
-    });
+    };
+
+    auto slot = _market_ring.find(mine_id % 100);
+    if (slot == _market_ring.end())
+        _market_ring.emplace(get_self(), fill);
+    else if (slot->mine_id < mine_id)
+        _market_ring.modify(slot, _self, fill);
+
+    _events.add(events::market_event{
+        .mine_id = mine_id,
+        .venue = info->account.value,
+        .liquidity_id = info->liquidity_id,
+        .in_amount1 = (uint64_t)info->in_token1.amount,
+        .in_amount2 = (uint64_t)info->in_token2.amount,
+        .out_amount1 = (uint64_t)info->out_token1.amount,
+        .out_amount2 = (uint64_t)info->out_token2.amount,
+        .reward_amount = (uint64_t)info->profit.amount,
+        .reward_symbol = info->profit.symbol.raw(),
+        .begin_time = (uint32_t)info->timestamp,
+        .end_time = now()});
 
     _market_info.erase(info);
+    _emit();
 }
 
-void onesgame::_marketexit_box(uint64_t liquidity_token, symbol symbol_code, string memo)
-{
-    asset quantity(liquidity_token, symbol_code);
-    this->_transfer_to(name(BOX_DEFI_ACCOUNT), name(BOX_LPTOKEN_ACCOUNT).value, quantity, memo);
-}
-
-void onesgame::_marketexit_dfs(uint64_t liquidity_token, uint64_t liquidity_id)
-{
-    eosio::action(permission_level{get_self(), "active"_n},
-                  eosio::name(DFS_DEFI_ACCOUNT), "withdraw"_n,
-                  make_tuple(get_self(), liquidity_id, liquidity_token))
-        .send();
-}
-
-void onesgame::_marketclaim_box()
-{
-    eosio::action(permission_level{get_self(), "active"_n},
-                  eosio::name(BOX_LPTOKEN_ACCOUNT), "claim"_n,
-                  make_tuple(get_self()))
-        .send();
-}
-
-void onesgame::_handle_box(name from, name to, asset quantity, string memo)
+void onesgame::_handle_venue(const st_market_venue &venue, name from, asset quantity, const string &memo)
 {
-    if (from == name(BOX_DEFI_ACCOUNT))
+    if (from == venue.account)
     {
-        if (memo.find("Defibox: deposit refund") != std::string::npos)
+        if (memo.find(venue.refund_memo) != std::string::npos)
         {
-            _handle_refund(quantity);
+            _handle_refund(venue.account, quantity);
         }
-        else if (memo.find("Defibox: withdraw") != std::string::npos)
+        else if (memo.find(venue.withdraw_memo) != std::string::npos)
         {
-            _handle_withdraw(quantity);
+            _handle_withdraw(venue.account, quantity);
         }
-        else if (memo.find("issue lp token") != std::string::npos)
+        else if (venue.lptoken != name() && this->code == venue.lptoken.value &&
+                 memo.find(venue.lpissue_memo) != std::string::npos)
         {
-            if (this->code == name(BOX_LPTOKEN_ACCOUNT).value)
-            {
-                tb_market_info _market_info(get_self(), get_self().value);
-                auto info = _market_info.begin();
-                eosio_assert(info != _market_info.end(), "mine is not exist");
-                _market_info.modify(info, _self, [&](auto &t) {
-                    t.liquidity_token = quantity.amount;
-                    t.liquidity_symbol = quantity.symbol;
-                });
-            }
+            tb_market_info _market_info(get_self(), get_self().value);
+            auto info = _get_market(_market_info, venue.account);
+            _market_info.modify(info, _self, [&](auto &t) {
+                t.liquidity_token = quantity.amount;
+                t.liquidity_symbol = quantity.symbol;
+            });
         }
     }
-    else if (from == name(BOX_LPTOKEN_ACCOUNT))
+
+    if (from == venue.reward_from && this->code == venue.reward.value)
     {
-        if (this->code == name(BOX_TOKEN_ACCOUNT).value)
-        {
-            tb_market_info _market_info(get_self(), get_self().value);
-            auto info = _market_info.begin();
-            eosio_assert(info != _market_info.end(), "mine is not exist");
-            _market_info.modify(info, _self, [&](auto &t) { t.profit = quantity; });
+        tb_market_info _market_info(get_self(), get_self().value);
+        auto info = _get_market(_market_info, venue.account);
+        _market_info.modify(info, _self, [&](auto &t) { t.profit = quantity; });
 
-            this->_transfer_to(name(ONES_MINE_ACCOUNT), name(BOX_TOKEN_ACCOUNT).value, quantity, "market mine reward");
-        }
+        this->_transfer_to(name(ONES_MINE_ACCOUNT), venue.reward.value, quantity, "market mine reward");
     }
 }
 
-void onesgame::_handle_dfs(name from, name to, asset quantity, string memo)
+void onesgame::_marketcredit(asset quantity, std::vector<std::string> &params)
+{
+    eosio_assert(params.size() == 2, "Invalid marketsettle.");
+
+    tb_market_info _market_info(get_self(), get_self().value);
+    auto info = _market_info.find(atoll(params.at(1).c_str()));
+    eosio_assert(info != _market_info.end(), "mine does not exist");
+
+    auto liquidity = _defi_liquidity.find(info->liquidity_id);
+    eosio_assert(liquidity != _defi_liquidity.end(), "Liquidity does not exist");
+
+    if (this->code == liquidity->token1.address.value && quantity.symbol == liquidity->token1.symbol)
+        _market_info.modify(info, _self, [&](auto &t) { t.settled1 += quantity; });
+    else if (this->code == liquidity->token2.address.value && quantity.symbol == liquidity->token2.symbol)
+        _market_info.modify(info, _self, [&](auto &t) { t.settled2 += quantity; });
+    else
+        eosio_assert(false, "token address error");
+}
+
+// position of the market action running in this transaction, checked against the sending venue
+onesgame::tb_market_info::const_iterator onesgame::_get_market(tb_market_info &market_info, name venue)
+{
+    tb_market_config _market_config(get_self(), get_self().value);
+    auto info = market_info.find(_market_config.get_or_default().active_id);
+    eosio_assert(info != market_info.end() && info->account == venue, "mine is not exist");
+    return info;
+}
+
+// numbers a new position and makes it the active one
+uint64_t onesgame::_new_market_id()
 {
-    if (from == name(DFS_DEFI_ACCOUNT))
+    tb_market_config _market_config(get_self(), get_self().value);
+    st_market_config config = _market_config.get_or_default();
+    if (config.next_id == 0)
     {
-        if (memo.find("refund") != std::string::npos)
-        {
-            _handle_refund(quantity);
-        }
-        else if (memo.find("withdraw") != std::string::npos)
-        {
-            _handle_withdraw(quantity);
-        }
+        // continue the numbering of the logs written before positions had ids
+        tb_market_log _market_log(get_self(), get_self().value);
+        auto log = _market_log.rbegin();
+        config.next_id = log == _market_log.rend() ? 1 : log->mine_id + 1;
     }
-    else if (from == name(DFS_TOKEN_ACCOUNT))
-    {
-        if (this->code == name(DFS_TOKEN_ACCOUNT).value)
-        {
-            tb_market_info _market_info(get_self(), get_self().value);
-            auto info = _market_info.begin();
-            eosio_assert(info != _market_info.end(), "mine is not exist");
-            _market_info.modify(info, _self, [&](auto &t) { t.profit = quantity; });
 
-            this->_transfer_to(name(ONES_MINE_ACCOUNT), name(DFS_TOKEN_ACCOUNT).value, quantity, "market mine reward");
-        }
-    }
+    uint64_t mine_id = config.next_id++;
+    config.active_id = mine_id;
+    _market_config.set(config, get_self());
+    return mine_id;
+}
+
+void onesgame::_set_market_active(uint64_t mine_id)
+{
+    tb_market_config _market_config(get_self(), get_self().value);
+    st_market_config config = _market_config.get();
+    config.active_id = mine_id;
+    _market_config.set(config, get_self());
 }
 
-void onesgame::_handle_refund(asset quantity)
+void onesgame::_handle_refund(name venue, asset quantity)
 {
     tb_market_info _market_info(get_self(), get_self().value);
-    auto info = _market_info.begin();
-    eosio_assert(info != _market_info.end(), "mine is not exist");
+    auto info = _get_market(_market_info, venue);
 
     auto liquidity = _defi_liquidity.find(info->liquidity_id);
     eosio_assert(liquidity != _defi_liquidity.end(), "Liquidity does not exist");
@@ -1184,11 +2529,10 @@ void onesgame::_handle_refund(asset quantity)
     }
 }
 
-void onesgame::_handle_withdraw(asset quantity)
+void onesgame::_handle_withdraw(name venue, asset quantity)
 {
     tb_market_info _market_info(get_self(), get_self().value);
-    auto info = _market_info.begin();
-    eosio_assert(info != _market_info.end(), "mine is not exist");
+    auto info = _get_market(_market_info, venue);
 
     auto liquidity = _defi_liquidity.find(info->liquidity_id);
     eosio_assert(liquidity != _defi_liquidity.end(), "Liquidity does not exist");
@@ -1217,12 +2561,18 @@ extern "C"
             eosio_assert(code == eosio::name("eosio").value, "onerror action’s are only valid from the eosio");
         }
 
+        if (code == receiver && action == eosio::name("transfer").value)
+        {
+            execute_action(eosio::name(receiver), eosio::name(code), &onesgame::lptokentransfer);
+            return;
+        }
+
         if (code == receiver)
         {
             switch (action)
             {
-                EOSIO_DISPATCH_HELPER(onesgame, (newliquidity)(addliquidity)(subliquidity)(reserve)(claim)(remove)(
-                                                    updateweight)(marketmine)(marketexit)(marketclaim)(marketsettle))
+                EOSIO_DISPATCH_HELPER(onesgame, (newliquidity)(addliquidity)(subliquidity)(reserve)(addliqmin)(subliqmin)(reservemin)(lptransfer)(lpenable)(wraplp)(unwraplp)(claim)(remove)(
+                                                    updateweight)(setcurve)(updatefee)(vaultopen)(compound)(vaultexit)(vaultclaim)(vaultharvest)(flashswap)(flashcheck)(marketmine)(marketexit)(marketclaim)(marketsettle)(setvenue)(rmvenue)(upgrade)(migratelog)(backfill)(event)(processqueue))
             }
             return;
         }
@@ -8,6 +8,8 @@
 #include <eosiolib/time.hpp>
 #include <string>
 #include <utils.hpp>
+#include <events.hpp>
+#include <curve.hpp>
 #include <vector>
 
 using namespace eosio;
@@ -23,7 +25,6 @@ public:
         : contract(self, code, ds),
           _defi_liquidity(_self, _self.value),
           _defi_config(_self, _self.value),
-          _liquidity_log(_self, _self.value),
           _swap_log(_self, _self.value){};
 
     ~onesgame(){};
@@ -47,7 +48,8 @@ public:
     };
     typedef singleton<"config"_n, st_defi_config> tb_defi_config;
 
-    struct currency_stats
+    // token stats, read from token contracts and kept by this one for LP tokens
+    struct [[eosio::table]] currency_stats
     {
         asset supply;
         asset max_supply;
@@ -67,12 +69,35 @@ public:
     };
     typedef multi_index<"pair"_n, st_defi_pair, indexed_by<"byliquidity"_n, const_mem_fun<st_defi_pair, uint64_t, &st_defi_pair::liquidity_key>>> tb_defi_pair;
 
+    // compact pool row: reserves are raw amounts in the symbols of token1/token2,
+    // prices are derived from the reserves and the curve on read
     struct [[eosio::table]] st_defi_liquidity
     {
         uint64_t liquidity_id;
         token_t token1;
         token_t token2;
 
+        int64_t reserve1;
+        int64_t reserve2;
+        uint64_t liquidity_token;
+        float_t swap_weight;
+        float_t liquidity_weight;
+        uint32_t timestamp;
+
+        uint64_t primary_key() const { return liquidity_id; }
+        asset quantity1() const { return asset(reserve1, token1.symbol); }
+        asset quantity2() const { return asset(reserve2, token2.symbol); }
+    };
+
+    typedef multi_index<"liquidityv2"_n, st_defi_liquidity> tb_defi_liquidity;
+
+    // pool row before liquidityv2, read only by migratelog
+    struct [[eosio::table]] st_defi_liquidity_v1
+    {
+        uint64_t liquidity_id;
+        token_t token1;
+        token_t token2;
+
         eosio::asset quantity1;
         eosio::asset quantity2;
         uint64_t liquidity_token;
@@ -87,7 +112,88 @@ public:
         uint64_t primary_key() const { return liquidity_id; }
     };
 
-    typedef multi_index<"liquidity"_n, st_defi_liquidity> tb_defi_liquidity;
+    typedef multi_index<"liquidity"_n, st_defi_liquidity_v1> tb_defi_liquidity_v1;
+
+    // pricing curve of a pool, pools without a row are constant product;
+    // range pools bound the price of token1 in token2 to [param1, param2] / 1e8,
+    // stable pools use the StableSwap invariant with amplification param1
+    struct [[eosio::table]] st_defi_curve
+    {
+        uint64_t liquidity_id;
+        uint64_t kind;
+        uint64_t param1;
+        uint64_t param2;
+
+        uint64_t primary_key() const { return liquidity_id; }
+    };
+
+    typedef multi_index<"curve"_n, st_defi_curve> tb_defi_curve;
+
+    // per pool fees in basis points, pools without a row use the defaults
+    struct [[eosio::table]] st_defi_fee
+    {
+        uint64_t liquidity_id;
+        uint64_t swap_fee;
+        uint64_t fund_fee;
+        uint64_t divd_fee;
+
+        uint64_t primary_key() const { return liquidity_id; }
+    };
+
+    typedef multi_index<"poolfee"_n, st_defi_fee> tb_defi_fee;
+
+    // open flash swap of a pool, exists only between flashswap and flashcheck
+    // and locks the pool meanwhile; repaid1/repaid2 collect flashrepay transfers
+    struct [[eosio::table]] st_defi_flash
+    {
+        uint64_t liquidity_id;
+        eosio::name account;
+        eosio::asset out_quantity;
+        eosio::asset repaid1;
+        eosio::asset repaid2;
+
+        uint64_t primary_key() const { return liquidity_id; }
+    };
+
+    typedef multi_index<"flash"_n, st_defi_flash> tb_defi_flash;
+
+    // auto compounding vault of a pool: its liquidity sits in defipools under this
+    // contract, depositors hold shares of it and of pending1/pending2, pool tokens
+    // waiting for the next compound
+    struct [[eosio::table]] st_defi_vault
+    {
+        uint64_t liquidity_id;
+        uint64_t shares;
+        eosio::asset pending1;
+        eosio::asset pending2;
+        uint64_t timestamp;
+
+        uint64_t primary_key() const { return liquidity_id; }
+    };
+
+    typedef multi_index<"vault"_n, st_defi_vault> tb_defi_vault;
+
+    // vault shares of an account, scoped by liquidity_id
+    struct [[eosio::table]] st_vault_shares
+    {
+        eosio::name account;
+        uint64_t shares;
+
+        uint64_t primary_key() const { return account.value; }
+    };
+
+    typedef multi_index<"vaultshares"_n, st_vault_shares> tb_vault_shares;
+
+    // onesgamemine rewards of the vaults' liquidity and swaps, claimed by vaultclaim
+    // and held until vaultharvest moves them into a vault; scoped by token contract
+    struct [[eosio::table]] st_vault_mined
+    {
+        eosio::asset quantity;
+
+        uint64_t primary_key() const { return quantity.symbol.code().raw(); }
+    };
+
+    typedef multi_index<"vaultmined"_n, st_vault_mined> tb_vault_mined;
 
     struct [[eosio::table]] st_defi_queue
     {
@@ -104,6 +210,16 @@ public:
 
     typedef multi_index<"queue"_n, st_defi_queue> tb_defi_queue;
 
+    // queued withdrawals not yet paid out, scoped by token contract
+    struct [[eosio::table]] st_defi_reserved
+    {
+        eosio::asset quantity;
+
+        uint64_t primary_key() const { return quantity.symbol.code().raw(); }
+    };
+
+    typedef multi_index<"reserved"_n, st_defi_reserved> tb_defi_reserved;
+
 
     struct transfer_args
     {
@@ -138,47 +254,50 @@ public:
 
     typedef multi_index<"defipools"_n, st_defi_pools> tb_defi_pools;
 
-    struct [[eosio::table]] st_liquidity_log
+    struct [[eosio::table]] st_swap_log
     {
-        uint64_t log_id;
+        uint64_t swap_id;
+        uint64_t third_id;
         eosio::name account;
         uint64_t liquidity_id;
-        uint64_t liquidity_token;
         token_t in_token;
         token_t out_token;
         eosio::asset in_asset;
         eosio::asset out_asset;
-        string type;
+        float_t price;
         uint64_t timestamp;
         checksum256 trx_id;
 
-        uint64_t primary_key() const { return log_id; }
+        uint64_t primary_key() const { return swap_id; }
+        uint64_t third_key() const { return third_id; }
     };
 
-    typedef multi_index<"liquiditylog"_n, st_liquidity_log> tb_liquidity_log;
+    typedef multi_index<"swaplog"_n, st_swap_log,
+                        indexed_by<"bythirdkey"_n, const_mem_fun<st_swap_log, uint64_t,
+                                                                 &st_swap_log::third_key>>>
+        tb_swap_log;
 
-    struct [[eosio::table]] st_swap_log
+    // compact swap log: tokens and symbols come from the liquidity row,
+    // direction 1 is token1 -> token2 and 2 is token2 -> token1
+    struct [[eosio::table]] st_swap_log_v2
     {
         uint64_t swap_id;
         uint64_t third_id;
         eosio::name account;
         uint64_t liquidity_id;
-        token_t in_token;
-        token_t out_token;
-        eosio::asset in_asset;
-        eosio::asset out_asset;
-        float_t price;
-        uint64_t timestamp;
-        checksum256 trx_id;
+        uint8_t direction;
+        int64_t in_amount;
+        int64_t out_amount;
+        uint32_t timestamp;
 
         uint64_t primary_key() const { return swap_id; }
         uint64_t third_key() const { return third_id; }
     };
 
-    typedef multi_index<"swaplog"_n, st_swap_log,
-                        indexed_by<"bythirdkey"_n, const_mem_fun<st_swap_log, uint64_t,
-                                                                 &st_swap_log::third_key>>>
-        tb_swap_log;
+    typedef multi_index<"swaplogv2"_n, st_swap_log_v2,
+                        indexed_by<"bythirdkey"_n, const_mem_fun<st_swap_log_v2, uint64_t,
+                                                                 &st_swap_log_v2::third_key>>>
+        tb_swap_log_v2;
 
     struct swap_t
     {
@@ -187,7 +306,52 @@ public:
         uint64_t code;
     };
 
+    // liquidity minted by a zap and the pool tokens it could not place
+    struct zap_t
+    {
+        uint64_t liquidity_token;
+        asset left1;
+        asset left2;
+        uint64_t token1;
+        uint64_t token2;
+    };
+
+    // one market mining position, account is the venue it is deposited in;
+    // settled1/settled2 collect the "marketsettle,<mine_id>" transfers covering a loss
     struct [[eosio::table]] st_market_info
+    {
+        uint64_t mine_id;
+        uint64_t liquidity_id;
+        eosio::name account;
+
+        eosio::asset in_token1;
+        eosio::asset in_token2;
+
+        uint64_t liquidity_token;
+        symbol liquidity_symbol;
+
+        eosio::asset out_token1;
+        eosio::asset out_token2;
+
+        eosio::asset profit;
+
+        eosio::asset settled1;
+        eosio::asset settled2;
+
+        uint64_t timestamp;
+        uint64_t status;
+
+        uint64_t primary_key() const { return mine_id; }
+        uint64_t venue_key() const { return account.value; }
+    };
+
+    typedef multi_index<"marketpos"_n, st_market_info,
+                        indexed_by<"byvenue"_n, const_mem_fun<st_market_info, uint64_t,
+                                                              &st_market_info::venue_key>>>
+        tb_market_info;
+
+    // position row before marketpos, read only by upgrade
+    struct [[eosio::table]] st_market_info_v1
     {
         uint64_t liquidity_id;
         eosio::name account;
@@ -209,7 +373,17 @@ public:
         uint64_t primary_key() const { return liquidity_id; }
     };
 
-    typedef multi_index<"marketinfo"_n, st_market_info> tb_market_info;
+    typedef multi_index<"marketinfo"_n, st_market_info_v1> tb_market_info_v1;
+
+    // next_id numbers positions and their logs; active_id is the position the
+    // last market action worked on, which venue transfers in that transaction settle into
+    struct [[eosio::table]] st_market_config
+    {
+        uint64_t next_id;
+        uint64_t active_id;
+    };
+
+    typedef singleton<"marketcfg"_n, st_market_config> tb_market_config;
 
     struct [[eosio::table]] st_market_log
     {
@@ -235,6 +409,71 @@ public:
 
     typedef multi_index<"marketlog"_n, st_market_log> tb_market_log;
 
+    // ring of the last 100 settled positions: a position takes slot mine_id % 100
+    // unless a higher mine_id already holds it, so a late settlement of an old
+    // position never displaces a newer one
+    struct [[eosio::table]] st_market_ring
+    {
+        uint64_t mine_id;
+        eosio::name account;
+        uint64_t liquidity_id;
+
+        eosio::asset in_token1;
+        eosio::asset in_token2;
+
+        uint64_t liquidity_token;
+
+        eosio::asset out_token1;
+        eosio::asset out_token2;
+
+        eosio::asset profit;
+
+        uint64_t begin_timestamp;
+        uint64_t end_timestamp;
+
+        uint64_t primary_key() const { return mine_id % 100; }
+    };
+
+    typedef multi_index<"marketring"_n, st_market_ring> tb_market_ring;
+
+    // external dex market mining can deposit into, keyed by its swap contract.
+    // Deposits are two transfers with deposit_memo (",<pool id>" appended when
+    // deposit_id) around a deposit(self, pool id) action, sent first when
+    // deposit_first. LP tokens come from lptoken and are exited by sending them
+    // back; without lptoken the exit is a withdraw(self, pool id, amount) action.
+    // The *_memo matchers select what a transfer from the venue settles.
+    struct [[eosio::table]] st_market_venue
+    {
+        eosio::name account;
+        eosio::name lptoken;
+        eosio::name claim;
+        eosio::name reward;
+        eosio::name reward_from;
+
+        string deposit_memo;
+        bool deposit_id;
+        bool deposit_first;
+
+        string refund_memo;
+        string withdraw_memo;
+        string lpissue_memo;
+
+        uint64_t primary_key() const { return account.value; }
+    };
+
+    typedef multi_index<"venue"_n, st_market_venue> tb_market_venue;
+
+    // every account a venue sends transfers from, so an inbound transfer costs one lookup
+    struct [[eosio::table]] st_market_sender
+    {
+        eosio::name sender;
+        eosio::name venue;
+
+        uint64_t primary_key() const { return sender.value; }
+    };
+
+    typedef multi_index<"venuesender"_n, st_market_sender> tb_market_sender;
+
     struct [[eosio::table]] account
     {
         asset balance;
@@ -254,50 +493,156 @@ public:
 
     [[eosio::action]] void reserve(name account, uint64_t liquidity_id, uint64_t liquidity_token);
 
+    [[eosio::action]] void lptransfer(name from, name to, uint64_t liquidity_id, uint64_t liquidity_token);
+
+    [[eosio::action]] void lpenable(uint64_t liquidity_id);
+
+    [[eosio::action]] void wraplp(name account, uint64_t liquidity_id, uint64_t liquidity_token);
+
+    [[eosio::action]] void unwraplp(name account, uint64_t liquidity_id, uint64_t liquidity_token);
+
+    [[eosio::action("transfer")]] void lptokentransfer(name from, name to, asset quantity, string memo);
+
+    [[eosio::action]] void addliqmin(name account, uint64_t liquidity_id, uint64_t min_lp, uint32_t deadline);
+
+    [[eosio::action]] void subliqmin(name account, uint64_t liquidity_id, uint64_t liquidity_token,
+                                     uint64_t min_amount1, uint64_t min_amount2, uint32_t deadline);
+
+    [[eosio::action]] void reservemin(name account, uint64_t liquidity_id, uint64_t liquidity_token,
+                                      uint64_t min_amount1, uint64_t min_amount2, uint32_t deadline);
+
     [[eosio::action]] void claim(name account, uint64_t queue_id);
 
+    [[eosio::action]] void processqueue(uint64_t max_items);
+
     [[eosio::action]] void remove(uint64_t id);
 
     [[eosio::action]] void updateweight(uint64_t liquidity_id, uint64_t type, float weight);
 
+    [[eosio::action]] void setcurve(uint64_t liquidity_id, uint64_t kind, uint64_t param1, uint64_t param2);
+
+    [[eosio::action]] void updatefee(uint64_t liquidity_id, uint64_t swap_fee, uint64_t fund_fee, uint64_t divd_fee);
+
+    [[eosio::action]] void vaultopen(uint64_t liquidity_id);
+
+    [[eosio::action]] void compound(uint64_t liquidity_id, uint64_t min_lp);
+
+    [[eosio::action]] void vaultexit(name account, uint64_t liquidity_id, uint64_t shares);
+
+    [[eosio::action]] void vaultclaim();
+
+    [[eosio::action]] void vaultharvest(uint64_t liquidity_id, name contract, asset quantity, uint64_t slippage,
+                                        string route);
+
+    [[eosio::action]] void flashswap(name account, uint64_t liquidity_id, asset amount_out, name callback, string data);
+
+    [[eosio::action]] void flashcheck(uint64_t liquidity_id);
+
     [[eosio::action]] void marketmine(name account, uint64_t liquidity_id, uint64_t to_liquidity_id, asset quantity1, asset quantity2);
-    [[eosio::action]] void marketexit(string memo, uint64_t amount);
-    [[eosio::action]] void marketclaim();
+    [[eosio::action]] void marketexit(uint64_t mine_id, string memo, uint64_t amount);
+    [[eosio::action]] void marketclaim(uint64_t mine_id);
+
+    [[eosio::action]] void marketsettle(uint64_t mine_id);
 
-    [[eosio::action]] void marketsettle();
+    [[eosio::action]] void setvenue(st_market_venue venue);
+
+    [[eosio::action]] void rmvenue(name account);
+
+    [[eosio::action]] void upgrade();
 
     [[eosio::action]] void refund(name account, checksum256 trx_id);
 
+    [[eosio::action]] void migratelog(uint64_t max_rows);
+
+    [[eosio::action]] void backfill(uint64_t liquidity_id, uint64_t max_rows);
+
+    [[eosio::action]] void event(std::vector<char> data);
+
 private:
     void _addliquidity(name from, name to, asset quantity, string memo);
     
-    void _subliquidity(name account, uint64_t liquidity_id, uint64_t liquidity_token, bool is_reserve);
+    void _subliquidity(name account, uint64_t liquidity_id, uint64_t liquidity_token, bool is_reserve,
+                       name receiver, uint64_t min_amount1, uint64_t min_amount2);
+
+    symbol _lp_symbol(uint64_t liquidity_id);
+    uint64_t _lp_liquidity_id(symbol sym);
+    void _sub_balance(name owner, asset value);
+    void _add_balance(name owner, asset value, name ram_payer);
 
-    void _marketclaim_box();
-    void _marketexit_box(uint64_t liquidity_token, symbol symbol_code, string memo);
+    void _addliq(name account, uint64_t liquidity_id, uint64_t min_lp, bool capped);
+    uint64_t _mint(name account, uint64_t liquidity_id, asset &quantity1, asset &quantity2, bool capped);
 
-    void _marketexit_dfs(uint64_t liquidity_token, uint64_t liquidity_id);
+    void _vaultdeposit(name from, asset quantity, std::vector<std::string> &params);
+    void _vaultreward(name from, asset quantity, std::vector<std::string> &params);
+    void _vaultcredit(name from, uint64_t liquidity_id, swap_t reward, uint64_t slippage, const string &route);
+    void _vaultmined(asset quantity);
+    uint64_t _vault_liquidity(uint64_t liquidity_id);
+    uint64_t _pending_value(const st_defi_liquidity &liquidity, const asset &quantity1, const asset &quantity2,
+                            bool up);
 
-    void _handle_box(name from, name to, asset quantity, string memo);
-    void _handle_dfs(name from, name to, asset quantity, string memo);
-    void _handle_refund(asset quantity);
-    void _handle_withdraw(asset quantity);
+    void _flashrepay(asset quantity, std::vector<std::string> &params);
+
+    void _check_flash(uint64_t liquidity_id);
+
+    void _add_reserved(name contract, asset quantity);
+    void _sub_reserved(name contract, asset quantity);
+    void _check_reserved(name contract, const asset &quantity);
+
+    void _setvenue(const st_market_venue &venue);
+    void _handle_venue(const st_market_venue &venue, name from, asset quantity, const string &memo);
+    void _marketcredit(asset quantity, std::vector<std::string> &params);
+
+    void _handle_refund(name venue, asset quantity);
+    void _handle_withdraw(name venue, asset quantity);
+
+    tb_market_info::const_iterator _get_market(tb_market_info &market_info, name venue);
+    uint64_t _new_market_id();
+    void _set_market_active(uint64_t mine_id);
 
     void swapmine(name account, uint64_t code, asset quantity, uint64_t liquidity_id);
 
     void swap(name account, asset quantity, std::vector<std::string> & params);
 
-    swap_t _swap(name account, swap_t & swapin, uint64_t liquidity_id, uint64_t slippage, uint64_t third_id);
+    swap_t _hop(name account, swap_t swapdata, uint64_t liquidity_id, uint64_t slippage, uint64_t third_id);
+
+    void _zapin(name account, asset quantity, std::vector<std::string> &params);
+    uint64_t _zap_amount(uint64_t reserve, uint64_t amount, uint64_t fee);
+    zap_t _zap(name account, uint64_t liquidity_id, swap_t in);
 
-    void _swaplog(name account, uint64_t third_id, uint64_t liquidity_id,
-                  token_t in_token, token_t out_token, asset in_asset,
-                  asset out_asset, asset fee, float_t price);
+    swap_t _route(name account, swap_t swapdata, const std::vector<std::string> &liquidity_ids,
+                  uint64_t slippage, uint64_t third_id);
+
+    swap_t _swap(name account, swap_t & swapin, uint64_t liquidity_id, uint64_t slippage, uint64_t third_id,
+                 const st_defi_fee &fee);
+
+    st_defi_fee _get_fee(uint64_t liquidity_id);
+
+    st_defi_curve _get_curve(uint64_t liquidity_id);
+
+    // d: set to the invariant solved for stable pools, for _get_price on the same reserves
+    uint64_t _get_amount_out(const st_defi_liquidity &liquidity, const st_defi_curve &curve,
+                             bool in_token1, const asset &in_quantity, uint64_t swap_fee, curve::u128 &d);
+
+    curve::range_t _get_range(const st_defi_liquidity &liquidity, const st_defi_curve &curve,
+                              const asset &quantity1, const asset &quantity2);
+
+    curve::u128 _get_stable_d(const st_defi_liquidity &liquidity, const st_defi_curve &curve,
+                              const asset &quantity1, const asset &quantity2);
+
+    void _get_rates(const st_defi_liquidity &liquidity, uint64_t &rate1, uint64_t &rate2);
+
+    // d: the stable invariant of the reserves when already solved, 0 to solve it
+    double _get_price(const st_defi_liquidity &liquidity, const st_defi_curve &curve, curve::u128 d = 0);
+
+    void _swaplog(name account, uint64_t third_id, uint64_t liquidity_id, uint8_t direction,
+                  asset in_asset, asset out_asset, asset fee);
 
     void _liquiditylog(name account, uint64_t liquidity_id, string type,
-                       token_t in_token, token_t out_token, asset in_asset,
-                       asset out_asset, uint64_t liquidity_token,
+                       asset in_asset, asset out_asset, uint64_t liquidity_token,
                        asset in_balance, asset out_balance, uint64_t balance_ltoken);
 
+    void _emit();
+
     void _transfer_to(name to, uint64_t code, asset quantity, string memo);
 
     uint64_t _get_swap_id();
@@ -308,8 +653,6 @@ private:
 
     checksum256 _get_trx_id();
 
-    std::vector<eosio::action> _get_actions();
-
     void _transfer_to(name to, uint64_t amount, symbol coin_code, string memo);
 
     void _newpair(uint64_t liquidity_id, const token_t &token1, const token_t &token2);
@@ -319,8 +662,9 @@ private:
     tb_defi_config _defi_config;
     tb_defi_liquidity _defi_liquidity;
 
-    tb_swap_log _swap_log;
-    tb_liquidity_log _liquidity_log;
+    tb_swap_log_v2 _swap_log;
+
+    events::writer _events;
 
 public:
     static uint64_t code;
@@ -223,7 +223,7 @@ void onesgame::init()
 
     require_auth(get_self());
 
-    st_defi_config defi_config = _defi_config.get_or_create(
+    _defi_config.get_or_create(
         _self,
         st_defi_config{
             .stake_quantity = asset(0, ONES_TOKEN_SYMBOL),
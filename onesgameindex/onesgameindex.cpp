@@ -0,0 +1,471 @@
+#include "onesgameindex.hpp"
+
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+indexer::indexer(const std::string &dir, uint32_t interval)
+    : dir(dir), interval(interval)
+{
+    mkdir(dir.c_str(), 0755);
+
+    _pools.open(dir + "/pools");
+    for (uint64_t i = 0; i < _pools.size(); i++)
+        pool_index[_pools[i].liquidity_id] = i;
+
+    _positions.open(dir + "/positions");
+    for (uint64_t i = 0; i < _positions.size(); i++)
+        position_index[{_positions[i].account, _positions[i].liquidity_id}] = i;
+
+    _markets.open(dir + "/markets");
+}
+
+uint64_t indexer::ingest(FILE *in)
+{
+    std::vector<char> frame;
+    uint64_t records = 0;
+    uint32_t timestamp;
+
+    while (fread(&timestamp, sizeof(timestamp), 1, in) == 1)
+    {
+        uint64_t size = 0;
+        int c, shift = 0;
+        while ((c = fgetc(in)) != EOF)
+        {
+            size |= (uint64_t)(c & 0x7f) << shift;
+            shift += 7;
+            if (!(c & 0x80))
+                break;
+        }
+        if (c == EOF)
+            break;
+
+        frame.resize(size);
+        if (fread(frame.data(), 1, size, in) != size)
+            break;
+
+        apply(timestamp, frame.data(), size);
+        records++;
+    }
+    return records;
+}
+
+uint64_t indexer::ingest_text(FILE *in)
+{
+    std::vector<char> frame;
+    uint64_t records = 0;
+    char *line = nullptr;
+    size_t cap = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &cap, in)) > 0)
+    {
+        char *hex = nullptr;
+        uint32_t timestamp = strtoul(line, &hex, 10);
+        while (*hex == ' ')
+            hex++;
+
+        frame.clear();
+        for (char *p = hex; p[0] != 0 && p[1] != 0 && p[0] != '\n'; p += 2)
+        {
+            char byte[3] = {p[0], p[1], 0};
+            frame.push_back((char)strtoul(byte, nullptr, 16));
+        }
+
+        apply(timestamp, frame.data(), frame.size());
+        records++;
+    }
+    free(line);
+    return records;
+}
+
+void indexer::apply(uint32_t timestamp, const char *frame, size_t size)
+{
+    events::reader reader(frame, size);
+
+    while (!reader.done())
+    {
+        uint8_t type = reader.next();
+        if (type == events::SWAP)
+        {
+            events::swap_event e;
+            reader.read(e);
+            if (!reader.ok())
+                break;
+
+            uint64_t amount1 = e.direction == 1 ? e.in_amount : e.out_amount;
+            uint64_t amount2 = e.direction == 1 ? e.out_amount : e.in_amount;
+            double price = _price(e.liquidity_id, amount1, amount2);
+
+            // the time column stays sorted for lower_bound: a swap behind the last candle is dropped
+            series_t &s = _series(e.liquidity_id);
+            uint32_t start = timestamp - timestamp % interval;
+            if (s.time.size() > 0 && start < s.time.back())
+            {
+                stale++;
+            }
+            else
+            {
+                if (s.time.size() == 0 || s.time.back() != start)
+                {
+                    s.time.push_back(start);
+                    s.candle.push_back(candle_t{price, price, price, price, 0, 0, 0});
+                }
+                candle_t &c = s.candle.back();
+                c.high = std::max(c.high, price);
+                c.low = std::min(c.low, price);
+                c.close = price;
+                c.volume1 += amount1;
+                c.volume2 += amount2;
+                c.trades++;
+            }
+
+            position_t &p = _position(e.account, e.liquidity_id);
+            p.volume1 += amount1;
+            p.volume2 += amount2;
+            p.swaps++;
+        }
+        else if (type == events::LIQUIDITY)
+        {
+            events::liquidity_event e;
+            reader.read(e);
+            if (!reader.ok())
+                break;
+
+            position_t &p = _position(e.account, e.liquidity_id);
+            p.liquidity_token = e.balance_ltoken;
+            p.balance1 = e.balance1;
+            p.balance2 = e.balance2;
+        }
+        else if (type == events::NEWLIQUIDITY)
+        {
+            events::newliquidity_event e;
+            reader.read(e);
+            if (!reader.ok())
+                break;
+
+            if (pool_index.find(e.liquidity_id) == pool_index.end())
+            {
+                pool_index[e.liquidity_id] = _pools.size();
+                _pools.push_back(e);
+            }
+        }
+        else if (type == events::MARKET)
+        {
+            events::market_event e;
+            reader.read(e);
+            if (!reader.ok())
+                break;
+
+            double in1 = _scale(e.liquidity_id, e.in_amount1, true);
+            double in2 = _scale(e.liquidity_id, e.in_amount2, false);
+            double out1 = _scale(e.liquidity_id, e.out_amount1, true);
+            double out2 = _scale(e.liquidity_id, e.out_amount2, false);
+
+            // pool prices at open and settle, the deposit and withdraw ratios when the pool never traded
+            double open = _price_at(e.liquidity_id, e.begin_time, in1 > 0 ? in2 / in1 : 0);
+            double close = _price_at(e.liquidity_id, e.end_time, out1 > 0 ? out2 / out1 : open);
+
+            _markets.push_back(market_t{e, in1 * open + in2, in1 * close + in2, out1 * close + out2});
+        }
+        else if (!reader.skip(type))
+        {
+            break;
+        }
+        events++;
+    }
+}
+
+// price of token1 in token2, scaled by the symbol precisions once the pool is known
+double indexer::_price(uint64_t liquidity_id, uint64_t amount1, uint64_t amount2)
+{
+    if (amount1 == 0)
+        return 0;
+
+    double price = (double)amount2 / amount1;
+    auto it = pool_index.find(liquidity_id);
+    if (it != pool_index.end())
+    {
+        const auto &pool = _pools[it->second];
+        price *= std::pow(10.0, (int)(pool.symbol1 & 0xff) - (int)(pool.symbol2 & 0xff));
+    }
+    return price;
+}
+
+// amount in display units of the pool's token1 or token2, raw when the pool is unknown
+double indexer::_scale(uint64_t liquidity_id, uint64_t amount, bool token1)
+{
+    auto it = pool_index.find(liquidity_id);
+    if (it == pool_index.end())
+        return amount;
+
+    const auto &pool = _pools[it->second];
+    return amount / std::pow(10.0, (int)((token1 ? pool.symbol1 : pool.symbol2) & 0xff));
+}
+
+// close of the last candle starting at or before timestamp
+double indexer::_price_at(uint64_t liquidity_id, uint32_t timestamp, double fallback)
+{
+    series_t *s = _find_series(liquidity_id);
+    if (s == nullptr)
+        return fallback;
+    uint64_t i = s->time.lower_bound(timestamp - timestamp % interval + 1);
+    return i == 0 ? fallback : s->candle[i - 1].close;
+}
+
+series_t &indexer::_series(uint64_t liquidity_id)
+{
+    auto it = series.find(liquidity_id);
+    if (it != series.end())
+        return it->second;
+
+    series_t &s = series[liquidity_id];
+    std::string prefix = dir + "/pool." + std::to_string(liquidity_id);
+    s.time.open(prefix + ".time");
+    s.candle.open(prefix + ".candle");
+    return s;
+}
+
+series_t *indexer::_find_series(uint64_t liquidity_id)
+{
+    auto it = series.find(liquidity_id);
+    if (it != series.end())
+        return &it->second;
+
+    series_t &s = series[liquidity_id];
+    std::string prefix = dir + "/pool." + std::to_string(liquidity_id);
+    if (s.time.open(prefix + ".time", false) && s.candle.open(prefix + ".candle", false))
+        return &s;
+
+    series.erase(liquidity_id);
+    return nullptr;
+}
+
+position_t &indexer::_position(uint64_t account, uint64_t liquidity_id)
+{
+    auto key = std::make_pair(account, liquidity_id);
+    auto it = position_index.find(key);
+    if (it != position_index.end())
+        return _positions[it->second];
+
+    position_index[key] = _positions.size();
+    _positions.push_back(position_t{account, liquidity_id, 0, 0, 0, 0, 0, 0});
+    return _positions.back();
+}
+
+void indexer::candles(uint64_t liquidity_id, uint32_t from, uint32_t to, FILE *out)
+{
+    series_t *s = _find_series(liquidity_id);
+    if (s == nullptr)
+        return;
+    for (uint64_t i = s->time.lower_bound(from); i < s->time.size() && s->time[i] < to; i++)
+    {
+        const candle_t &c = s->candle[i];
+        fprintf(out, "%u %.10g %.10g %.10g %.10g %llu %llu %llu\n", s->time[i],
+                c.open, c.high, c.low, c.close, (unsigned long long)c.volume1,
+                (unsigned long long)c.volume2, (unsigned long long)c.trades);
+    }
+}
+
+void indexer::positions(uint64_t account, FILE *out)
+{
+    auto it = position_index.lower_bound({account, 0});
+    for (; it != position_index.end() && it->first.first == account; it++)
+    {
+        const position_t &p = _positions[it->second];
+        fprintf(out, "%llu %llu %llu %llu %llu %llu %llu\n",
+                (unsigned long long)p.liquidity_id, (unsigned long long)p.liquidity_token,
+                (unsigned long long)p.balance1, (unsigned long long)p.balance2,
+                (unsigned long long)p.volume1, (unsigned long long)p.volume2,
+                (unsigned long long)p.swaps);
+    }
+}
+
+void indexer::pools(FILE *out)
+{
+    for (uint64_t i = 0; i < _pools.size(); i++)
+    {
+        const auto &p = _pools[i];
+        fprintf(out, "%llu %s %s\n", (unsigned long long)p.liquidity_id,
+                name_to_string(p.contract1).c_str(), name_to_string(p.contract2).c_str());
+    }
+}
+
+// positions settled in [from, to): return on entry value, annualized,
+// and impermanent loss against holding the deposit
+void indexer::markets(uint32_t from, uint32_t to, FILE *out)
+{
+    fprintf(out, "# mine_id venue liquidity_id begin end return annualized impermanent_loss reward symbol\n"
+                 "# return and impermanent_loss leave out the settled1/settled2 loss cover and the reward's value\n");
+    for (uint64_t i = 0; i < _markets.size(); i++)
+    {
+        const market_t &m = _markets[i];
+        const events::market_event &e = m.event;
+        if (e.end_time < from || e.end_time >= to || m.entry <= 0 || m.hold <= 0)
+            continue;
+
+        double ret = m.exit / m.entry - 1;
+        double years = (e.end_time - e.begin_time) / (365.0 * 86400);
+        fprintf(out, "%llu %s %llu %u %u %.6f %.6f %.6f %llu %s\n",
+                (unsigned long long)e.mine_id, name_to_string(e.venue).c_str(),
+                (unsigned long long)e.liquidity_id, e.begin_time, e.end_time,
+                ret, years > 0 ? ret / years : 0, m.exit / m.hold - 1,
+                (unsigned long long)e.reward_amount, symbol_to_string(e.reward_symbol).c_str());
+    }
+}
+
+// the same per venue: positions weighted by entry value, and by entry value times duration for the yield
+void indexer::venues(uint32_t from, uint32_t to, FILE *out)
+{
+    struct total_t
+    {
+        uint64_t positions;
+        double entry;
+        double hold;
+        double exit;
+        double weighted_years;
+        std::map<uint64_t, uint64_t> rewards;
+    };
+    std::map<uint64_t, total_t> totals;
+
+    for (uint64_t i = 0; i < _markets.size(); i++)
+    {
+        const market_t &m = _markets[i];
+        const events::market_event &e = m.event;
+        if (e.end_time < from || e.end_time >= to || m.entry <= 0 || m.hold <= 0)
+            continue;
+
+        total_t &t = totals[e.venue];
+        t.positions++;
+        t.entry += m.entry;
+        t.hold += m.hold;
+        t.exit += m.exit;
+        t.weighted_years += m.entry * (e.end_time - e.begin_time) / (365.0 * 86400);
+        if (e.reward_amount > 0)
+            t.rewards[e.reward_symbol] += e.reward_amount;
+    }
+
+    fprintf(out, "# venue positions return annualized impermanent_loss [reward symbol]...\n"
+                 "# return and impermanent_loss leave out the settled1/settled2 loss cover and the reward's value\n");
+    for (const auto &it : totals)
+    {
+        const total_t &t = it.second;
+        fprintf(out, "%s %llu %.6f %.6f %.6f", name_to_string(it.first).c_str(),
+                (unsigned long long)t.positions, t.exit / t.entry - 1,
+                t.weighted_years > 0 ? (t.exit - t.entry) / t.weighted_years : 0,
+                t.exit / t.hold - 1);
+        for (const auto &r : t.rewards)
+            fprintf(out, " %llu %s", (unsigned long long)r.second, symbol_to_string(r.first).c_str());
+        fprintf(out, "\n");
+    }
+}
+
+static const char *charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+
+std::string name_to_string(uint64_t value)
+{
+    std::string str(13, '.');
+    uint64_t tmp = value;
+    for (int i = 0; i <= 12; i++)
+    {
+        char c = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+        str[12 - i] = c;
+        tmp >>= (i == 0 ? 4 : 5);
+    }
+    str.erase(str.find_last_not_of('.') + 1);
+    return str;
+}
+
+uint64_t string_to_name(const std::string &str)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < 13 && i < str.size(); i++)
+    {
+        const char *p = strchr(charmap, str[i]);
+        uint64_t c = p == nullptr ? 0 : p - charmap;
+        if (i < 12)
+            value |= (c & 0x1f) << (64 - 5 * (i + 1));
+        else
+            value |= c & 0x0f;
+    }
+    return value;
+}
+
+std::string symbol_to_string(uint64_t value)
+{
+    std::string str;
+    for (value >>= 8; value > 0; value >>= 8)
+        str.push_back((char)(value & 0xff));
+    return str;
+}
+
+static int usage()
+{
+    fprintf(stderr,
+            "usage: onesgameindex <dir> ingest [-t] [file]\n"
+            "       onesgameindex <dir> candles <liquidity_id> <from> <to>\n"
+            "       onesgameindex <dir> positions <account>\n"
+            "       onesgameindex <dir> pools\n"
+            "       onesgameindex <dir> markets <from> <to>\n"
+            "       onesgameindex <dir> venues <from> <to>\n"
+            "env INTERVAL sets the candle width in seconds (default 60)\n");
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+        return usage();
+
+    const char *interval = getenv("INTERVAL");
+    indexer index(argv[1], interval ? atoi(interval) : 60);
+    std::string cmd = argv[2];
+
+    if (cmd == "ingest")
+    {
+        bool text = argc > 3 && std::string(argv[3]) == "-t";
+        const char *path = argc > (text ? 4 : 3) ? argv[text ? 4 : 3] : "-";
+        FILE *in = std::string(path) == "-" ? stdin : fopen(path, "rb");
+        if (in == nullptr)
+            return usage();
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t records = text ? index.ingest_text(in) : index.ingest(in);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        fprintf(stderr, "%llu records, %llu events in %.3f s, %.0f events/sec, %llu swaps older than their candles\n",
+                (unsigned long long)records, (unsigned long long)index.events, secs,
+                secs > 0 ? index.events / secs : 0, (unsigned long long)index.stale);
+        return 0;
+    }
+    if (cmd == "candles" && argc == 6)
+    {
+        index.candles(strtoull(argv[3], nullptr, 10), strtoul(argv[4], nullptr, 10),
+                      strtoul(argv[5], nullptr, 10), stdout);
+        return 0;
+    }
+    if (cmd == "positions" && argc == 4)
+    {
+        index.positions(string_to_name(argv[3]), stdout);
+        return 0;
+    }
+    if ((cmd == "markets" || cmd == "venues") && argc == 5)
+    {
+        uint32_t from = strtoul(argv[3], nullptr, 10);
+        uint32_t to = strtoul(argv[4], nullptr, 10);
+        if (cmd == "markets")
+            index.markets(from, to, stdout);
+        else
+            index.venues(from, to, stdout);
+        return 0;
+    }
+    if (cmd == "pools")
+    {
+        index.pools(stdout);
+        return 0;
+    }
+    return usage();
+}
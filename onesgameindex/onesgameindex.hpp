@@ -0,0 +1,190 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <events.hpp>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// append-only memory mapped column: [count:u64][T]*
+template <typename T>
+class column
+{
+public:
+    column() {}
+    column(const column &) = delete;
+    ~column() { close(); }
+
+    // false when create is off and there is no such file
+    bool open(const std::string &path, bool create = true)
+    {
+        fd = ::open(path.c_str(), create ? O_RDWR | O_CREAT : O_RDWR, 0644);
+        if (fd < 0 && !create && errno == ENOENT)
+            return false;
+        if (fd < 0)
+            throw std::runtime_error("open " + path);
+
+        struct stat st;
+        fstat(fd, &st);
+        size_t capacity = st.st_size > (off_t)sizeof(uint64_t) ? (st.st_size - sizeof(uint64_t)) / sizeof(T) : 0;
+        map(capacity < 1024 ? 1024 : capacity);
+        return true;
+    }
+
+    void close()
+    {
+        if (base != nullptr)
+            munmap(base, bytes);
+        if (fd >= 0)
+            ::close(fd);
+        base = nullptr;
+        fd = -1;
+    }
+
+    uint64_t size() const { return base == nullptr ? 0 : *(uint64_t *)base; }
+    T &operator[](uint64_t i) { return data()[i]; }
+    const T &operator[](uint64_t i) const { return data()[i]; }
+    T &back() { return data()[size() - 1]; }
+
+    void push_back(const T &v)
+    {
+        uint64_t n = size();
+        if (n == capacity)
+            map(capacity * 2);
+        data()[n] = v;
+        *(uint64_t *)base = n + 1;
+    }
+
+    // first index whose value is >= v, for a column sorted ascending
+    uint64_t lower_bound(const T &v) const
+    {
+        uint64_t lo = 0, hi = size();
+        while (lo < hi)
+        {
+            uint64_t mid = (lo + hi) / 2;
+            if (data()[mid] < v)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+private:
+    T *data() const { return (T *)((char *)base + sizeof(uint64_t)); }
+
+    void map(size_t new_capacity)
+    {
+        if (base != nullptr)
+            munmap(base, bytes);
+
+        bytes = sizeof(uint64_t) + new_capacity * sizeof(T);
+        if (ftruncate(fd, bytes) != 0)
+            throw std::runtime_error("ftruncate");
+
+        base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED)
+            throw std::runtime_error("mmap");
+        capacity = new_capacity;
+    }
+
+    int fd = -1;
+    void *base = nullptr;
+    size_t bytes = 0;
+    size_t capacity = 0;
+};
+
+struct candle_t
+{
+    double open;
+    double high;
+    double low;
+    double close;
+    uint64_t volume1;
+    uint64_t volume2;
+    uint64_t trades;
+};
+
+struct position_t
+{
+    uint64_t account;
+    uint64_t liquidity_id;
+    uint64_t liquidity_token;
+    uint64_t balance1;
+    uint64_t balance2;
+    uint64_t volume1;
+    uint64_t volume2;
+    uint64_t swaps;
+};
+
+// return of a settled market mining position, amounts in token2 display units
+struct market_t
+{
+    events::market_event event;
+    double entry;
+    double hold;
+    double exit;
+};
+
+// per pool candle series: candle start times, ascending, and the candle at the same index
+struct series_t
+{
+    column<uint32_t> time;
+    column<candle_t> candle;
+};
+
+class indexer
+{
+public:
+    indexer(const std::string &dir, uint32_t interval);
+
+    // one record is [timestamp:u32][length:varint][event frame]
+    uint64_t ingest(FILE *in);
+    // one record per line: "<timestamp> <event frame hex>"
+    uint64_t ingest_text(FILE *in);
+
+    void apply(uint32_t timestamp, const char *frame, size_t size);
+
+    void candles(uint64_t liquidity_id, uint32_t from, uint32_t to, FILE *out);
+    void positions(uint64_t account, FILE *out);
+    void pools(FILE *out);
+    void markets(uint32_t from, uint32_t to, FILE *out);
+    void venues(uint32_t from, uint32_t to, FILE *out);
+
+    uint64_t events = 0;
+    // swaps older than their pool's last candle, left out of the candles
+    uint64_t stale = 0;
+
+private:
+    series_t &_series(uint64_t liquidity_id);
+    // the series of a pool if one was written, for read paths that must not create it
+    series_t *_find_series(uint64_t liquidity_id);
+    position_t &_position(uint64_t account, uint64_t liquidity_id);
+    double _price(uint64_t liquidity_id, uint64_t amount1, uint64_t amount2);
+    double _price_at(uint64_t liquidity_id, uint32_t timestamp, double fallback);
+    double _scale(uint64_t liquidity_id, uint64_t amount, bool token1);
+
+    std::string dir;
+    uint32_t interval;
+
+    column<events::newliquidity_event> _pools;
+    column<position_t> _positions;
+    column<market_t> _markets;
+
+    std::unordered_map<uint64_t, uint64_t> pool_index;
+    std::map<std::pair<uint64_t, uint64_t>, uint64_t> position_index;
+    std::map<uint64_t, series_t> series;
+};
+
+std::string name_to_string(uint64_t value);
+uint64_t string_to_name(const std::string &str);
+std::string symbol_to_string(uint64_t value);
@@ -8,19 +8,17 @@
 #define ONES_DEFI_ACCOUNT "onesgamedefi"
 #define ONES_PLAY_ACCOUNT "onesgameplay"
 
-#define BOX_TOKEN_ACCOUNT "token.defi"
-#define BOX_TOKEN_SYMBOL symbol("BOX", 6)
+const size_t ONES_TOKEN = 0;
 
-#define DFS_TOKEN_ACCOUNT "minedfstoken"
-#define DFS_TOKEN_SYMBOL symbol("DFS", 4)
+// oauth bits: the grant the oauth action has always stored, only read off chain /
+// rewards stream over VEST_SECONDS, set by the stream action
+const uint8_t OAUTH_GRANT = 1;
+const uint8_t OAUTH_STREAM = 2;
 
-const symbol token_symbols[] = {ONES_TOKEN_SYMBOL, BOX_TOKEN_SYMBOL,
-                                DFS_TOKEN_SYMBOL};
+const uint64_t VEST_SECONDS = 7 * 24 * 3600;
 
 uint64_t default_swap_time = 1598961600;
 
-const uint64_t TOKENNUM = 3;
-
 #define ACCOUNT_CHECK(account) \
     eosio_assert(is_account(account), "invalid account " #account);
 
@@ -38,44 +36,27 @@ void split(const std::string &str, char delimiter,
     params.push_back(str.substr(prev));
 }
 
-uint64_t get_token_offset(symbol type)
+void add_amounts(amounts_t &array1, const amounts_t &array2)
 {
-    for (int i = 0; i < TOKENNUM; i++)
+    if (array1.size() < array2.size())
     {
-        if (token_symbols[i] == type)
-        {
-            return i;
-        }
+        array1.resize(array2.size());
     }
-    eosio_assert(false, "invalid token type");
-    return 99999999999999;
-}
-
-void init_amounts(vector<uint64_t> &array)
-{
-    for (int i = array.size(); i < TOKENNUM; i++)
-    {
-        array.push_back(0);
-    }
-}
-
-void add_amounts(vector<uint64_t> &array1, vector<uint64_t> &array2)
-{
-    init_amounts(array1);
-    for (int i = 0; i < array2.size(); i++)
+    for (size_t i = 0; i < array2.size(); i++)
     {
         array1[i] += array2[i];
     }
 }
 
-void reset_amounts(vector<uint64_t> &array)
+void add_amount(amounts_t &array, uint64_t token, uint64_t amount)
 {
-    for (int i = 0; i < array.size(); i++)
+    if (array.size() <= token)
     {
-        array[i] = 0;
+        array.resize(token + 1);
     }
-    init_amounts(array);
+    array[token] += amount;
 }
+
 void onesgame::transfer(name from, name to, asset quantity, string memo)
 {
     ACCOUNT_CHECK(from);
@@ -88,11 +69,18 @@ void onesgame::transfer(name from, name to, asset quantity, string memo)
         return;
     }
 
-    if (quantity.symbol == BOX_TOKEN_SYMBOL)
+    tb_reward_token _reward_token(get_self(), get_self().value);
+    _seed_tokens(_reward_token);
+    auto index = _reward_token.get_index<"bycontract"_n>();
+    for (auto it = index.find(get_code().value); it != index.end() && it->contract == get_code(); it++)
     {
-        st_defi_config defi_config = _defi_config.get();
-        defi_config.market_quantity[1] += quantity.amount;
-        _defi_config.set(defi_config, _self);
+        if (it->sym == quantity.symbol && it->credit && !it->retired)
+        {
+            st_defi_config defi_config = _defi_config.get();
+            add_amount(defi_config.market_quantity, it->id, quantity.amount);
+            _defi_config.set(defi_config, _self);
+            return;
+        }
     }
 }
 
@@ -100,14 +88,77 @@ void onesgame::init()
 {
     require_auth(eosio::name(ONES_PLAY_ACCOUNT));
 
-    return;
+    tb_reward_token _reward_token(get_self(), get_self().value);
+    _seed_tokens(_reward_token);
+}
+
+// Every reader of the token table seeds it first, so a contract upgraded
+// without pushing init credits and pays out the defaults in their usual slots.
+void onesgame::_seed_tokens(tb_reward_token &table)
+{
+    if (table.begin() != table.end())
+    {
+        return;
+    }
+
+    uint64_t id = 0;
+    for (const reward_token_t &reward : reward_tokens)
+    {
+        table.emplace(get_self(), [&](auto &t) {
+            t.id = id++;
+            t.sym = reward.sym;
+            t.contract = reward.contract;
+            t.credit = reward.credit;
+            t.retired = false;
+        });
+    }
+}
+
+void onesgame::addtoken(symbol sym, name contract)
+{
+    require_auth(eosio::name(ONES_PLAY_ACCOUNT));
+
+    eosio_assert(sym.is_valid(), "invalid symbol");
+    ACCOUNT_CHECK(contract);
+
+    tb_reward_token _reward_token(get_self(), get_self().value);
+    _seed_tokens(_reward_token);
+    auto index = _reward_token.get_index<"bycontract"_n>();
+    for (auto it = index.find(contract.value); it != index.end() && it->contract == contract; it++)
+    {
+        eosio_assert(it->sym != sym || it->retired, "token has been registered");
+    }
+
+    auto last = _reward_token.rbegin();
+    _reward_token.emplace(get_self(), [&](auto &t) {
+        t.id = last->id + 1;
+        t.sym = sym;
+        t.contract = contract;
+        t.credit = true;
+        t.retired = false;
+    });
+}
+
+void onesgame::retiretoken(uint64_t id)
+{
+    require_auth(eosio::name(ONES_PLAY_ACCOUNT));
+
+    eosio_assert(id != ONES_TOKEN, "invalid token");
+
+    tb_reward_token _reward_token(get_self(), get_self().value);
+    _seed_tokens(_reward_token);
+    auto it = _reward_token.find(id);
+    eosio_assert(it != _reward_token.end() && !it->retired, "invalid token");
+
+    _reward_token.modify(it, _self, [&](auto &t) { t.retired = true; });
 }
 
 void onesgame::upgrade()
 {
     require_auth(eosio::name(ONES_PLAY_ACCOUNT));
 
-    return;
+    tb_reward_token _reward_token(get_self(), get_self().value);
+    _seed_tokens(_reward_token);
 }
 
 void onesgame::oauth(name account, uint8_t status)
@@ -118,45 +169,38 @@ void onesgame::oauth(name account, uint8_t status)
     if (it != _defi_account.end())
     {
         _defi_account.modify(it, _self, [&](auto &t) {
-            t.oauth = status > 0 ? 1 : 0;
+            t.oauth = (t.oauth & OAUTH_STREAM) | (status > 0 ? OAUTH_GRANT : 0);
         });
     }
 
     return;
 }
 
-void onesgame::_transfer_to(name to, uint64_t amount, symbol coin_code,
+void onesgame::stream(name account, bool on)
+{
+    require_auth(account);
+
+    auto it = _defi_account.find(account.value);
+    eosio_assert((it != _defi_account.end()), "invalid account");
+
+    _defi_account.modify(it, _self, [&](auto &t) {
+        t.oauth = on ? t.oauth | OAUTH_STREAM : t.oauth & ~OAUTH_STREAM;
+    });
+}
+
+void onesgame::_transfer_to(name to, asset quantity, name contract,
                             string memo)
 {
-    if (amount == 0)
+    if (quantity.amount == 0)
     {
         return;
     }
 
-    if (coin_code == ONES_TOKEN_SYMBOL)
-    {
-        eosio::action(
-            permission_level{get_self(), "active"_n},
-            eosio::name(ONES_TOKEN_ACCOUNT), "transfer"_n,
-            make_tuple(get_self(), to, asset(amount, ONES_TOKEN_SYMBOL), memo))
-            .send();
-    }
-    else if (coin_code == BOX_TOKEN_SYMBOL)
-    {
-        eosio::action(
-            permission_level{get_self(), "active"_n},
-            eosio::name(BOX_TOKEN_ACCOUNT), "transfer"_n,
-            make_tuple(get_self(), to, asset(amount, BOX_TOKEN_SYMBOL), memo))
-            .send();
-    }
-    else if (coin_code == DFS_TOKEN_SYMBOL)
-    {
-        eosio::action(
-            permission_level{get_self(), "active"_n},
-            eosio::name(DFS_TOKEN_ACCOUNT), "transfer"_n,
-            make_tuple(get_self(), to, asset(amount, DFS_TOKEN_SYMBOL), memo))
-            .send();
-    }
+    eosio::action(
+        permission_level{get_self(), "active"_n},
+        contract, "transfer"_n,
+        make_tuple(get_self(), to, quantity, memo))
+        .send();
 }
 
 void onesgame::issue(name to, asset quantity, string memo)
@@ -174,8 +218,6 @@ void onesgame::issue(name to, asset quantity, string memo)
         eosio_assert(quantity.amount == 360000, "invalid quantity");
 
         eosio_assert(params.size() == 3, "invalid memo");
-        uint64_t round = atoll(params.at(1).c_str());
-        uint64_t total = atoll(params.at(2).c_str());
 
         uint64_t cur_time = now();
         st_defi_config defi_config = _defi_config.get();
@@ -233,7 +275,7 @@ void onesgame::mineswap(name account, asset quantity)
         total_swap_quantity - airdrop_swap_quantity;
     defi_config.swap_suply += airdrop_swap_quantity;
     uint64_t market_quantity = (airdrop_swap_quantity / 2);
-    defi_config.market_quantity[0] += market_quantity;
+    defi_config.market_quantity[ONES_TOKEN] += market_quantity;
     defi_config.swap_time = cur_time;
 
     _defi_config.set(defi_config, _self);
@@ -250,23 +292,21 @@ void onesgame::mineswap(name account, asset quantity)
     {
         _defi_account.emplace(get_self(), [&](auto &t) {
             t.account = account;
-            init_amounts(t.market_quantity);
-            init_amounts(t.quantity);
             t.swap_quantity = asset(airdrop_swap_quantity, ONES_TOKEN_SYMBOL);
             t.mine_quantity = asset(quantity.amount, EOS_TOKEN_SYMBOL);
             t.timestamp = now();
         });
     }
 
-    this->_transfer_to(account, airdrop_swap_quantity, ONES_TOKEN_SYMBOL,
-                       "swap mine");
+    this->_transfer_to(account, asset(airdrop_swap_quantity, ONES_TOKEN_SYMBOL),
+                       name(ONES_TOKEN_ACCOUNT), "swap mine");
 }
 
 void onesgame::minemarkets()
 {
     require_auth(name(ONES_PLAY_ACCOUNT));
     st_defi_config defi_config = _defi_config.get();
-    eosio_assert(defi_config.market_quantity[0] > 10000, "market quantity is zero");
+    eosio_assert(defi_config.market_quantity[ONES_TOKEN] > 10000, "market quantity is zero");
 
     uint64_t round_id = 1;
     auto it = _defi_market.rbegin();
@@ -297,7 +337,7 @@ void onesgame::minemarkets()
     });
 
     add_amounts(defi_config.market_suply, defi_config.market_quantity);
-    reset_amounts(defi_config.market_quantity);
+    defi_config.market_quantity.assign(defi_config.market_quantity.size(), 0);
 
     _defi_config.set(defi_config, _self);
 
@@ -312,24 +352,20 @@ void onesgame::_syncmarket(uint64_t round_id, uint64_t &total_amount, uint64_t &
     tb_defi_liquidity _defi_liquidity(name(ONES_DEFI_ACCOUNT),
                                       name(ONES_DEFI_ACCOUNT).value);
     auto lit = _defi_liquidity.begin();
-    map<uint64_t, float> liquidities;
+    map<uint64_t, st_defi_liquidity> liquidities;
 
     while (lit != _defi_liquidity.end())
     {
-        if (lit->liquidity_weight > 0)
+        if (lit->liquidity_weight > 0 && lit->liquidity_token > 0)
         {
-            liquidities[lit->liquidity_id] = lit->liquidity_weight;
+            liquidities[lit->liquidity_id] = *lit;
         }
         lit++;
     }
 
-    tb_defi_pool _defi_pool(name(ONES_DEFI_ACCOUNT),
-                            name(ONES_DEFI_ACCOUNT).value);
-    auto pit = _defi_pool.begin();
-
     tb_defi_round _defi_round(get_self(), get_self().value);
 
-    std::map<uint64_t, float>::iterator mit;
+    std::map<uint64_t, st_defi_liquidity>::iterator mit;
     uint64_t id = 1;
     auto idx = _defi_round.rbegin();
     if (idx != _defi_round.rend())
@@ -337,13 +373,19 @@ void onesgame::_syncmarket(uint64_t round_id, uint64_t &total_amount, uint64_t &
         id = idx->id + 1;
     }
 
-    while (pit != _defi_pool.end())
+    // positions are read from the pools' defipools scopes, so a position moved by
+    // lptransfer mines for its current owner. Shares wrapped into LP tokens leave
+    // those scopes and do not mine until they are unwrapped. A position weighs its
+    // share of reserve1: quantity1 is what was deposited less what was withdrawn
+    // at later prices, and goes negative once the price moves
+    for (mit = liquidities.begin(); mit != liquidities.end(); mit++)
     {
-        mit = liquidities.find(pit->liquidity_id);
-        if (mit != liquidities.end())
+        const st_defi_liquidity &liquidity = mit->second;
+        tb_defi_pools _defi_pools(name(ONES_DEFI_ACCOUNT), mit->first);
+        for (auto pit = _defi_pools.begin(); pit != _defi_pools.end(); pit++)
         {
-            auto ait = _defi_round.find(pit->account.value);
-            uint64_t amount = pit->quantity1.amount * mit->second;
+            uint64_t share = (unsigned __int128)pit->liquidity_token * liquidity.reserve1 / liquidity.liquidity_token;
+            uint64_t amount = share * liquidity.liquidity_weight;
             total_amount += amount;
             _defi_round.emplace(get_self(), [&](auto &t) {
                 t.id = id++;
@@ -353,7 +395,6 @@ void onesgame::_syncmarket(uint64_t round_id, uint64_t &total_amount, uint64_t &
             });
             total_user++;
         }
-        pit++;
     }
 }
 void onesgame::minemarket(uint64_t round_id)
@@ -379,7 +420,7 @@ void onesgame::minemarket(uint64_t round_id)
     _defi_market.modify(market, _self, [&](auto &t) { t.executed = market->total; });
 }
 
-void onesgame::_minemarket(uint64_t round_id, name account, const vector<uint64_t> &quantity, float factor)
+void onesgame::_minemarket(uint64_t round_id, name account, const amounts_t &quantity, float factor)
 {
     auto it = _defi_account.find(account.value);
 
@@ -388,27 +429,21 @@ void onesgame::_minemarket(uint64_t round_id, name account, const vector<uint64_
         eosio_assert(round_id >= it->market_round, "invalid round");
 
         _defi_account.modify(it, _self, [&](auto &t) {
-            init_amounts(t.quantity);
-            for (uint64_t i = 0; i < quantity.size(); i++)
+            for (size_t i = 0; i < quantity.size(); i++)
             {
-                uint64_t amount = quantity[i] * factor;
-                t.quantity[i] += amount;
+                add_amount(t.quantity, i, quantity[i] * factor);
             }
             t.market_round = round_id;
         });
     }
     else
     {
-        eosio_assert(it->market_round != round_id, "market has been mined");
-
         _defi_account.emplace(get_self(), [&](auto &t) {
             t.account = account;
-            init_amounts(t.quantity);
-            init_amounts(t.market_quantity);
-            for (uint64_t i = 0; i < quantity.size(); i++)
+            t.quantity.assign(quantity.size(), 0);
+            for (size_t i = 0; i < quantity.size(); i++)
             {
-                uint64_t amount = quantity[i] * factor;
-                t.quantity[i] += amount;
+                t.quantity[i] = quantity[i] * factor;
             }
             t.swap_quantity = asset(0, ONES_TOKEN_SYMBOL);
             t.mine_quantity = asset(0, EOS_TOKEN_SYMBOL);
@@ -426,19 +461,106 @@ void onesgame::claim(name account)
     auto it = _defi_account.find(account.value);
     eosio_assert((it != _defi_account.end()), "invalid account");
 
-    vector<uint64_t> quantity = it->quantity;
+    amounts_t quantity = it->quantity;
     _defi_account.modify(it, _self, [&](auto &t) {
-        reset_amounts(t.quantity);
+        t.quantity.assign(t.quantity.size(), 0);
         add_amounts(t.market_quantity, quantity);
     });
 
-    for (uint64_t i = 0; i < quantity.size(); i++)
+    // streamed accounts move what accrued into their schedules, and every
+    // schedule pays out what has vested, whether streaming is still on or not
+    bool stream = it->oauth & OAUTH_STREAM;
+    amounts_t payout = stream ? amounts_t() : quantity;
+
+    tb_vesting _vesting(get_self(), account.value);
+    vector<uint64_t> tokens;
+    for (auto vit = _vesting.begin(); vit != _vesting.end(); vit++)
+    {
+        tokens.push_back(vit->token);
+    }
+    for (size_t i = 0; stream && i < quantity.size(); i++)
+    {
+        if (quantity[i] > 0 && _vesting.find(i) == _vesting.end())
+        {
+            tokens.push_back(i);
+        }
+    }
+
+    for (uint64_t token : tokens)
+    {
+        uint64_t amount = stream && token < quantity.size() ? quantity[token] : 0;
+        add_amount(payout, token, _vest(account, token, amount));
+    }
+
+    tb_reward_token _reward_token(get_self(), get_self().value);
+    _seed_tokens(_reward_token);
+    for (size_t i = 0; i < payout.size(); i++)
     {
-        this->_transfer_to(account, quantity[i], token_symbols[i],
-                           "market mine");
+        if (payout[i] == 0)
+        {
+            continue;
+        }
+        const auto &token = _reward_token.get(i, "invalid token type");
+        this->_transfer_to(account, asset(payout[i], token.sym), token.contract, "market mine");
     }
 }
 
+// Pays out what vested on the token's schedule since the last claim. A new
+// amount joins a running schedule and vests with the unvested rest by its end,
+// so claiming never pushes the end out; without one it starts a schedule
+// ending VEST_SECONDS from now. Returns the amount to pay.
+uint64_t onesgame::_vest(name account, uint64_t token, uint64_t amount)
+{
+    tb_vesting _vesting(get_self(), account.value);
+    auto it = _vesting.find(token);
+    uint64_t cur_time = now();
+
+    // every claim rebases the schedule on now, so all that vested since start is due
+    uint64_t payout = 0;
+    uint64_t remaining = amount;
+    if (it != _vesting.end())
+    {
+        payout = cur_time >= it->end
+                     ? it->total
+                     : (unsigned __int128)it->total * (cur_time - it->start) / (it->end - it->start);
+        remaining += it->total - payout;
+    }
+
+    if (remaining == 0)
+    {
+        if (it != _vesting.end())
+        {
+            _vesting.erase(it);
+        }
+    }
+    else if (it != _vesting.end() && cur_time < it->end)
+    {
+        // rebased on now with the same end, the rest vests along the same line
+        _vesting.modify(it, _self, [&](auto &t) {
+            t.start = cur_time;
+            t.total = remaining;
+        });
+    }
+    else
+    {
+        auto start = [&](auto &t) {
+            t.token = token;
+            t.start = cur_time;
+            t.end = cur_time + VEST_SECONDS;
+            t.total = remaining;
+        };
+        if (it == _vesting.end())
+        {
+            _vesting.emplace(get_self(), start);
+        }
+        else
+        {
+            _vesting.modify(it, _self, start);
+        }
+    }
+    return payout;
+}
+
 extern "C"
 {
     void apply(uint64_t receiver, uint64_t code, uint64_t action)
@@ -454,7 +576,7 @@ extern "C"
             switch (action)
             {
                 EOSIO_DISPATCH_HELPER(onesgame, (mineswap)(minemarket)(minemarkets)(
-                                                    claim)(init)(upgrade)(oauth))
+                                                    claim)(init)(upgrade)(oauth)(stream)(addtoken)(retiretoken))
             }
             return;
         }
@@ -467,10 +589,9 @@ extern "C"
             return;
         }
 
-        if (code == eosio::name(BOX_TOKEN_ACCOUNT).value &&
-            action == eosio::name("transfer").value)
+        if (action == eosio::name("transfer").value)
         {
-            execute_action(eosio::name(receiver), eosio::name(receiver),
+            execute_action(eosio::name(receiver), eosio::name(code),
                            &onesgame::transfer);
             return;
         }
@@ -12,6 +12,25 @@
 using namespace eosio;
 using namespace std;
 
+// Reward tokens the rewardtokens table is seeded with, later ones are added
+// with addtoken: a token's position is its slot in every amounts_t, credit
+// marks the tokens venues send in to be mined out. Only the table is read.
+struct reward_token_t
+{
+    eosio::symbol sym;
+    eosio::name contract;
+    bool credit;
+};
+
+constexpr reward_token_t reward_tokens[] = {
+    {symbol("ONES", 4), "eosonestoken"_n, false},
+    {symbol("BOX", 6), "token.defi"_n, true},
+    {symbol("DFS", 4), "minedfstoken"_n, true},
+};
+
+// reward amounts by token slot, shorter than the token table until a slot is first used
+typedef vector<uint64_t> amounts_t;
+
 // contract
 class [[eosio::contract("onesgamemine")]] onesgame : public contract
 {
@@ -45,6 +64,12 @@ public:
 
     [[eosio::action]] void oauth(name account, uint8_t status);
 
+    [[eosio::action]] void stream(name account, bool on);
+
+    [[eosio::action]] void addtoken(symbol sym, name contract);
+
+    [[eosio::action]] void retiretoken(uint64_t id);
+
     void issue(name to, asset quantity, string memo);
 
     void transfer(name from, name to, asset quantity, string memo);
@@ -56,19 +81,20 @@ public:
         uint64_t swap_suply;
         uint64_t swap_counter;
         uint64_t swap_issue;
-        vector<uint64_t> market_suply;
+        amounts_t market_suply;
         uint64_t market_time;
         uint64_t last_swap_suply;
-        vector<uint64_t> market_quantity;
+        amounts_t market_quantity;
         uint64_t market_issue;
     };
     typedef singleton<"config"_n, st_defi_config> tb_defi_config;
 
+    // oauth holds OAUTH_* bits chosen by the account
     struct [[eosio::table]] st_defi_account
     {
         eosio::name account;
-        vector<uint64_t> quantity;
-        vector<uint64_t> market_quantity;
+        amounts_t quantity;
+        amounts_t market_quantity;
 
         asset swap_quantity;
         asset mine_quantity;
@@ -85,7 +111,7 @@ public:
     {
         uint64_t round;
         uint64_t amount;
-        vector<uint64_t> quantity;
+        amounts_t quantity;
         uint64_t total;
         uint64_t executed;
         uint64_t timestamp;
@@ -116,6 +142,40 @@ public:
                                                  &st_defi_round::round_key>>>
         tb_defi_round;
 
+    // registered reward token, id is its slot; retired tokens are no longer
+    // credited but balances already mined in them can still be claimed
+    struct [[eosio::table]] st_reward_token
+    {
+        uint64_t id;
+        eosio::symbol sym;
+        eosio::name contract;
+        bool credit;
+        bool retired;
+
+        uint64_t primary_key() const { return id; }
+        uint64_t contract_key() const { return contract.value; }
+    };
+
+    typedef multi_index<
+        "rewardtokens"_n, st_reward_token,
+        indexed_by<"bycontract"_n, const_mem_fun<st_reward_token, uint64_t,
+                                                 &st_reward_token::contract_key>>>
+        tb_reward_token;
+
+    // linear vesting of one reward token, scoped by account: total vests from
+    // start to end; each claim pays what vested and rebases start on the claim
+    struct [[eosio::table]] st_vesting
+    {
+        uint64_t token;
+        uint64_t start;
+        uint64_t end;
+        uint64_t total;
+
+        uint64_t primary_key() const { return token; }
+    };
+
+    typedef multi_index<"vesting"_n, st_vesting> tb_vesting;
+
     struct token_t
     {
         name address;
@@ -127,54 +187,49 @@ public:
         EOSLIB_SERIALIZE(token_t, (address)(symbol))
     };
 
-    struct st_defi_pool
+    // onesgamedefi positions, scoped by liquidity_id
+    struct st_defi_pools
     {
-        uint64_t pool_id;
         eosio::name account;
-        uint64_t liquidity_id;
         uint64_t liquidity_token;
         eosio::asset quantity1;
         eosio::asset quantity2;
         uint64_t timestamp;
 
-        uint64_t primary_key() const { return pool_id; }
-        uint64_t account_key() const { return account.value; }
+        uint64_t primary_key() const { return account.value; }
     };
 
-    typedef multi_index<
-        "defipool"_n, st_defi_pool,
-        indexed_by<"byaccountkey"_n, const_mem_fun<st_defi_pool, uint64_t,
-                                                   &st_defi_pool::account_key>>>
-        tb_defi_pool;
+    typedef multi_index<"defipools"_n, st_defi_pools> tb_defi_pools;
 
+    // onesgamedefi pools, in its compact liquidityv2 layout
     struct st_defi_liquidity
     {
         uint64_t liquidity_id;
         token_t token1;
         token_t token2;
 
-        eosio::asset quantity1;
-        eosio::asset quantity2;
+        int64_t reserve1;
+        int64_t reserve2;
         uint64_t liquidity_token;
-        float_t price1;
-        float_t price2;
-        uint64_t cumulative1;
-        uint64_t cumulative2;
         float_t swap_weight;
         float_t liquidity_weight;
-        uint64_t timestamp;
+        uint32_t timestamp;
 
         uint64_t primary_key() const { return liquidity_id; }
     };
 
-    typedef multi_index<"liquidity"_n, st_defi_liquidity> tb_defi_liquidity;
+    typedef multi_index<"liquidityv2"_n, st_defi_liquidity> tb_defi_liquidity;
 
 private:
-    void _transfer_to(name to, uint64_t amount, symbol coin_code, string memo);
+    void _transfer_to(name to, asset quantity, name contract, string memo);
+
+    void _seed_tokens(tb_reward_token &table);
+
+    uint64_t _vest(name account, uint64_t token, uint64_t amount);
 
     void _syncmarket(uint64_t round_id, uint64_t & total_amount, uint64_t & total_user);
 
-    void _minemarket(uint64_t round_id, name account, const vector<uint64_t> &quantity, float factor);
+    void _minemarket(uint64_t round_id, name account, const amounts_t &quantity, float factor);
 
 private:
     tb_defi_account _defi_account;
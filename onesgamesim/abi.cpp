@@ -0,0 +1,480 @@
+#include "abi.hpp"
+#include "chain.hpp"
+
+#include <ctime>
+
+namespace sim
+{
+static const char *TOKEN_ABI = R"({
+    "structs": [
+        {"name": "account", "base": "", "fields": [{"name": "balance", "type": "asset"}]},
+        {"name": "currency_stats", "base": "", "fields": [{"name": "supply", "type": "asset"}, {"name": "max_supply", "type": "asset"}, {"name": "issuer", "type": "name"}]},
+        {"name": "create", "base": "", "fields": [{"name": "issuer", "type": "name"}, {"name": "maximum_supply", "type": "asset"}]},
+        {"name": "issue", "base": "", "fields": [{"name": "to", "type": "name"}, {"name": "quantity", "type": "asset"}, {"name": "memo", "type": "string"}]},
+        {"name": "retire", "base": "", "fields": [{"name": "quantity", "type": "asset"}, {"name": "memo", "type": "string"}]},
+        {"name": "transfer", "base": "", "fields": [{"name": "from", "type": "name"}, {"name": "to", "type": "name"}, {"name": "quantity", "type": "asset"}, {"name": "memo", "type": "string"}]},
+        {"name": "open", "base": "", "fields": [{"name": "owner", "type": "name"}, {"name": "symbol", "type": "symbol"}, {"name": "ram_payer", "type": "name"}]},
+        {"name": "close", "base": "", "fields": [{"name": "owner", "type": "name"}, {"name": "symbol", "type": "symbol"}]}
+    ],
+    "actions": [
+        {"name": "create", "type": "create"}, {"name": "issue", "type": "issue"}, {"name": "retire", "type": "retire"},
+        {"name": "transfer", "type": "transfer"}, {"name": "open", "type": "open"}, {"name": "close", "type": "close"}
+    ],
+    "tables": [{"name": "accounts", "type": "account"}, {"name": "stat", "type": "currency_stats"}]
+})";
+
+abi::abi(const json &def)
+{
+    if (const json *types = def.find("types"))
+        for (const auto &t : types->array)
+            _typedefs[t["new_type_name"].text] = t["type"].text;
+
+    for (const auto &s : def["structs"].array)
+    {
+        struct_def &d = _structs[s["name"].text];
+        d.base = s["base"].text;
+        for (const auto &f : s["fields"].array)
+            d.fields.push_back(field{f["name"].text, f["type"].text});
+    }
+
+    for (const auto &a : def["actions"].array)
+        _actions[eosio::name(a["name"].text).value] = a["type"].text;
+    for (const auto &t : def["tables"].array)
+        _tables[eosio::name(t["name"].text).value] = t["type"].text;
+}
+
+const abi &abi::token()
+{
+    static abi token_abi(json::parse(TOKEN_ABI));
+    return token_abi;
+}
+
+abi abi::read(const std::string &path)
+{
+    FILE *in = fopen(path.c_str(), "rb");
+    if (in == nullptr)
+        throw std::runtime_error("open " + path);
+
+    std::string text;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+        text.append(buf, n);
+    fclose(in);
+
+    // cleos get abi wraps the abi in {"account_name": ..., "abi": {...}}
+    json def = json::parse(text);
+    if (const json *inner = def.find("abi"))
+        return abi(*inner);
+    return abi(def);
+}
+
+std::string abi::pack_action(uint64_t action, const json &args) const
+{
+    auto a = _actions.find(action);
+    if (a == _actions.end())
+        throw std::runtime_error("abi has no action " + eosio::name(action).to_string());
+
+    // cleos takes the arguments as an object or in field order
+    std::string out;
+    if (args.kind == json::array_t)
+    {
+        const struct_def &s = _structs.at(_resolve(a->second));
+        if (args.array.size() != s.fields.size())
+            throw std::runtime_error(eosio::name(action).to_string() + " takes " + std::to_string(s.fields.size()) +
+                                     " arguments");
+        for (size_t i = 0; i < s.fields.size(); i++)
+            _pack(s.fields[i].type, args.array[i], out);
+        return out;
+    }
+    _pack(a->second, args, out);
+    return out;
+}
+
+std::string abi::pack_row(uint64_t table, const json &row) const
+{
+    auto t = _tables.find(table);
+    if (t == _tables.end())
+        throw std::runtime_error("abi has no table " + eosio::name(table).to_string());
+
+    std::string out;
+    _pack(t->second, row, out);
+    return out;
+}
+
+json abi::unpack_row(uint64_t table, const std::string &data) const
+{
+    auto t = _tables.find(table);
+    if (t == _tables.end())
+        throw std::runtime_error("abi has no table " + eosio::name(table).to_string());
+
+    const char *p = data.data();
+    return _unpack(t->second, p, p + data.size());
+}
+
+std::string abi::_resolve(std::string type) const
+{
+    for (auto t = _typedefs.find(type); t != _typedefs.end(); t = _typedefs.find(type))
+        type = t->second;
+    return type;
+}
+
+template <typename T>
+static void put(std::string &out, T v)
+{
+    out.append((const char *)&v, sizeof(v));
+}
+
+static void put_varuint(std::string &out, uint64_t v)
+{
+    do
+    {
+        uint8_t b = v & 0x7f;
+        v >>= 7;
+        out += (char)(b | (v ? 0x80 : 0));
+    } while (v);
+}
+
+template <typename T>
+static T get(const char *&p, const char *end)
+{
+    if ((size_t)(end - p) < sizeof(T))
+        throw std::runtime_error("abi: read past the end of the data");
+    T v;
+    memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+}
+
+static uint64_t get_varuint(const char *&p, const char *end)
+{
+    uint64_t v = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        uint8_t b = get<uint8_t>(p, end);
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return v;
+    }
+}
+
+static json number(const std::string &text)
+{
+    json v;
+    v.kind = json::number_t;
+    v.text = text;
+    return v;
+}
+
+static json string(const std::string &text)
+{
+    json v;
+    v.kind = json::string_t;
+    v.text = text;
+    return v;
+}
+
+// numbers may come quoted, cleos prints 64 bit values as strings
+static const std::string &number_text(const json &v)
+{
+    if (v.kind != json::number_t && v.kind != json::string_t)
+        throw std::runtime_error("abi: expected a number");
+    return v.text;
+}
+
+static uint64_t symbol_value(const std::string &s)
+{
+    // "4,EOS"
+    auto comma = s.find(',');
+    if (comma == std::string::npos)
+        throw std::runtime_error("abi: bad symbol " + s);
+    uint8_t precision = std::stoul(s.substr(0, comma));
+    return eosio::symbol(eosio::symbol_code(s.substr(comma + 1)), precision).raw();
+}
+
+static std::string symbol_text(uint64_t raw)
+{
+    eosio::symbol sym(raw);
+    return std::to_string(sym.precision()) + "," + sym.code().to_string();
+}
+
+static void put_asset(std::string &out, const std::string &s)
+{
+    // "1.0000 EOS"
+    auto space = s.find(' ');
+    if (space == std::string::npos)
+        throw std::runtime_error("abi: bad asset " + s);
+    std::string number = s.substr(0, space);
+    bool negative = !number.empty() && number[0] == '-';
+    if (negative)
+        number.erase(0, 1);
+
+    auto dot = number.find('.');
+    uint8_t precision = dot == std::string::npos ? 0 : number.size() - dot - 1;
+    if (dot != std::string::npos)
+        number.erase(dot, 1);
+    int64_t amount = number.empty() ? 0 : std::stoll(number);
+
+    put<int64_t>(out, negative ? -amount : amount);
+    put<uint64_t>(out, eosio::symbol(eosio::symbol_code(s.substr(space + 1)), precision).raw());
+}
+
+static time_t time_value(const json &v)
+{
+    if (v.kind == json::number_t)
+        return std::stoll(v.text);
+
+    struct tm tm = {};
+    if (strptime(v.text.c_str(), "%Y-%m-%dT%H:%M:%S", &tm) == nullptr)
+        throw std::runtime_error("abi: bad time " + v.text);
+    return timegm(&tm);
+}
+
+static std::string time_text(time_t t)
+{
+    char buf[32];
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+    return buf;
+}
+
+static size_t checksum_size(const std::string &type)
+{
+    if (type == "checksum160")
+        return 20;
+    if (type == "checksum256")
+        return 32;
+    if (type == "checksum512")
+        return 64;
+    return 0;
+}
+
+void abi::_pack(const std::string &raw_type, const json &v, std::string &out) const
+{
+    std::string type = _resolve(raw_type);
+
+    if (type.size() > 2 && type.compare(type.size() - 2, 2, "[]") == 0)
+    {
+        std::string element = type.substr(0, type.size() - 2);
+        if (v.kind != json::array_t)
+            throw std::runtime_error("abi: expected an array for " + type);
+        put_varuint(out, v.array.size());
+        for (const auto &e : v.array)
+            _pack(element, e, out);
+        return;
+    }
+    if (!type.empty() && type.back() == '?')
+    {
+        out += (char)(v.kind != json::null_t);
+        if (v.kind != json::null_t)
+            _pack(type.substr(0, type.size() - 1), v, out);
+        return;
+    }
+    if (!type.empty() && type.back() == '$')
+    {
+        if (v.kind != json::null_t)
+            _pack(type.substr(0, type.size() - 1), v, out);
+        return;
+    }
+
+    if (type == "bool")
+        out += (char)(v.kind == json::bool_t ? v.boolean : std::stoll(number_text(v)) != 0);
+    else if (type == "int8")
+        put<int8_t>(out, std::stoll(number_text(v)));
+    else if (type == "uint8")
+        put<uint8_t>(out, std::stoull(number_text(v)));
+    else if (type == "int16")
+        put<int16_t>(out, std::stoll(number_text(v)));
+    else if (type == "uint16")
+        put<uint16_t>(out, std::stoull(number_text(v)));
+    else if (type == "int32")
+        put<int32_t>(out, std::stoll(number_text(v)));
+    else if (type == "uint32")
+        put<uint32_t>(out, std::stoull(number_text(v)));
+    else if (type == "int64")
+        put<int64_t>(out, std::stoll(number_text(v)));
+    else if (type == "uint64")
+        put<uint64_t>(out, std::stoull(number_text(v)));
+    else if (type == "uint128" || type == "int128")
+    {
+        unsigned __int128 x = 0;
+        const std::string &text = number_text(v);
+        bool negative = !text.empty() && text[0] == '-';
+        for (size_t i = negative; i < text.size(); i++)
+            x = x * 10 + (text[i] - '0');
+        put(out, negative ? -x : x);
+    }
+    else if (type == "varuint32")
+        put_varuint(out, std::stoull(number_text(v)));
+    else if (type == "float32")
+        put<float>(out, std::stod(number_text(v)));
+    else if (type == "float64")
+        put<double>(out, std::stod(number_text(v)));
+    else if (type == "name")
+        put<uint64_t>(out, eosio::name(v.text).value);
+    else if (type == "symbol_code")
+        put<uint64_t>(out, eosio::symbol_code(v.text).raw());
+    else if (type == "symbol")
+        put<uint64_t>(out, symbol_value(v.text));
+    else if (type == "asset")
+        put_asset(out, v.text);
+    else if (type == "extended_asset")
+    {
+        put_asset(out, v["quantity"].text);
+        put<uint64_t>(out, eosio::name(v["contract"].text).value);
+    }
+    else if (type == "string")
+    {
+        put_varuint(out, v.text.size());
+        out += v.text;
+    }
+    else if (type == "bytes")
+    {
+        auto bytes = from_hex(v.text);
+        put_varuint(out, bytes.size());
+        out.append(bytes.data(), bytes.size());
+    }
+    else if (size_t size = checksum_size(type))
+    {
+        auto bytes = from_hex(v.text);
+        if (bytes.size() != size)
+            throw std::runtime_error("abi: " + type + " needs " + std::to_string(size) + " bytes");
+        out.append(bytes.data(), bytes.size());
+    }
+    else if (type == "time_point_sec")
+        put<uint32_t>(out, time_value(v));
+    else if (type == "time_point")
+        put<int64_t>(out, (int64_t)time_value(v) * 1000000);
+    else
+    {
+        auto s = _structs.find(type);
+        if (s == _structs.end())
+            throw std::runtime_error("abi: unknown type " + type);
+        if (!s->second.base.empty())
+            _pack(s->second.base, v, out);
+        for (const auto &f : s->second.fields)
+        {
+            const json *value = v.find(f.name);
+            if (value == nullptr && f.type.back() != '$')
+                throw std::runtime_error("abi: " + type + " needs " + f.name);
+            _pack(f.type, value == nullptr ? json() : *value, out);
+        }
+    }
+}
+
+json abi::_unpack(const std::string &raw_type, const char *&p, const char *end) const
+{
+    std::string type = _resolve(raw_type);
+
+    if (type.size() > 2 && type.compare(type.size() - 2, 2, "[]") == 0)
+    {
+        json v;
+        v.kind = json::array_t;
+        for (uint64_t n = get_varuint(p, end); n > 0; n--)
+            v.array.push_back(_unpack(type.substr(0, type.size() - 2), p, end));
+        return v;
+    }
+    if (!type.empty() && type.back() == '?')
+        return get<uint8_t>(p, end) ? _unpack(type.substr(0, type.size() - 1), p, end) : json();
+    if (!type.empty() && type.back() == '$')
+        return p == end ? json() : _unpack(type.substr(0, type.size() - 1), p, end);
+
+    if (type == "bool")
+    {
+        json v;
+        v.kind = json::bool_t;
+        v.boolean = get<uint8_t>(p, end) != 0;
+        return v;
+    }
+    if (type == "int8")
+        return number(std::to_string(get<int8_t>(p, end)));
+    if (type == "uint8")
+        return number(std::to_string(get<uint8_t>(p, end)));
+    if (type == "int16")
+        return number(std::to_string(get<int16_t>(p, end)));
+    if (type == "uint16")
+        return number(std::to_string(get<uint16_t>(p, end)));
+    if (type == "int32")
+        return number(std::to_string(get<int32_t>(p, end)));
+    if (type == "uint32")
+        return number(std::to_string(get<uint32_t>(p, end)));
+    if (type == "int64")
+        return number(std::to_string(get<int64_t>(p, end)));
+    if (type == "uint64")
+        return number(std::to_string(get<uint64_t>(p, end)));
+    if (type == "uint128" || type == "int128")
+    {
+        unsigned __int128 x = get<unsigned __int128>(p, end);
+        bool negative = type == "int128" && (__int128)x < 0;
+        if (negative)
+            x = -x;
+        std::string text;
+        do
+        {
+            text.insert(text.begin(), (char)('0' + (int)(x % 10)));
+            x /= 10;
+        } while (x);
+        return number(negative ? "-" + text : text);
+    }
+    if (type == "varuint32")
+        return number(std::to_string(get_varuint(p, end)));
+    if (type == "float32" || type == "float64")
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.17g", type == "float32" ? (double)get<float>(p, end) : get<double>(p, end));
+        return number(buf);
+    }
+    if (type == "name")
+        return string(eosio::name(get<uint64_t>(p, end)).to_string());
+    if (type == "symbol_code")
+        return string(eosio::symbol_code(get<uint64_t>(p, end)).to_string());
+    if (type == "symbol")
+        return string(symbol_text(get<uint64_t>(p, end)));
+    if (type == "asset")
+    {
+        int64_t amount = get<int64_t>(p, end);
+        return string(eosio::asset(amount, eosio::symbol(get<uint64_t>(p, end))).to_string());
+    }
+    if (type == "extended_asset")
+    {
+        json v;
+        v.kind = json::object_t;
+        v.object.emplace_back("quantity", _unpack("asset", p, end));
+        v.object.emplace_back("contract", _unpack("name", p, end));
+        return v;
+    }
+    if (type == "string" || type == "bytes")
+    {
+        uint64_t n = get_varuint(p, end);
+        if ((uint64_t)(end - p) < n)
+            throw std::runtime_error("abi: read past the end of the data");
+        std::string s(p, n);
+        p += n;
+        return string(type == "string" ? s : to_hex(s.data(), s.size()));
+    }
+    if (size_t size = checksum_size(type))
+    {
+        if ((size_t)(end - p) < size)
+            throw std::runtime_error("abi: read past the end of the data");
+        p += size;
+        return string(to_hex(p - size, size));
+    }
+    if (type == "time_point_sec")
+        return string(time_text(get<uint32_t>(p, end)));
+    if (type == "time_point")
+        return string(time_text(get<int64_t>(p, end) / 1000000));
+
+    auto s = _structs.find(type);
+    if (s == _structs.end())
+        throw std::runtime_error("abi: unknown type " + type);
+
+    json v;
+    v.kind = json::object_t;
+    if (!s->second.base.empty())
+        v = _unpack(s->second.base, p, end);
+    for (const auto &f : s->second.fields)
+        v.object.emplace_back(f.name, _unpack(f.type, p, end));
+    return v;
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <cstdint>
+#include <map>
+
+namespace sim
+{
+// converts action data and table rows between json and their packed form, the way
+// cleos does with a contract's abi
+class abi
+{
+public:
+    abi() {}
+    explicit abi(const json &def);
+
+    // eosio.token's actions and tables, for token contracts that ship no abi here
+    static const abi &token();
+
+    static abi read(const std::string &path);
+
+    bool has_action(uint64_t action) const { return _actions.count(action) > 0; }
+    bool has_table(uint64_t table) const { return _tables.count(table) > 0; }
+
+    std::string pack_action(uint64_t action, const json &args) const;
+    std::string pack_row(uint64_t table, const json &row) const;
+    json unpack_row(uint64_t table, const std::string &data) const;
+
+private:
+    struct field
+    {
+        std::string name;
+        std::string type;
+    };
+
+    struct struct_def
+    {
+        std::string base;
+        std::vector<field> fields;
+    };
+
+    std::map<std::string, std::string> _typedefs;
+    std::map<std::string, struct_def> _structs;
+    std::map<uint64_t, std::string> _actions;
+    std::map<uint64_t, std::string> _tables;
+
+    std::string _resolve(std::string type) const;
+    void _pack(const std::string &type, const json &v, std::string &out) const;
+    json _unpack(const std::string &type, const char *&p, const char *end) const;
+};
+}
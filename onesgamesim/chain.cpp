@@ -0,0 +1,660 @@
+#include "chain.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sim
+{
+// eosio_exit unwinds the contract without failing the action
+struct exit_signal
+{
+};
+
+static chain *_current = nullptr;
+
+std::vector<contract_type> &contracts()
+{
+    static std::vector<contract_type> list;
+    return list;
+}
+
+const contract_type *find_contract(uint64_t code)
+{
+    for (const auto &c : contracts())
+        if (c.account.value == code)
+            return &c;
+    return nullptr;
+}
+
+const table_type *find_table_type(uint64_t code, uint64_t table)
+{
+    // other token contracts keep eosio.token's tables
+    const contract_type *c = find_contract(code);
+    if (c == nullptr)
+        c = find_contract(eosio::name("eosio.token").value);
+    if (c == nullptr)
+        return nullptr;
+
+    for (const auto &t : c->tables)
+        if (t.table == table)
+            return &t;
+    return nullptr;
+}
+
+bool rw_set::conflicts(const rw_set &o) const
+{
+    for (const auto &w : writes)
+        if (o.writes.count(w) || o.reads.count(w))
+            return true;
+    for (const auto &w : o.writes)
+        if (reads.count(w))
+            return true;
+    return false;
+}
+
+chain &current()
+{
+    if (_current == nullptr)
+        throw std::runtime_error("no chain");
+    return *_current;
+}
+
+chain::chain()
+{
+    _current = this;
+    for (const auto &c : contracts())
+        deploy(c.account, c.apply);
+}
+
+chain::~chain()
+{
+    if (_current == this)
+        _current = nullptr;
+}
+
+void chain::create_account(eosio::name account) { accounts.insert(account.value); }
+
+bool chain::account_exists(eosio::name account) const { return lenient || accounts.count(account.value) > 0; }
+
+void chain::deploy(eosio::name account, apply_fn apply)
+{
+    create_account(account);
+    _code[account.value] = apply;
+}
+
+chain::context &chain::ctx()
+{
+    eosio_assert(!_contexts.empty(), "no action is executing");
+    return _contexts.back();
+}
+
+void chain::push(const eosio::action &act)
+{
+    eosio::transaction trx;
+    trx.actions.push_back(act);
+    push(trx);
+}
+
+void chain::push(const eosio::transaction &trx)
+{
+    _rw = rw_set();
+    _traces.clear();
+    _undo.clear();
+    _journaled.clear();
+    _packed_trx = eosio::pack(trx);
+    _trx = &trx;
+
+    try
+    {
+        eosio_assert(!trx.actions.empty(), "transaction must have at least one action");
+        for (const auto &act : trx.actions)
+            _execute(act, 0);
+    }
+    catch (const assertion &)
+    {
+        _rollback();
+        throw;
+    }
+    catch (const std::exception &e)
+    {
+        // a wasm trap on chain, e.g. std::vector::at past the end
+        _rollback();
+        throw assertion(std::string("trap: ") + e.what());
+    }
+
+    _undo.clear();
+    _journaled.clear();
+    _contexts.clear();
+    _trx = nullptr;
+}
+
+void chain::_execute(const eosio::action &act, uint32_t depth)
+{
+    eosio_assert(depth <= MAX_INLINE_DEPTH, "max inline action depth per transaction reached");
+
+    std::vector<uint64_t> notified{act.account.value};
+    std::vector<eosio::action> inlines;
+    for (size_t i = 0; i < notified.size(); i++)
+        _apply(act, notified[i], notified, inlines, depth);
+
+    for (const auto &a : inlines)
+        _execute(a, depth + 1);
+}
+
+void chain::_apply(const eosio::action &act, uint64_t receiver, std::vector<uint64_t> &notified,
+                   std::vector<eosio::action> &inlines, uint32_t depth)
+{
+    _traces.push_back(action_trace{eosio::name(receiver), act.account, act.name, depth});
+
+    auto code = _code.find(receiver);
+    if (code == _code.end())
+        return;
+
+    _contexts.push_back(context{&act, receiver, &notified, &inlines, depth});
+    try
+    {
+        code->second(receiver, act.account.value, act.name.value);
+    }
+    catch (const exit_signal &)
+    {
+    }
+    catch (const std::exception &e)
+    {
+        // say where it failed, as nodeos does in the action trace
+        _contexts.pop_back();
+        bool trap = dynamic_cast<const assertion *>(&e) == nullptr;
+        throw assertion(eosio::name(receiver).to_string() + " <= " + act.account.to_string() + "::" + act.name.to_string() +
+                        ": " + (trap ? "trap: " : "") + e.what());
+    }
+    _contexts.pop_back();
+}
+
+void chain::_rollback()
+{
+    for (auto u = _undo.rbegin(); u != _undo.rend(); ++u)
+    {
+        if (u->existed)
+            put_row(*u->t, u->pk, u->old);
+        else if (u->t->rows.count(u->pk))
+            erase_row(*u->t, u->pk);
+    }
+    _undo.clear();
+    _journaled.clear();
+    _contexts.clear();
+    _trx = nullptr;
+}
+
+void chain::journal(table &t, uint64_t pk)
+{
+    if (!_journaled.insert({(uint64_t)&t, pk}).second)
+        return;
+
+    auto r = t.rows.find(pk);
+    if (r == t.rows.end())
+        _undo.push_back(undo{&t, pk, false, row()});
+    else
+        _undo.push_back(undo{&t, pk, true, r->second});
+}
+
+void chain::record_read(const table_key &t, uint64_t pk, bool scan)
+{
+    if (record)
+        _rw.reads.insert(rw_key{t, scan ? 0 : pk, scan});
+}
+
+void chain::record_write(const table_key &t, uint64_t pk, bool scan)
+{
+    if (record)
+        _rw.writes.insert(rw_key{t, scan ? 0 : pk, scan});
+}
+
+void chain::_charge(uint64_t payer, int64_t bytes)
+{
+    if (bytes != 0)
+        ram[payer] += bytes;
+}
+
+int64_t chain::row_ram(const table &t, const row &r) const
+{
+    return RAM_ROW_BYTES + (int64_t)r.data.size() + (int64_t)t.index_count * RAM_INDEX64_BYTES;
+}
+
+// every secondary index is a table of its own
+int64_t chain::table_ram(const table &t) const
+{
+    int64_t bytes = t.rows.empty() ? 0 : RAM_TABLE_BYTES * (1 + (int64_t)t.index_count);
+    for (const auto &r : t.rows)
+        bytes += row_ram(t, r.second);
+    return bytes;
+}
+
+void chain::put_row(table &t, uint64_t pk, row r)
+{
+    auto old = t.rows.find(pk);
+    if (old != t.rows.end())
+    {
+        _charge(old->second.payer, -row_ram(t, old->second));
+        for (size_t i = 0; i < t.indices.size() && i < old->second.secondary.size(); i++)
+            t.indices[i].erase({old->second.secondary[i], pk});
+    }
+    else if (t.rows.empty())
+    {
+        t.payer = r.payer;
+        _charge(t.payer, RAM_TABLE_BYTES * (1 + (int64_t)t.index_count));
+    }
+
+    _charge(r.payer, row_ram(t, r));
+    for (size_t i = 0; i < t.indices.size() && i < r.secondary.size(); i++)
+        t.indices[i].insert({r.secondary[i], pk});
+    t.rows[pk] = std::move(r);
+}
+
+void chain::erase_row(table &t, uint64_t pk)
+{
+    auto old = t.rows.find(pk);
+    if (old == t.rows.end())
+        return;
+
+    _charge(old->second.payer, -row_ram(t, old->second));
+    for (size_t i = 0; i < t.indices.size() && i < old->second.secondary.size(); i++)
+        t.indices[i].erase({old->second.secondary[i], pk});
+    t.rows.erase(old);
+
+    if (t.rows.empty())
+        _charge(t.payer, -RAM_TABLE_BYTES * (1 + (int64_t)t.index_count));
+}
+
+void chain::build_indices(table &t, size_t count, const std::function<std::vector<uint64_t>(const row &)> &keys)
+{
+    // ram billed so far assumed the final index count
+    for (auto &r : t.rows)
+        _charge(r.second.payer, (int64_t)(count - t.index_count) * RAM_INDEX64_BYTES);
+    if (!t.rows.empty())
+        _charge(t.payer, (int64_t)(count - t.index_count) * RAM_TABLE_BYTES);
+
+    t.index_count = count;
+    t.indices.assign(count, {});
+    for (auto &r : t.rows)
+    {
+        r.second.secondary = keys(r.second);
+        for (size_t i = 0; i < count; i++)
+            t.indices[i].insert({r.second.secondary[i], r.first});
+    }
+
+    // rows journaled before the table was indexed must come back with their keys
+    for (auto &u : _undo)
+        if (u.t == &t && u.existed)
+            u.old.secondary = keys(u.old);
+    t.indexed = true;
+}
+
+static const char SNAPSHOT_MAGIC[8] = {'O', 'N', 'E', 'S', 'S', 'I', 'M', '1'};
+
+void chain::load(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("open " + path);
+
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = st.st_size;
+    const char *base = size == 0 ? nullptr : (const char *)mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED || size < sizeof(SNAPSHOT_MAGIC) + sizeof(uint64_t) ||
+        memcmp(base, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+    {
+        if (base != nullptr && base != MAP_FAILED)
+            munmap((void *)base, size);
+        throw std::runtime_error(path + " is not a snapshot");
+    }
+
+    const char *p = base + sizeof(SNAPSHOT_MAGIC);
+    const char *end = base + size;
+    auto read = [&](void *v, size_t n) {
+        if ((size_t)(end - p) < n)
+            throw std::runtime_error(path + " is truncated");
+        memcpy(v, p, n);
+        p += n;
+    };
+
+    uint64_t table_count;
+    read(&table_count, sizeof(table_count));
+    for (uint64_t i = 0; i < table_count; i++)
+    {
+        table_key key;
+        uint64_t payer, row_count;
+        read(&key.code, sizeof(uint64_t));
+        read(&key.scope, sizeof(uint64_t));
+        read(&key.table, sizeof(uint64_t));
+        read(&payer, sizeof(payer));
+        read(&row_count, sizeof(row_count));
+
+        table &t = tables[key];
+        t.code = key.code;
+        t.scope = key.scope;
+        t.name = key.table;
+        const table_type *type = find_table_type(key.code, key.table);
+        t.index_count = type == nullptr ? 0 : type->indices;
+
+        for (uint64_t j = 0; j < row_count; j++)
+        {
+            uint64_t pk;
+            uint32_t bytes;
+            row r;
+            read(&pk, sizeof(pk));
+            read(&r.payer, sizeof(r.payer));
+            read(&bytes, sizeof(bytes));
+            if ((size_t)(end - p) < bytes)
+                throw std::runtime_error(path + " is truncated");
+            r.data.assign(p, bytes);
+            p += bytes;
+            put_row(t, pk, std::move(r));
+        }
+        if (row_count > 0)
+        {
+            _charge(t.payer, -RAM_TABLE_BYTES * (1 + (int64_t)t.index_count));
+            t.payer = payer;
+            _charge(t.payer, RAM_TABLE_BYTES * (1 + (int64_t)t.index_count));
+        }
+    }
+
+    munmap((void *)base, size);
+}
+
+void chain::save(const std::string &path) const
+{
+    FILE *out = fopen(path.c_str(), "wb");
+    if (out == nullptr)
+        throw std::runtime_error("open " + path);
+
+    uint64_t table_count = 0;
+    for (const auto &t : tables)
+        table_count += !t.second.rows.empty();
+
+    fwrite(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC), 1, out);
+    fwrite(&table_count, sizeof(table_count), 1, out);
+    for (const auto &t : tables)
+    {
+        if (t.second.rows.empty())
+            continue;
+
+        uint64_t row_count = t.second.rows.size();
+        fwrite(&t.first.code, sizeof(uint64_t), 1, out);
+        fwrite(&t.first.scope, sizeof(uint64_t), 1, out);
+        fwrite(&t.first.table, sizeof(uint64_t), 1, out);
+        fwrite(&t.second.payer, sizeof(uint64_t), 1, out);
+        fwrite(&row_count, sizeof(row_count), 1, out);
+        for (const auto &r : t.second.rows)
+        {
+            uint32_t bytes = r.second.data.size();
+            fwrite(&r.first, sizeof(uint64_t), 1, out);
+            fwrite(&r.second.payer, sizeof(uint64_t), 1, out);
+            fwrite(&bytes, sizeof(bytes), 1, out);
+            fwrite(r.second.data.data(), bytes, 1, out);
+        }
+    }
+
+    if (fclose(out) != 0)
+        throw std::runtime_error("write " + path);
+}
+
+std::string to_hex(const char *data, size_t size)
+{
+    static const char *digits = "0123456789abcdef";
+    std::string r;
+    r.reserve(size * 2);
+    for (size_t i = 0; i < size; i++)
+    {
+        r += digits[(uint8_t)data[i] >> 4];
+        r += digits[(uint8_t)data[i] & 0x0f];
+    }
+    return r;
+}
+
+std::vector<char> from_hex(const std::string &hex)
+{
+    auto nibble = [&](char c) -> int {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        throw std::runtime_error("invalid hex " + hex);
+    };
+
+    if (hex.size() % 2)
+        throw std::runtime_error("odd length hex " + hex);
+    std::vector<char> r(hex.size() / 2);
+    for (size_t i = 0; i < r.size(); i++)
+        r[i] = (char)(nibble(hex[2 * i]) << 4 | nibble(hex[2 * i + 1]));
+    return r;
+}
+
+// FIPS 180-4
+static void _sha256(const uint8_t *data, size_t len, uint8_t out[32])
+{
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+    uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+    auto rotr = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+
+    std::vector<uint8_t> msg(data, data + len);
+    msg.push_back(0x80);
+    while (msg.size() % 64 != 56)
+        msg.push_back(0);
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 7; i >= 0; i--)
+        msg.push_back((uint8_t)(bits >> (i * 8)));
+
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64)
+    {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++)
+            w[i] = (uint32_t)msg[chunk + 4 * i] << 24 | (uint32_t)msg[chunk + 4 * i + 1] << 16 |
+                   (uint32_t)msg[chunk + 4 * i + 2] << 8 | (uint32_t)msg[chunk + 4 * i + 3];
+        for (int i = 16; i < 64; i++)
+        {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (int i = 0; i < 64; i++)
+        {
+            uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = hh + s1 + ch + k[i] + w[i];
+            uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + maj;
+            hh = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+        h[5] += f;
+        h[6] += g;
+        h[7] += hh;
+    }
+
+    for (int i = 0; i < 8; i++)
+        for (int j = 0; j < 4; j++)
+            out[4 * i + j] = (uint8_t)(h[i] >> (24 - 8 * j));
+}
+
+table *db_find_table(uint64_t code, uint64_t scope, uint64_t t)
+{
+    auto &tables = current().tables;
+    auto it = tables.find(table_key{code, scope, t});
+    return it == tables.end() ? nullptr : &it->second;
+}
+
+table &db_open_table(uint64_t code, uint64_t scope, uint64_t t)
+{
+    table &result = current().tables[table_key{code, scope, t}];
+    result.code = code;
+    result.scope = scope;
+    result.name = t;
+    return result;
+}
+
+void db_build_indices(table &t, size_t count, const std::function<std::vector<uint64_t>(const row &)> &keys)
+{
+    current().build_indices(t, count, keys);
+}
+
+void db_read(uint64_t code, uint64_t scope, uint64_t t, uint64_t pk)
+{
+    current().record_read(table_key{code, scope, t}, pk, false);
+}
+
+void db_scan(uint64_t code, uint64_t scope, uint64_t t)
+{
+    current().record_read(table_key{code, scope, t}, 0, true);
+}
+
+void db_store(table &t, uint64_t pk, uint64_t payer, std::string data, std::vector<uint64_t> secondary)
+{
+    chain &c = current();
+    eosio_assert(payer != 0, "must specify a valid account to pay for new record");
+    c.journal(t, pk);
+    c.record_write(table_key{t.code, t.scope, t.name}, pk, false);
+    c.record_write(table_key{t.code, t.scope, t.name}, 0, true);
+    c.put_row(t, pk, row{payer, std::move(data), std::move(secondary)});
+}
+
+void db_update(table &t, uint64_t pk, uint64_t payer, std::string data, std::vector<uint64_t> secondary)
+{
+    chain &c = current();
+    auto old = t.rows.find(pk);
+    eosio_assert(old != t.rows.end(), "db_update on a missing row");
+    c.journal(t, pk);
+    c.record_write(table_key{t.code, t.scope, t.name}, pk, false);
+    c.put_row(t, pk, row{payer == 0 ? old->second.payer : payer, std::move(data), std::move(secondary)});
+}
+
+void db_remove(table &t, uint64_t pk)
+{
+    chain &c = current();
+    c.journal(t, pk);
+    c.record_write(table_key{t.code, t.scope, t.name}, pk, false);
+    c.record_write(table_key{t.code, t.scope, t.name}, 0, true);
+    c.erase_row(t, pk);
+}
+
+uint64_t current_receiver() { return current().ctx().receiver; }
+}
+
+using sim::current;
+
+void eosio_assert(uint32_t test, const char *msg)
+{
+    if (!test)
+        throw sim::assertion(msg);
+}
+
+void eosio_assert_message(uint32_t test, const char *msg, uint32_t len)
+{
+    if (!test)
+        throw sim::assertion(std::string(msg, len));
+}
+
+void eosio_exit(int32_t) { throw sim::exit_signal(); }
+
+uint64_t current_time() { return current().time_us; }
+
+uint32_t read_action_data(void *msg, uint32_t len)
+{
+    const auto &data = current().ctx().act->data;
+    uint32_t n = std::min<uint32_t>(len, data.size());
+    memcpy(msg, data.data(), n);
+    return n;
+}
+
+uint32_t action_data_size() { return current().ctx().act->data.size(); }
+
+size_t transaction_size() { return current().packed_trx().size(); }
+
+int read_transaction(char *buffer, size_t size)
+{
+    const auto &trx = current().packed_trx();
+    size_t n = std::min(size, trx.size());
+    memcpy(buffer, trx.data(), n);
+    return n;
+}
+
+namespace eosio
+{
+void require_auth(name n)
+{
+    eosio_assert(has_auth(n), ("missing authority of " + n.to_string()).c_str());
+}
+
+void require_auth(const permission_level &level)
+{
+    for (const auto &auth : current().ctx().act->authorization)
+        if (auth == level)
+            return;
+    eosio_assert(false, ("missing authority of " + level.actor.to_string() + "@" + level.permission.to_string()).c_str());
+}
+
+bool has_auth(name n)
+{
+    for (const auto &auth : current().ctx().act->authorization)
+        if (auth.actor == n)
+            return true;
+    return false;
+}
+
+bool is_account(name n) { return current().account_exists(n); }
+
+void require_recipient(name notify_account)
+{
+    auto &notified = *current().ctx().notified;
+    if (std::find(notified.begin(), notified.end(), notify_account.value) == notified.end())
+        notified.push_back(notify_account.value);
+}
+
+// inline actions carry the sending contract's own permissions only (eosio.code)
+void send_inline(const action &act)
+{
+    auto &ctx = current().ctx();
+    for (const auto &auth : act.authorization)
+        eosio_assert(auth.actor.value == ctx.receiver,
+                     ("inline action " + act.account.to_string() + "::" + act.name.to_string() + " authorized by " +
+                      auth.actor.to_string() + "@" + auth.permission.to_string() + " but sent by " +
+                      name(ctx.receiver).to_string())
+                         .c_str());
+    eosio_assert(current().account_exists(act.account), "inline action's code account does not exist");
+    ctx.inlines->push_back(act);
+}
+
+checksum256 sha256(const char *data, uint32_t length)
+{
+    std::array<uint8_t, 32> hash;
+    sim::_sha256((const uint8_t *)data, length, hash.data());
+    return checksum256(hash);
+}
+}
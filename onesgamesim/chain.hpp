@@ -0,0 +1,197 @@
+#pragma once
+
+#include <eosiolib/binary_extension.hpp>
+#include <eosiolib/crypto.h>
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/singleton.hpp>
+#include <eosiolib/time.hpp>
+#include <eosiolib/transaction.hpp>
+
+#include <stdexcept>
+
+namespace sim
+{
+typedef void (*apply_fn)(uint64_t receiver, uint64_t code, uint64_t action);
+
+// nodeos billable sizes: table_id_object, key_value_object and index64_object
+const int64_t RAM_TABLE_BYTES = 108;
+const int64_t RAM_ROW_BYTES = 108;
+const int64_t RAM_INDEX64_BYTES = 128;
+
+const uint32_t MAX_INLINE_DEPTH = 4;
+
+// eosio_assert failure, the transaction is rolled back
+struct assertion : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+struct table_key
+{
+    uint64_t code;
+    uint64_t scope;
+    uint64_t table;
+
+    bool operator<(const table_key &o) const { return std::tie(code, scope, table) < std::tie(o.code, o.scope, o.table); }
+    bool operator==(const table_key &o) const { return code == o.code && scope == o.scope && table == o.table; }
+};
+
+// a row, or with scan set the key set of a table (inserts, erases and ordered walks)
+struct rw_key
+{
+    table_key table;
+    uint64_t pk;
+    bool scan;
+
+    bool operator<(const rw_key &o) const { return std::tie(table, scan, pk) < std::tie(o.table, o.scan, o.pk); }
+};
+
+struct rw_set
+{
+    std::set<rw_key> reads;
+    std::set<rw_key> writes;
+
+    bool conflicts(const rw_set &o) const;
+};
+
+// a table a contract declares, so snapshot rows can be keyed without running the contract
+struct table_type
+{
+    uint64_t table;
+    size_t indices;
+    uint64_t (*primary_key)(const char *data, size_t size);
+};
+
+struct contract_type
+{
+    eosio::name account;
+    apply_fn apply;
+    std::vector<table_type> tables;
+};
+
+// contracts linked into the simulator, filled in by defi.cpp, mine.cpp, divd.cpp and token.cpp
+std::vector<contract_type> &contracts();
+const contract_type *find_contract(uint64_t code);
+const table_type *find_table_type(uint64_t code, uint64_t table);
+
+template <typename Table>
+uint64_t table_primary_key(const char *data, size_t size)
+{
+    return eosio::unpack<typename Table::row_type>(data, size).primary_key();
+}
+
+template <typename... Tables>
+std::vector<table_type> table_types()
+{
+    return {table_type{Tables::table_name, Tables::index_count, &table_primary_key<Tables>}...};
+}
+
+struct registrar
+{
+    registrar(eosio::name account, apply_fn apply, std::vector<table_type> tables)
+    {
+        contracts().push_back(contract_type{account, apply, std::move(tables)});
+    }
+};
+
+struct action_trace
+{
+    eosio::name receiver;
+    eosio::name account;
+    eosio::name name;
+    uint32_t depth;
+};
+
+class chain
+{
+public:
+    chain();
+    ~chain();
+
+    // all names are accounts and token balances never run short, for streams recorded
+    // against a chain whose token state the snapshot does not hold
+    bool lenient = false;
+
+    // collect the rw-set of each push, for the dependency report
+    bool record = false;
+
+    uint64_t time_us = 0;
+
+    std::map<table_key, table> tables;
+    std::set<uint64_t> accounts;
+    std::map<uint64_t, int64_t> ram;
+
+    void create_account(eosio::name account);
+    bool account_exists(eosio::name account) const;
+    void deploy(eosio::name account, apply_fn apply);
+    bool deployed(eosio::name account) const { return _code.count(account.value) > 0; }
+
+    // runs all actions of trx, rolls back and rethrows the assertion if one fails
+    void push(const eosio::transaction &trx);
+    void push(const eosio::action &act);
+
+    // what the last push read and wrote and which actions it ran
+    const rw_set &last_rw() const { return _rw; }
+    const std::vector<action_trace> &last_traces() const { return _traces; }
+
+    // binary snapshot: [magic][tables]([code][scope][table][payer][rows]([pk][payer][size][data])*)*
+    void load(const std::string &path);
+    void save(const std::string &path) const;
+
+    int64_t row_ram(const table &t, const row &r) const;
+    int64_t table_ram(const table &t) const;
+
+    // used by the intrinsics
+    struct context
+    {
+        const eosio::action *act;
+        uint64_t receiver;
+        std::vector<uint64_t> *notified;
+        std::vector<eosio::action> *inlines;
+        uint32_t depth;
+    };
+
+    context &ctx();
+    const std::vector<char> &packed_trx() const { return _packed_trx; }
+    void record_read(const table_key &t, uint64_t pk, bool scan);
+    void record_write(const table_key &t, uint64_t pk, bool scan);
+    void put_row(table &t, uint64_t pk, row r);
+    void erase_row(table &t, uint64_t pk);
+    void journal(table &t, uint64_t pk);
+    void build_indices(table &t, size_t count, const std::function<std::vector<uint64_t>(const row &)> &keys);
+
+private:
+    struct undo
+    {
+        table *t;
+        uint64_t pk;
+        bool existed;
+        row old;
+    };
+
+    void _execute(const eosio::action &act, uint32_t depth);
+    void _apply(const eosio::action &act, uint64_t receiver, std::vector<uint64_t> &notified,
+                std::vector<eosio::action> &inlines, uint32_t depth);
+    void _rollback();
+    void _charge(uint64_t payer, int64_t bytes);
+
+    std::map<uint64_t, apply_fn> _code;
+    std::vector<context> _contexts;
+    std::vector<undo> _undo;
+    std::vector<char> _packed_trx;
+    rw_set _rw;
+    std::vector<action_trace> _traces;
+    std::set<std::pair<uint64_t, uint64_t>> _journaled;
+    const eosio::transaction *_trx = nullptr;
+};
+
+// the chain the intrinsics run against
+chain &current();
+
+// eosio.token, for every token contract a test or replay needs
+extern apply_fn token_apply;
+eosio::asset balance(eosio::name contract, eosio::name owner, eosio::symbol sym);
+
+std::string to_hex(const char *data, size_t size);
+std::vector<char> from_hex(const std::string &hex);
+}
@@ -0,0 +1,212 @@
+// onesgamedefi compiled for the host against the eosiolib shim
+#include "onesgamesim.hpp"
+
+#include <curve.hpp>
+#include <events.hpp>
+
+#define apply onesgamedefi_apply
+namespace defi
+{
+#include "../onesgamedefi/onesgamedefi.cpp"
+
+uint64_t onesgame::code;
+}
+#undef apply
+
+namespace sim
+{
+static registrar _defi(eosio::name("onesgamedefi"), &defi::onesgamedefi_apply,
+                       table_types<defi::onesgame::tb_defi_config, defi::onesgame::stats, defi::onesgame::tb_defi_pair,
+                                   defi::onesgame::tb_defi_liquidity, defi::onesgame::tb_defi_liquidity_v1,
+                                   defi::onesgame::tb_defi_curve, defi::onesgame::tb_defi_fee, defi::onesgame::tb_defi_flash,
+                                   defi::onesgame::tb_defi_vault, defi::onesgame::tb_vault_shares,
+                                   defi::onesgame::tb_vault_mined, defi::onesgame::tb_defi_queue,
+                                   defi::onesgame::tb_defi_reserved, defi::onesgame::tb_defi_transfers,
+                                   defi::onesgame::tb_defi_pools, defi::onesgame::tb_swap_log, defi::onesgame::tb_swap_log_v2,
+                                   defi::onesgame::tb_market_info, defi::onesgame::tb_market_info_v1,
+                                   defi::onesgame::tb_market_config,
+                                   defi::onesgame::tb_market_log, defi::onesgame::tb_market_ring,
+                                   defi::onesgame::tb_market_venue, defi::onesgame::tb_market_sender,
+                                   defi::onesgame::accounts>());
+}
+
+namespace sim
+{
+using defi::onesgame;
+
+static std::pair<uint64_t, uint64_t> token_key(eosio::name contract, eosio::symbol sym)
+{
+    return {contract.value, sym.raw()};
+}
+
+// inverse of onesgame::_lp_symbol: "LP" and the id in base 26, most significant letter first
+static bool lp_id(eosio::symbol sym, uint64_t &id)
+{
+    std::string code = sym.code().to_string();
+    if (sym.precision() != 0 || code.size() < 3 || code.compare(0, 2, "LP") != 0)
+        return false;
+    id = 0;
+    for (size_t i = 2; i < code.size(); i++)
+        id = id * 26 + (code[i] - 'A');
+    return true;
+}
+
+static void stable_rates(const defi_pool &p, curve::u128 &rate1, curve::u128 &rate2)
+{
+    uint8_t precision1 = p.symbol1.precision();
+    uint8_t precision2 = p.symbol2.precision();
+    rate1 = std::pow(10, precision1 < precision2 ? precision2 - precision1 : 0);
+    rate2 = std::pow(10, precision2 < precision1 ? precision1 - precision2 : 0);
+}
+
+defi_state read_defi()
+{
+    const eosio::name self("onesgamedefi");
+    defi_state state;
+
+    onesgame::tb_defi_liquidity liquidity(self, self.value);
+    onesgame::tb_defi_curve curves(self, self.value);
+    for (const auto &l : liquidity)
+    {
+        defi_pool &p = state.pools[l.liquidity_id];
+        p.id = l.liquidity_id;
+        p.contract1 = l.token1.address;
+        p.contract2 = l.token2.address;
+        p.symbol1 = l.token1.symbol;
+        p.symbol2 = l.token2.symbol;
+        p.reserve1 = l.reserve1;
+        p.reserve2 = l.reserve2;
+        p.liquidity_token = l.liquidity_token;
+
+        auto curve = curves.find(l.liquidity_id);
+        if (curve != curves.end())
+        {
+            p.kind = curve->kind;
+            p.param1 = curve->param1;
+            p.param2 = curve->param2;
+        }
+        if (p.kind == DEFI_CURVE_STABLE && p.liquidity_token > 0)
+        {
+            curve::u128 rate1, rate2;
+            stable_rates(p, rate1, rate2);
+            p.bounded = curve::stable_bounded(p.reserve1 * rate1, p.reserve2 * rate2);
+        }
+
+        onesgame::tb_defi_pools holders(self, l.liquidity_id);
+        for (const auto &h : holders)
+            p.holders[h.account.value] = h.liquidity_token;
+
+        onesgame::tb_vault_shares shareholders(self, l.liquidity_id);
+        for (const auto &s : shareholders)
+            p.shareholders[s.account.value] = s.shares;
+
+        state.owed[token_key(p.contract1, p.symbol1)] += p.reserve1;
+        state.owed[token_key(p.contract2, p.symbol2)] += p.reserve2;
+
+        for (eosio::name contract : {p.contract1, p.contract2})
+        {
+            onesgame::tb_defi_reserved reserved(self, contract.value);
+            for (const auto &r : reserved)
+                state.reserved[token_key(contract, r.quantity.symbol)] = r.quantity.amount;
+        }
+    }
+
+    onesgame::tb_defi_vault vaults(self, self.value);
+    for (const auto &v : vaults)
+    {
+        defi_pool &p = state.pools[v.liquidity_id];
+        p.vault = true;
+        p.vault_shares = v.shares;
+        p.pending1 = v.pending1.amount;
+        p.pending2 = v.pending2.amount;
+        state.owed[token_key(p.contract1, p.symbol1)] += p.pending1;
+        state.owed[token_key(p.contract2, p.symbol2)] += p.pending2;
+    }
+
+    // mined rewards waiting for vaultharvest, one scope per token contract
+    for (const auto &t : current().tables)
+    {
+        if (t.first.code != self.value || t.first.table != eosio::name("vaultmined").value)
+            continue;
+        for (const auto &r : t.second.rows)
+        {
+            auto m = eosio::unpack<onesgame::st_vault_mined>(r.second.data.data(), r.second.data.size());
+            state.mined[token_key(eosio::name(t.first.scope), m.quantity.symbol)] = m.quantity.amount;
+            state.owed[token_key(eosio::name(t.first.scope), m.quantity.symbol)] += m.quantity.amount;
+        }
+    }
+
+    onesgame::tb_defi_queue queue(self, self.value);
+    for (const auto &q : queue)
+    {
+        const defi_pool &p = state.pools[q.liquidity_id];
+        state.queue.push_back({q.queue_id, q.account.value});
+        state.queued[token_key(p.contract1, q.quantity1.symbol)] += q.quantity1.amount;
+        state.queued[token_key(p.contract2, q.quantity2.symbol)] += q.quantity2.amount;
+    }
+    for (const auto &q : state.queued)
+        state.owed[q.first] += q.second;
+
+    // LP token supplies, one stat scope per symbol
+    for (const auto &t : current().tables)
+    {
+        if (t.first.code != self.value || t.first.table != eosio::name("stat").value)
+            continue;
+        for (const auto &r : t.second.rows)
+        {
+            auto st = eosio::unpack<onesgame::currency_stats>(r.second.data.data(), r.second.data.size());
+            uint64_t id;
+            if (lp_id(st.supply.symbol, id) && state.pools.count(id))
+                state.pools[id].wrapped = st.supply.amount;
+        }
+    }
+    return state;
+}
+
+// the range pool's price bounds in raw units, as onesgame::_get_range has them
+static void range_prices(const defi_pool &p, double &pa, double &pb)
+{
+    double p1 = std::pow(10, p.symbol1.precision());
+    double p2 = std::pow(10, p.symbol2.precision());
+    pa = p.param1 / 1e8 * p2 / p1;
+    pb = p.param2 / 1e8 * p2 / p1;
+}
+
+static curve::u128 stable_d(const defi_pool &p, int64_t x, int64_t y)
+{
+    curve::u128 rate1, rate2;
+    stable_rates(p, rate1, rate2);
+    return curve::stable_d(x * rate1, y * rate2, p.param1);
+}
+
+curve::u128 defi_k(const defi_pool &p, int64_t x, int64_t y)
+{
+    if (p.kind == DEFI_CURVE_RANGE)
+    {
+        double pa, pb;
+        range_prices(p, pa, pb);
+        curve::range_t range = curve::range_offsets(p.reserve1, p.reserve2, pa, pb);
+        return ((curve::u128)x + range.a) * ((curve::u128)y + range.b);
+    }
+
+    if (p.kind == DEFI_CURVE_STABLE)
+        return stable_d(p, x, y);
+
+    return (curve::u128)x * y;
+}
+
+long double defi_value(const defi_pool &p)
+{
+    if (p.kind == DEFI_CURVE_RANGE)
+    {
+        double pa, pb;
+        range_prices(p, pa, pb);
+        return curve::range_liquidity(p.reserve1, p.reserve2, pa, pb);
+    }
+
+    if (p.kind == DEFI_CURVE_STABLE)
+        return stable_d(p, p.reserve1, p.reserve2);
+
+    return curve::isqrt((curve::u128)p.reserve1 * p.reserve2);
+}
+}
@@ -0,0 +1,384 @@
+// partitions a recorded action stream by the rows each transaction reads and writes and runs the
+// independent parts in parallel
+#include "onesgamesim.hpp"
+
+#include <atomic>
+#include <numeric>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace sim
+{
+struct components
+{
+    std::vector<size_t> parent;
+
+    explicit components(size_t n) : parent(n) { std::iota(parent.begin(), parent.end(), 0); }
+
+    size_t find(size_t i)
+    {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+        return i;
+    }
+
+    void join(size_t a, size_t b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a != b)
+            parent[std::max(a, b)] = std::min(a, b);
+    }
+};
+
+// what happened to a key so far: its last writer and who read it since
+struct key_state
+{
+    int64_t writer = -1;
+    std::vector<size_t> readers;
+};
+
+static uint64_t run(chain &c, const step &s, bool quiet)
+{
+    if (s.time_us != 0)
+        c.time_us = s.time_us;
+    try
+    {
+        c.push(s.trx);
+        return 0;
+    }
+    catch (const assertion &e)
+    {
+        if (!quiet)
+            fprintf(stderr, "line %zu %s: %s\n", s.line, s.label.c_str(), e.what());
+        return 1;
+    }
+}
+
+static uint64_t differing_rows(const std::map<table_key, table> &a, const std::map<table_key, table> &b)
+{
+    static const table empty;
+    std::set<table_key> keys;
+    for (const auto &t : a)
+        keys.insert(t.first);
+    for (const auto &t : b)
+        keys.insert(t.first);
+
+    uint64_t rows = 0;
+    for (const auto &key : keys)
+    {
+        auto x = a.find(key);
+        auto y = b.find(key);
+        const auto &left = x == a.end() ? empty.rows : x->second.rows;
+        const auto &right = y == b.end() ? empty.rows : y->second.rows;
+        for (const auto &r : left)
+        {
+            auto other = right.find(r.first);
+            if (other == right.end() || other->second.data != r.second.data || other->second.payer != r.second.payer)
+                rows++;
+        }
+        for (const auto &r : right)
+            rows += left.count(r.first) == 0;
+    }
+    return rows;
+}
+
+template <typename T>
+static void put(FILE *out, const T &v)
+{
+    fwrite(&v, sizeof(v), 1, out);
+}
+
+template <typename T>
+static T get(FILE *in)
+{
+    T v;
+    if (fread(&v, sizeof(v), 1, in) != 1)
+        throw std::runtime_error("short worker result");
+    return v;
+}
+
+// worker result: [failed]([code][scope][table][index count][pk][exists]([payer][size][data][count][secondary])?)*
+static void write_rows(const std::set<std::pair<table_key, uint64_t>> &written, uint64_t failed, FILE *out)
+{
+    put(out, failed);
+    for (const auto &w : written)
+    {
+        const table *t = db_find_table(w.first.code, w.first.scope, w.first.table);
+        const row *r = nullptr;
+        if (t != nullptr && t->rows.count(w.second))
+            r = &t->rows.at(w.second);
+
+        put(out, w.first.code);
+        put(out, w.first.scope);
+        put(out, w.first.table);
+        put(out, (uint64_t)(t == nullptr ? 0 : t->index_count));
+        put(out, w.second);
+        put(out, (uint8_t)(r != nullptr));
+        if (r == nullptr)
+            continue;
+        put(out, r->payer);
+        put(out, (uint64_t)r->data.size());
+        fwrite(r->data.data(), 1, r->data.size(), out);
+        put(out, (uint64_t)r->secondary.size());
+        for (uint64_t k : r->secondary)
+            put(out, k);
+    }
+}
+
+static uint64_t merge_rows(chain &c, FILE *in)
+{
+    uint64_t failed = get<uint64_t>(in);
+    for (int ch; (ch = fgetc(in)) != EOF;)
+    {
+        ungetc(ch, in);
+        table_key key;
+        key.code = get<uint64_t>(in);
+        key.scope = get<uint64_t>(in);
+        key.table = get<uint64_t>(in);
+        uint64_t index_count = get<uint64_t>(in);
+        uint64_t pk = get<uint64_t>(in);
+        bool exists = get<uint8_t>(in) != 0;
+
+        table &t = db_open_table(key.code, key.scope, key.table);
+        if (t.rows.empty())
+            t.index_count = index_count;
+        if (!exists)
+        {
+            c.erase_row(t, pk);
+            continue;
+        }
+
+        row r;
+        r.payer = get<uint64_t>(in);
+        r.data.resize(get<uint64_t>(in));
+        if (fread(&r.data[0], 1, r.data.size(), in) != r.data.size())
+            throw std::runtime_error("short worker result");
+        r.secondary.resize(get<uint64_t>(in));
+        for (auto &k : r.secondary)
+            k = get<uint64_t>(in);
+        c.put_row(t, pk, std::move(r));
+    }
+    return failed;
+}
+
+// runs the components on forked workers, each takes the costliest component left; processes rather
+// than threads as the contracts keep the running code in statics
+static uint64_t run_parallel(chain &c, const std::vector<step> &steps, const std::vector<rw_set> &sets,
+                             const std::vector<std::vector<size_t>> &parts, size_t jobs, double &secs)
+{
+    auto *next = static_cast<std::atomic<size_t> *>(
+        mmap(nullptr, sizeof(std::atomic<size_t>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (next == MAP_FAILED)
+        throw std::runtime_error("mmap");
+    new (next) std::atomic<size_t>(0);
+
+    std::vector<FILE *> results;
+    std::vector<pid_t> workers;
+    fflush(stdout);
+    fflush(stderr);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t w = 0; w < jobs; w++)
+    {
+        FILE *out = tmpfile();
+        if (out == nullptr)
+            throw std::runtime_error("tmpfile");
+        pid_t pid = fork();
+        if (pid < 0)
+            throw std::runtime_error("fork");
+        if (pid == 0)
+        {
+            try
+            {
+                std::set<std::pair<table_key, uint64_t>> written;
+                uint64_t failed = 0;
+                for (size_t p; (p = next->fetch_add(1)) < parts.size();)
+                    for (size_t i : parts[p])
+                    {
+                        failed += run(c, steps[i], true);
+                        for (const auto &k : sets[i].writes)
+                            if (!k.scan)
+                                written.insert({k.table, k.pk});
+                    }
+                write_rows(written, failed, out);
+                fflush(out);
+                _exit(ferror(out) ? 1 : 0);
+            }
+            catch (const std::exception &e)
+            {
+                fprintf(stderr, "worker: %s\n", e.what());
+                _exit(1);
+            }
+        }
+        results.push_back(out);
+        workers.push_back(pid);
+    }
+
+    bool ok = true;
+    for (pid_t pid : workers)
+    {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    secs = seconds_since(start);
+    munmap(next, sizeof(std::atomic<size_t>));
+    if (!ok)
+        throw std::runtime_error("a worker failed");
+
+    uint64_t failed = 0;
+    for (FILE *in : results)
+    {
+        rewind(in);
+        failed += merge_rows(c, in);
+        fclose(in);
+    }
+    return failed;
+}
+
+int deps(const options &o)
+{
+    chain c;
+    c.lenient = o.lenient;
+    load(c, o.args[0]);
+    std::vector<step> steps = read_stream(o, c, o.args[1]);
+    if (steps.empty())
+        throw std::runtime_error(o.args[1] + ": no transactions");
+
+    const std::map<table_key, table> initial = c.tables;
+    const std::map<uint64_t, int64_t> initial_ram = c.ram;
+
+    // the rw-sets, failed transactions included: they read what made them fail
+    std::vector<rw_set> sets;
+    c.record = true;
+    for (const auto &s : steps)
+    {
+        run(c, s, true);
+        sets.push_back(c.last_rw());
+    }
+    c.record = false;
+    c.tables = initial;
+    c.ram = initial_ram;
+
+    // the serial run the parallel one is measured and checked against
+    std::vector<uint64_t> ns;
+    uint64_t failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &s : steps)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        failed += run(c, s, failed >= 20);
+        ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+    }
+    double serial_secs = seconds_since(start);
+    const std::map<table_key, table> serial = c.tables;
+
+    // a transaction depends on the last writer of what it touches and, to write, on the readers since;
+    // the critical path is the longest chain of those, weighted by measured cost
+    std::map<rw_key, key_state> keys;
+    std::map<std::pair<uint64_t, uint64_t>, uint64_t> conflicts;
+    components parts(steps.size());
+    std::vector<uint64_t> finish(steps.size()), depth(steps.size());
+    uint64_t total_ns = 0, critical_ns = 0, critical_depth = 0;
+    for (size_t i = 0; i < steps.size(); i++)
+    {
+        uint64_t begin = 0, level = 0;
+        std::set<std::pair<uint64_t, uint64_t>> blocked_by;
+        auto depend = [&](size_t on, const rw_key &k) {
+            parts.join(i, on);
+            begin = std::max(begin, finish[on]);
+            level = std::max(level, depth[on]);
+            blocked_by.insert({k.table.code, k.table.table});
+        };
+
+        for (int pass = 0; pass < 2; pass++)
+            for (const auto &k : pass == 0 ? sets[i].reads : sets[i].writes)
+            {
+                if (o.exclude.count(k.table.table))
+                    continue;
+                key_state &state = keys[k];
+                if (state.writer >= 0)
+                    depend(state.writer, k);
+                if (pass == 1)
+                    for (size_t r : state.readers)
+                        if (r != i)
+                            depend(r, k);
+            }
+
+        finish[i] = begin + ns[i];
+        depth[i] = level + 1;
+        total_ns += ns[i];
+        critical_ns = std::max(critical_ns, finish[i]);
+        critical_depth = std::max(critical_depth, depth[i]);
+        for (const auto &t : blocked_by)
+            conflicts[t]++;
+
+        for (const auto &k : sets[i].reads)
+            if (!o.exclude.count(k.table.table) && !sets[i].writes.count(k))
+                keys[k].readers.push_back(i);
+        for (const auto &k : sets[i].writes)
+        {
+            if (o.exclude.count(k.table.table))
+                continue;
+            key_state &state = keys[k];
+            state.writer = i;
+            state.readers.clear();
+        }
+    }
+
+    // independent components, costliest first
+    std::map<size_t, std::vector<size_t>> grouped;
+    for (size_t i = 0; i < steps.size(); i++)
+        grouped[parts.find(i)].push_back(i);
+    std::vector<std::pair<uint64_t, std::vector<size_t>>> costed;
+    for (auto &g : grouped)
+    {
+        uint64_t cost = 0;
+        for (size_t i : g.second)
+            cost += ns[i];
+        costed.emplace_back(cost, std::move(g.second));
+    }
+    std::sort(costed.begin(), costed.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    std::vector<std::vector<size_t>> ordered;
+    for (auto &p : costed)
+        ordered.push_back(std::move(p.second));
+
+    printf("%zu transactions, %llu failed, in %.3f s serially\n", steps.size(), (unsigned long long)failed, serial_secs);
+    printf("critical path: %llu transactions deep, %.3f of %.3f ms: at most %.1fx in parallel\n",
+           (unsigned long long)critical_depth, critical_ns / 1e6, total_ns / 1e6,
+           critical_ns > 0 ? (double)total_ns / critical_ns : 1.0);
+    printf("%zu independent components, the largest %zu transactions and %.1f%% of the cost: at most %.1fx\n",
+           ordered.size(), ordered[0].size(), 100.0 * costed[0].first / std::max<uint64_t>(total_ns, 1),
+           costed[0].first > 0 ? (double)total_ns / costed[0].first : 1.0);
+
+    std::vector<std::pair<uint64_t, std::pair<uint64_t, uint64_t>>> ranked;
+    for (const auto &t : conflicts)
+        ranked.push_back({t.second, t.first});
+    std::sort(ranked.rbegin(), ranked.rend());
+    if (!ranked.empty())
+        printf("table transactions_it_orders\n");
+    for (size_t i = 0; i < ranked.size() && i < 10; i++)
+        printf("%s:%s %llu\n", eosio::name(ranked[i].second.first).to_string().c_str(),
+               eosio::name(ranked[i].second.second).to_string().c_str(), (unsigned long long)ranked[i].first);
+
+    size_t jobs = o.jobs != 0 ? o.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min(jobs, ordered.size());
+    if (jobs < 2)
+        return 0;
+
+    c.tables = initial;
+    c.ram = initial_ram;
+    double parallel_secs = 0;
+    uint64_t parallel_failed = run_parallel(c, steps, sets, ordered, jobs, parallel_secs);
+    uint64_t rows = differing_rows(c.tables, serial);
+    printf("%zu workers in %.3f s: %.2fx the serial run, %llu failed, %s\n", jobs, parallel_secs,
+           parallel_secs > 0 ? serial_secs / parallel_secs : 0, (unsigned long long)parallel_failed,
+           rows == 0 && parallel_failed == failed ? "same end state" : "diverged");
+    if (rows != 0)
+        printf("%llu rows differ from the serial run%s\n", (unsigned long long)rows,
+               o.exclude.empty() ? "" : ", expected with -x");
+    return rows == 0 && parallel_failed == failed ? 0 : 1;
+}
+}
@@ -0,0 +1,16 @@
+// onesgamedivd compiled for the host against the eosiolib shim
+#include "chain.hpp"
+
+#define apply onesgamedivd_apply
+namespace divd
+{
+#include "../onesgamedivd/onesgamedivd.cpp"
+}
+#undef apply
+
+namespace sim
+{
+static registrar _divd(eosio::name("onesgamedivd"), &divd::onesgamedivd_apply,
+                       table_types<divd::onesgame::tb_defi_config, divd::onesgame::tb_defi_account,
+                                   divd::onesgame::tb_defi_stake, divd::onesgame::tb_defi_bonus>());
+}
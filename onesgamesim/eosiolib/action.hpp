@@ -0,0 +1,68 @@
+#pragma once
+
+#include <eosiolib/datastream.hpp>
+
+namespace eosio
+{
+struct permission_level
+{
+    permission_level(name a, name p) : actor(a), permission(p) {}
+    permission_level() {}
+
+    name actor;
+    name permission;
+
+    friend bool operator==(const permission_level &a, const permission_level &b)
+    {
+        return a.actor == b.actor && a.permission == b.permission;
+    }
+    friend bool operator<(const permission_level &a, const permission_level &b)
+    {
+        return std::tie(a.actor, a.permission) < std::tie(b.actor, b.permission);
+    }
+
+    EOSLIB_SERIALIZE(permission_level, (actor)(permission))
+};
+
+struct action;
+
+// chain intrinsics, implemented by the simulator in chain.cpp
+void require_auth(name n);
+void require_auth(const permission_level &level);
+bool has_auth(name n);
+bool is_account(name n);
+void require_recipient(name notify_account);
+void send_inline(const action &act);
+
+template <typename... Accounts>
+void require_recipient(name notify_account, Accounts... remaining)
+{
+    require_recipient(notify_account);
+    require_recipient(remaining...);
+}
+
+struct action
+{
+    eosio::name account;
+    eosio::name name;
+    std::vector<permission_level> authorization;
+    std::vector<char> data;
+
+    action() {}
+
+    template <typename T>
+    action(const permission_level &auth, eosio::name a, eosio::name n, T &&value)
+        : account(a), name(n), authorization(1, auth), data(pack(std::forward<T>(value))) {}
+
+    template <typename T>
+    action(std::vector<permission_level> auths, eosio::name a, eosio::name n, T &&value)
+        : account(a), name(n), authorization(std::move(auths)), data(pack(std::forward<T>(value))) {}
+
+    void send() const { send_inline(*this); }
+
+    template <typename T>
+    T data_as() { return unpack<T>(data.data(), data.size()); }
+
+    EOSLIB_SERIALIZE(action, (account)(name)(authorization)(data))
+};
+}
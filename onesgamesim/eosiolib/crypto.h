@@ -0,0 +1,3 @@
+#pragma once
+
+#include <eosiolib/crypto.hpp>
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <eosiolib/datastream.hpp>
+
+namespace eosio
+{
+template <size_t Size>
+class fixed_bytes
+{
+public:
+    fixed_bytes() { _data.fill(0); }
+    explicit fixed_bytes(const std::array<uint8_t, Size> &arr) : _data(arr) {}
+
+    std::array<uint8_t, Size> extract_as_byte_array() const { return _data; }
+    const uint8_t *data() const { return _data.data(); }
+    uint8_t *data() { return _data.data(); }
+    static constexpr size_t size() { return Size; }
+
+    friend bool operator==(const fixed_bytes &a, const fixed_bytes &b) { return a._data == b._data; }
+    friend bool operator!=(const fixed_bytes &a, const fixed_bytes &b) { return a._data != b._data; }
+    friend bool operator<(const fixed_bytes &a, const fixed_bytes &b) { return a._data < b._data; }
+
+    template <typename DataStream>
+    friend DataStream &operator<<(DataStream &ds, const fixed_bytes &v)
+    {
+        ds.write((const char *)v._data.data(), Size);
+        return ds;
+    }
+
+    template <typename DataStream>
+    friend DataStream &operator>>(DataStream &ds, fixed_bytes &v)
+    {
+        ds.read((char *)v._data.data(), Size);
+        return ds;
+    }
+
+private:
+    std::array<uint8_t, Size> _data;
+};
+
+typedef fixed_bytes<20> checksum160;
+typedef fixed_bytes<32> checksum256;
+typedef fixed_bytes<64> checksum512;
+
+checksum256 sha256(const char *data, uint32_t length);
+}
@@ -0,0 +1,509 @@
+#pragma once
+
+#include <eosiolib/symbol.hpp>
+
+namespace eosio
+{
+template <typename T>
+class datastream
+{
+public:
+    datastream(T start, size_t s) : _start(start), _pos(start), _end(start + s) {}
+
+    void skip(size_t s) { _pos += s; }
+
+    bool read(char *d, size_t s)
+    {
+        eosio_assert(size_t(_end - _pos) >= s, "datastream attempted to read past the end");
+        memcpy(d, _pos, s);
+        _pos += s;
+        return true;
+    }
+
+    bool write(const char *d, size_t s)
+    {
+        eosio_assert(_end - _pos >= (int32_t)s, "datastream attempted to write past the end");
+        memcpy((void *)_pos, d, s);
+        _pos += s;
+        return true;
+    }
+
+    bool put(char c) { return write(&c, 1); }
+
+    bool get(char &c) { return read(&c, 1); }
+    bool get(unsigned char &c) { return read((char *)&c, 1); }
+
+    T pos() const { return _pos; }
+    bool valid() const { return _pos <= _end && _pos >= _start; }
+    bool seekp(size_t p)
+    {
+        _pos = _start + p;
+        return _pos <= _end;
+    }
+    size_t tellp() const { return size_t(_pos - _start); }
+    size_t remaining() const { return _end - _pos; }
+
+private:
+    T _start;
+    T _pos;
+    T _end;
+};
+
+// counts the bytes a value packs to
+template <>
+class datastream<size_t>
+{
+public:
+    datastream(size_t init_size = 0) : _size(init_size) {}
+
+    void skip(size_t s) { _size += s; }
+    bool write(const char *, size_t s)
+    {
+        _size += s;
+        return true;
+    }
+    bool put(char)
+    {
+        ++_size;
+        return true;
+    }
+    bool valid() const { return true; }
+    bool seekp(size_t p)
+    {
+        _size = p;
+        return true;
+    }
+    size_t tellp() const { return _size; }
+    size_t remaining() const { return 0; }
+
+private:
+    size_t _size;
+};
+
+struct unsigned_int
+{
+    unsigned_int(uint32_t v = 0) : value(v) {}
+    operator uint32_t() const { return value; }
+
+    uint32_t value;
+};
+
+template <typename DataStream>
+DataStream &operator<<(DataStream &ds, const unsigned_int &v)
+{
+    uint64_t val = v.value;
+    do
+    {
+        uint8_t b = uint8_t(val) & 0x7f;
+        val >>= 7;
+        b |= ((val > 0) << 7);
+        ds.write((char *)&b, 1);
+    } while (val);
+    return ds;
+}
+
+template <typename DataStream>
+DataStream &operator>>(DataStream &ds, unsigned_int &vi)
+{
+    uint64_t v = 0;
+    char b = 0;
+    uint8_t by = 0;
+    do
+    {
+        ds.get(b);
+        v |= uint32_t(uint8_t(b) & 0x7f) << by;
+        by += 7;
+    } while (uint8_t(b) & 0x80 && by < 32);
+    vi.value = static_cast<uint32_t>(v);
+    return ds;
+}
+
+template <typename DataStream, typename T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>> * = nullptr>
+DataStream &operator<<(DataStream &ds, const T &v)
+{
+    ds.write((const char *)&v, sizeof(T));
+    return ds;
+}
+
+template <typename DataStream, typename T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>> * = nullptr>
+DataStream &operator>>(DataStream &ds, T &v)
+{
+    ds.read((char *)&v, sizeof(T));
+    return ds;
+}
+
+template <typename DataStream>
+DataStream &operator<<(DataStream &ds, const name &v) { return ds << v.value; }
+template <typename DataStream>
+DataStream &operator>>(DataStream &ds, name &v) { return ds >> v.value; }
+
+template <typename DataStream>
+DataStream &operator<<(DataStream &ds, const symbol_code &v) { return ds << v.raw(); }
+template <typename DataStream>
+DataStream &operator>>(DataStream &ds, symbol_code &v)
+{
+    uint64_t raw;
+    ds >> raw;
+    v = symbol_code(raw);
+    return ds;
+}
+
+template <typename DataStream>
+DataStream &operator<<(DataStream &ds, const symbol &v) { return ds << v.raw(); }
+template <typename DataStream>
+DataStream &operator>>(DataStream &ds, symbol &v)
+{
+    uint64_t raw;
+    ds >> raw;
+    v = symbol(raw);
+    return ds;
+}
+
+template <typename DataStream>
+DataStream &operator<<(DataStream &ds, const extended_symbol &v) { return ds << v.sym << v.contract; }
+template <typename DataStream>
+DataStream &operator>>(DataStream &ds, extended_symbol &v) { return ds >> v.sym >> v.contract; }
+
+template <typename DataStream>
+DataStream &operator<<(DataStream &ds, const std::string &v)
+{
+    ds << unsigned_int((uint32_t)v.size());
+    if (v.size())
+        ds.write(v.data(), v.size());
+    return ds;
+}
+
+template <typename DataStream>
+DataStream &operator>>(DataStream &ds, std::string &v)
+{
+    unsigned_int s;
+    ds >> s;
+    v.resize(s.value);
+    if (s.value)
+        ds.read(&v[0], v.size());
+    return ds;
+}
+
+template <typename DataStream, typename T>
+DataStream &operator<<(DataStream &ds, const std::vector<T> &v)
+{
+    ds << unsigned_int((uint32_t)v.size());
+    if constexpr (std::is_same_v<T, char> || std::is_same_v<T, unsigned char>)
+        ds.write((const char *)v.data(), v.size());
+    else
+        for (const auto &i : v)
+            ds << i;
+    return ds;
+}
+
+template <typename DataStream, typename T>
+DataStream &operator>>(DataStream &ds, std::vector<T> &v)
+{
+    unsigned_int s;
+    ds >> s;
+    v.resize(s.value);
+    if constexpr (std::is_same_v<T, char> || std::is_same_v<T, unsigned char>)
+        ds.read((char *)v.data(), v.size());
+    else
+        for (auto &i : v)
+            ds >> i;
+    return ds;
+}
+
+template <typename DataStream, typename T, size_t N>
+DataStream &operator<<(DataStream &ds, const std::array<T, N> &v)
+{
+    for (const auto &i : v)
+        ds << i;
+    return ds;
+}
+
+template <typename DataStream, typename T, size_t N>
+DataStream &operator>>(DataStream &ds, std::array<T, N> &v)
+{
+    for (auto &i : v)
+        ds >> i;
+    return ds;
+}
+
+template <typename DataStream, typename T, size_t N>
+DataStream &operator<<(DataStream &ds, const T (&v)[N])
+{
+    for (size_t i = 0; i < N; ++i)
+        ds << v[i];
+    return ds;
+}
+
+template <typename DataStream, typename T, size_t N>
+DataStream &operator>>(DataStream &ds, T (&v)[N])
+{
+    for (size_t i = 0; i < N; ++i)
+        ds >> v[i];
+    return ds;
+}
+
+template <typename DataStream, typename T>
+DataStream &operator<<(DataStream &ds, const std::optional<T> &v)
+{
+    ds << (char)v.has_value();
+    if (v)
+        ds << *v;
+    return ds;
+}
+
+template <typename DataStream, typename T>
+DataStream &operator>>(DataStream &ds, std::optional<T> &v)
+{
+    char valid = 0;
+    ds >> valid;
+    if (valid)
+    {
+        T val;
+        ds >> val;
+        v = val;
+    }
+    else
+        v.reset();
+    return ds;
+}
+
+template <typename DataStream, typename A, typename B>
+DataStream &operator<<(DataStream &ds, const std::pair<A, B> &v) { return ds << v.first << v.second; }
+template <typename DataStream, typename A, typename B>
+DataStream &operator>>(DataStream &ds, std::pair<A, B> &v) { return ds >> v.first >> v.second; }
+
+template <typename DataStream, typename K, typename V>
+DataStream &operator<<(DataStream &ds, const std::map<K, V> &m)
+{
+    ds << unsigned_int((uint32_t)m.size());
+    for (const auto &i : m)
+        ds << i.first << i.second;
+    return ds;
+}
+
+template <typename DataStream, typename K, typename V>
+DataStream &operator>>(DataStream &ds, std::map<K, V> &m)
+{
+    m.clear();
+    unsigned_int s;
+    ds >> s;
+    for (uint32_t i = 0; i < s.value; ++i)
+    {
+        K k;
+        V v;
+        ds >> k >> v;
+        m.emplace(std::move(k), std::move(v));
+    }
+    return ds;
+}
+
+template <typename DataStream, typename K>
+DataStream &operator<<(DataStream &ds, const std::set<K> &s)
+{
+    ds << unsigned_int((uint32_t)s.size());
+    for (const auto &i : s)
+        ds << i;
+    return ds;
+}
+
+template <typename DataStream, typename K>
+DataStream &operator>>(DataStream &ds, std::set<K> &s)
+{
+    s.clear();
+    unsigned_int n;
+    ds >> n;
+    for (uint32_t i = 0; i < n.value; ++i)
+    {
+        K k;
+        ds >> k;
+        s.emplace(std::move(k));
+    }
+    return ds;
+}
+
+template <typename DataStream, typename... Args>
+DataStream &operator<<(DataStream &ds, const std::tuple<Args...> &t)
+{
+    std::apply([&](const auto &...e) { ((ds << e), ...); }, t);
+    return ds;
+}
+
+template <typename DataStream, typename... Args>
+DataStream &operator>>(DataStream &ds, std::tuple<Args...> &t)
+{
+    std::apply([&](auto &...e) { ((ds >> e), ...); }, t);
+    return ds;
+}
+
+// plain aggregates (table rows, action structs) pack field by field in declaration order,
+// the way cdt reflects them; types with EOSLIB_SERIALIZE use their own friend operators
+namespace reflect
+{
+struct any_field
+{
+    template <typename U>
+    operator U() const;
+};
+
+template <typename T, typename... Args>
+auto braces_test(int) -> decltype(T{std::declval<Args>()...}, std::true_type{});
+template <typename T, typename... Args>
+std::false_type braces_test(...);
+
+template <typename T, typename... Args>
+constexpr size_t field_count()
+{
+    if constexpr (decltype(braces_test<T, Args..., any_field>(0))::value)
+        return field_count<T, Args..., any_field>();
+    else
+        return sizeof...(Args);
+}
+
+#define _SIM_FIELDS_1 f1
+#define _SIM_FIELDS_2 _SIM_FIELDS_1, f2
+#define _SIM_FIELDS_3 _SIM_FIELDS_2, f3
+#define _SIM_FIELDS_4 _SIM_FIELDS_3, f4
+#define _SIM_FIELDS_5 _SIM_FIELDS_4, f5
+#define _SIM_FIELDS_6 _SIM_FIELDS_5, f6
+#define _SIM_FIELDS_7 _SIM_FIELDS_6, f7
+#define _SIM_FIELDS_8 _SIM_FIELDS_7, f8
+#define _SIM_FIELDS_9 _SIM_FIELDS_8, f9
+#define _SIM_FIELDS_10 _SIM_FIELDS_9, f10
+#define _SIM_FIELDS_11 _SIM_FIELDS_10, f11
+#define _SIM_FIELDS_12 _SIM_FIELDS_11, f12
+#define _SIM_FIELDS_13 _SIM_FIELDS_12, f13
+#define _SIM_FIELDS_14 _SIM_FIELDS_13, f14
+#define _SIM_FIELDS_15 _SIM_FIELDS_14, f15
+#define _SIM_FIELDS_16 _SIM_FIELDS_15, f16
+#define _SIM_FIELDS_17 _SIM_FIELDS_16, f17
+#define _SIM_FIELDS_18 _SIM_FIELDS_17, f18
+#define _SIM_FIELDS_19 _SIM_FIELDS_18, f19
+#define _SIM_FIELDS_20 _SIM_FIELDS_19, f20
+#define _SIM_FIELDS_21 _SIM_FIELDS_20, f21
+#define _SIM_FIELDS_22 _SIM_FIELDS_21, f22
+#define _SIM_FIELDS_23 _SIM_FIELDS_22, f23
+#define _SIM_FIELDS_24 _SIM_FIELDS_23, f24
+#define _SIM_FIELDS_25 _SIM_FIELDS_24, f25
+#define _SIM_FIELDS_26 _SIM_FIELDS_25, f26
+#define _SIM_FIELDS_27 _SIM_FIELDS_26, f27
+#define _SIM_FIELDS_28 _SIM_FIELDS_27, f28
+#define _SIM_FIELDS_29 _SIM_FIELDS_28, f29
+#define _SIM_FIELDS_30 _SIM_FIELDS_29, f30
+#define _SIM_FIELDS_31 _SIM_FIELDS_30, f31
+#define _SIM_FIELDS_32 _SIM_FIELDS_31, f32
+#define _SIM_FIELDS_CASE(N)                               \
+    else if constexpr (n == N)                            \
+    {                                                     \
+        auto &[_SIM_FIELDS_##N] = t;                      \
+        f(_SIM_FIELDS_##N);                               \
+    }
+
+template <typename T, typename F>
+void for_each_field(T &t, F &&f)
+{
+    constexpr size_t n = field_count<std::remove_const_t<T>>();
+    static_assert(n <= 32, "aggregate has too many fields to reflect");
+    if constexpr (n == 0)
+        ;
+    _SIM_FIELDS_CASE(1)
+    _SIM_FIELDS_CASE(2)
+    _SIM_FIELDS_CASE(3)
+    _SIM_FIELDS_CASE(4)
+    _SIM_FIELDS_CASE(5)
+    _SIM_FIELDS_CASE(6)
+    _SIM_FIELDS_CASE(7)
+    _SIM_FIELDS_CASE(8)
+    _SIM_FIELDS_CASE(9)
+    _SIM_FIELDS_CASE(10)
+    _SIM_FIELDS_CASE(11)
+    _SIM_FIELDS_CASE(12)
+    _SIM_FIELDS_CASE(13)
+    _SIM_FIELDS_CASE(14)
+    _SIM_FIELDS_CASE(15)
+    _SIM_FIELDS_CASE(16)
+    _SIM_FIELDS_CASE(17)
+    _SIM_FIELDS_CASE(18)
+    _SIM_FIELDS_CASE(19)
+    _SIM_FIELDS_CASE(20)
+    _SIM_FIELDS_CASE(21)
+    _SIM_FIELDS_CASE(22)
+    _SIM_FIELDS_CASE(23)
+    _SIM_FIELDS_CASE(24)
+    _SIM_FIELDS_CASE(25)
+    _SIM_FIELDS_CASE(26)
+    _SIM_FIELDS_CASE(27)
+    _SIM_FIELDS_CASE(28)
+    _SIM_FIELDS_CASE(29)
+    _SIM_FIELDS_CASE(30)
+    _SIM_FIELDS_CASE(31)
+    _SIM_FIELDS_CASE(32)
+}
+}
+
+template <typename DataStream, typename T, std::enable_if_t<std::is_class_v<T> && std::is_aggregate_v<T>> * = nullptr>
+DataStream &operator<<(DataStream &ds, const T &v)
+{
+    reflect::for_each_field(v, [&](const auto &...f) { ((ds << f), ...); });
+    return ds;
+}
+
+template <typename DataStream, typename T, std::enable_if_t<std::is_class_v<T> && std::is_aggregate_v<T>> * = nullptr>
+DataStream &operator>>(DataStream &ds, T &v)
+{
+    reflect::for_each_field(v, [&](auto &...f) { ((ds >> f), ...); });
+    return ds;
+}
+
+template <typename T>
+size_t pack_size(const T &value)
+{
+    datastream<size_t> ps;
+    ps << value;
+    return ps.tellp();
+}
+
+template <typename T>
+std::vector<char> pack(const T &value)
+{
+    std::vector<char> result;
+    result.resize(pack_size(value));
+    datastream<char *> ds(result.data(), result.size());
+    ds << value;
+    return result;
+}
+
+template <typename T>
+T unpack(const char *buffer, size_t len)
+{
+    T result{};
+    datastream<const char *> ds(buffer, len);
+    ds >> result;
+    return result;
+}
+
+template <typename T>
+T unpack(const std::vector<char> &bytes) { return unpack<T>(bytes.data(), bytes.size()); }
+}
+
+#define _EOSLIB_SER_CAT(a, b) _EOSLIB_SER_CAT_I(a, b)
+#define _EOSLIB_SER_CAT_I(a, b) a##b
+#define _EOSLIB_SER_OUT_A(m) << t.m _EOSLIB_SER_OUT_B
+#define _EOSLIB_SER_OUT_B(m) << t.m _EOSLIB_SER_OUT_A
+#define _EOSLIB_SER_OUT_A_END
+#define _EOSLIB_SER_OUT_B_END
+#define _EOSLIB_SER_IN_A(m) >> t.m _EOSLIB_SER_IN_B
+#define _EOSLIB_SER_IN_B(m) >> t.m _EOSLIB_SER_IN_A
+#define _EOSLIB_SER_IN_A_END
+#define _EOSLIB_SER_IN_B_END
+
+#define EOSLIB_SERIALIZE(TYPE, MEMBERS)                                                     \
+    template <typename DataStream>                                                          \
+    friend DataStream &operator<<(DataStream &ds, const TYPE &t)                            \
+    {                                                                                       \
+        return ds _EOSLIB_SER_CAT(_EOSLIB_SER_OUT_A MEMBERS, _END);                         \
+    }                                                                                       \
+    template <typename DataStream>                                                          \
+    friend DataStream &operator>>(DataStream &ds, TYPE &t)                                  \
+    {                                                                                       \
+        return ds _EOSLIB_SER_CAT(_EOSLIB_SER_IN_A MEMBERS, _END);                          \
+    }
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <eosiolib/name.hpp>
+
+// contract table storage, implemented by the simulator in chain.cpp; multi_index talks to it
+// in whole rows instead of the db_*_i64 iterator handles the chain exposes
+namespace sim
+{
+struct row
+{
+    uint64_t payer = 0;
+    std::string data;
+    std::vector<uint64_t> secondary;
+};
+
+struct table
+{
+    uint64_t code = 0;
+    uint64_t scope = 0;
+    uint64_t name = 0;
+    uint64_t payer = 0;
+    std::map<uint64_t, row> rows;
+
+    // secondary indices as ordered (key, primary key) sets, built by the first multi_index
+    // that opens the table with indices declared
+    size_t index_count = 0;
+    bool indexed = false;
+    std::vector<std::set<std::pair<uint64_t, uint64_t>>> indices;
+};
+
+table *db_find_table(uint64_t code, uint64_t scope, uint64_t table);
+table &db_open_table(uint64_t code, uint64_t scope, uint64_t table);
+void db_build_indices(table &t, size_t count, const std::function<std::vector<uint64_t>(const row &)> &keys);
+
+// rw-set bookkeeping for reads, a scan covers ordered walks and range lookups
+void db_read(uint64_t code, uint64_t scope, uint64_t table, uint64_t pk);
+void db_scan(uint64_t code, uint64_t scope, uint64_t table);
+
+void db_store(table &t, uint64_t pk, uint64_t payer, std::string data, std::vector<uint64_t> secondary);
+void db_update(table &t, uint64_t pk, uint64_t payer, std::string data, std::vector<uint64_t> secondary);
+void db_remove(table &t, uint64_t pk);
+
+uint64_t current_receiver();
+}
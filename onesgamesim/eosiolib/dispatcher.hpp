@@ -0,0 +1,40 @@
+#pragma once
+
+#include <eosiolib/contract.hpp>
+
+namespace eosio
+{
+template <typename T, typename... Args>
+bool execute_action(name self, name code, void (T::*func)(Args...))
+{
+    size_t size = action_data_size();
+    std::vector<char> buffer(size);
+    if (size > 0)
+        read_action_data(buffer.data(), size);
+
+    std::tuple<std::decay_t<Args>...> args;
+    datastream<const char *> ds(buffer.data(), size);
+    ds >> args;
+
+    T inst(self, code, ds);
+    std::apply([&](auto &...a) { (inst.*func)(a...); }, args);
+    return true;
+}
+}
+
+#define _EOSIO_DISPATCH_CAT(a, b) _EOSIO_DISPATCH_CAT_I(a, b)
+#define _EOSIO_DISPATCH_CAT_I(a, b) a##b
+#define _EOSIO_DISPATCH_CASE(elem)                                                          \
+    case eosio::name(#elem).value:                                                          \
+        eosio::execute_action(eosio::name(receiver), eosio::name(code), &_dispatch_t::elem); \
+        break;
+#define _EOSIO_DISPATCH_A(elem) _EOSIO_DISPATCH_CASE(elem) _EOSIO_DISPATCH_B
+#define _EOSIO_DISPATCH_B(elem) _EOSIO_DISPATCH_CASE(elem) _EOSIO_DISPATCH_A
+#define _EOSIO_DISPATCH_A_END
+#define _EOSIO_DISPATCH_B_END
+
+#define EOSIO_DISPATCH_HELPER(TYPE, MEMBERS)                  \
+    {                                                         \
+        typedef TYPE _dispatch_t;                             \
+        _EOSIO_DISPATCH_CAT(_EOSIO_DISPATCH_A MEMBERS, _END) \
+    }
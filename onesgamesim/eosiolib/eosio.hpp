@@ -0,0 +1,13 @@
+#pragma once
+
+// host build of the eosiolib subset the onesgame contracts use, backed by the simulator
+#include <eosiolib/system.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/symbol.hpp>
+#include <eosiolib/datastream.hpp>
+#include <eosiolib/action.hpp>
+#include <eosiolib/contract.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/dispatcher.hpp>
+#include <eosiolib/asset.hpp>
+#include <eosiolib/crypto.hpp>
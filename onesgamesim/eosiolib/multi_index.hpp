@@ -0,0 +1,544 @@
+#pragma once
+
+#include <eosiolib/datastream.hpp>
+#include <eosiolib/db.hpp>
+
+namespace eosio
+{
+template <class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+struct const_mem_fun
+{
+    typedef typename std::remove_reference<Type>::type result_type;
+
+    template <typename ChainedPtr>
+    auto operator()(const ChainedPtr &x) const -> std::enable_if_t<!std::is_convertible<const ChainedPtr &, const Class &>::value, Type>
+    {
+        return operator()(*x);
+    }
+
+    Type operator()(const Class &x) const { return (x.*PtrToMemberFunction)(); }
+};
+
+template <name::raw IndexName, typename Extractor>
+struct indexed_by
+{
+    enum constants
+    {
+        index_name = static_cast<uint64_t>(IndexName)
+    };
+    typedef Extractor secondary_extractor_type;
+};
+
+// rows are cached per instance like cdt does, so two instances over one table can see
+// different copies of a row until they reload it
+template <name::raw TableName, typename T, typename... Indices>
+class multi_index
+{
+private:
+    static_assert(sizeof...(Indices) <= 16, "multi_index only supports a maximum of 16 secondary indices");
+
+    struct item : public T
+    {
+        item() : T{} {}
+
+        uint64_t pk = 0;
+        std::vector<uint64_t> secondary;
+        bool deleted = false;
+    };
+
+    template <size_t I>
+    using index_t = std::tuple_element_t<I, std::tuple<Indices...>>;
+
+    template <size_t... I>
+    static std::vector<uint64_t> _secondary_keys(const T &obj, std::index_sequence<I...>)
+    {
+        return {(uint64_t) typename index_t<I>::secondary_extractor_type()(obj)...};
+    }
+
+    static std::vector<uint64_t> _secondary_keys(const T &obj)
+    {
+        return _secondary_keys(obj, std::index_sequence_for<Indices...>());
+    }
+
+    name _code;
+    uint64_t _scope;
+    mutable sim::table *_table = nullptr;
+    mutable std::vector<std::unique_ptr<item>> _items;
+    mutable std::map<uint64_t, item *> _cache;
+
+    sim::table *_find_table() const
+    {
+        if (_table == nullptr)
+        {
+            _table = sim::db_find_table(_code.value, _scope, static_cast<uint64_t>(TableName));
+            if (_table != nullptr)
+                _index_table(*_table);
+        }
+        return _table;
+    }
+
+    sim::table &_open_table()
+    {
+        if (_table == nullptr)
+        {
+            _table = &sim::db_open_table(_code.value, _scope, static_cast<uint64_t>(TableName));
+            _index_table(*_table);
+        }
+        return *_table;
+    }
+
+    static void _index_table(sim::table &t)
+    {
+        if constexpr (sizeof...(Indices) > 0)
+        {
+            if (!t.indexed)
+                sim::db_build_indices(t, sizeof...(Indices), [](const sim::row &r) {
+                    return _secondary_keys(unpack<T>(r.data.data(), r.data.size()));
+                });
+        }
+    }
+
+    void _scan() const { sim::db_scan(_code.value, _scope, static_cast<uint64_t>(TableName)); }
+
+    const item *_load(uint64_t pk) const
+    {
+        auto cached = _cache.find(pk);
+        if (cached != _cache.end())
+            return cached->second;
+
+        sim::table *t = _find_table();
+        if (t == nullptr)
+            return nullptr;
+        auto r = t->rows.find(pk);
+        if (r == t->rows.end())
+            return nullptr;
+        sim::db_read(_code.value, _scope, static_cast<uint64_t>(TableName), pk);
+
+        auto i = std::make_unique<item>();
+        datastream<const char *> ds(r->second.data.data(), r->second.data.size());
+        ds >> static_cast<T &>(*i);
+        i->pk = pk;
+        i->secondary = r->second.secondary;
+        item *p = i.get();
+        _items.push_back(std::move(i));
+        _cache[pk] = p;
+        return p;
+    }
+
+    const item *_next(uint64_t pk) const
+    {
+        sim::table *t = _find_table();
+        if (t == nullptr || pk == std::numeric_limits<uint64_t>::max())
+            return nullptr;
+        _scan();
+        auto r = t->rows.upper_bound(pk);
+        return r == t->rows.end() ? nullptr : _load(r->first);
+    }
+
+    const item *_prev(const item *i) const
+    {
+        sim::table *t = _find_table();
+        eosio_assert(t != nullptr && !t->rows.empty(), "cannot decrement end iterator when the table is empty");
+        _scan();
+        if (i == nullptr)
+            return _load(t->rows.rbegin()->first);
+        auto r = t->rows.lower_bound(i->pk);
+        eosio_assert(r != t->rows.begin(), "cannot decrement iterator at beginning of table");
+        return _load(std::prev(r)->first);
+    }
+
+public:
+    struct const_iterator
+    {
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef const T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        const T &operator*() const
+        {
+            eosio_assert(_item != nullptr, "cannot dereference end iterator");
+            return *static_cast<const T *>(_item);
+        }
+        const T *operator->() const { return &operator*(); }
+
+        const_iterator &operator++()
+        {
+            eosio_assert(_item != nullptr, "cannot increment end iterator");
+            _item = _multidx->_next(_item->pk);
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator result(*this);
+            ++(*this);
+            return result;
+        }
+        const_iterator &operator--()
+        {
+            _item = _multidx->_prev(_item);
+            return *this;
+        }
+        const_iterator operator--(int)
+        {
+            const_iterator result(*this);
+            --(*this);
+            return result;
+        }
+
+        friend bool operator==(const const_iterator &a, const const_iterator &b) { return a._item == b._item; }
+        friend bool operator!=(const const_iterator &a, const const_iterator &b) { return a._item != b._item; }
+
+        const_iterator() {}
+
+    private:
+        friend class multi_index;
+        const_iterator(const multi_index *mi, const item *i = nullptr) : _multidx(mi), _item(i) {}
+
+        const multi_index *_multidx = nullptr;
+        const item *_item = nullptr;
+    };
+
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    typedef T row_type;
+    static constexpr uint64_t table_name = static_cast<uint64_t>(TableName);
+    static constexpr size_t index_count = sizeof...(Indices);
+
+    template <size_t I>
+    struct index
+    {
+        static_assert(std::is_same_v<typename index_t<I>::secondary_extractor_type::result_type, uint64_t>,
+                      "the simulator only supports uint64_t secondary keys");
+
+        struct const_iterator
+        {
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef const T value_type;
+            typedef ptrdiff_t difference_type;
+            typedef const T *pointer;
+            typedef const T &reference;
+
+            const T &operator*() const
+            {
+                eosio_assert(_item != nullptr, "cannot dereference end iterator");
+                return *static_cast<const T *>(_item);
+            }
+            const T *operator->() const { return &operator*(); }
+
+            const_iterator &operator++()
+            {
+                eosio_assert(_item != nullptr, "cannot increment end iterator");
+                _item = _idx->_next(_item);
+                return *this;
+            }
+            const_iterator operator++(int)
+            {
+                const_iterator result(*this);
+                ++(*this);
+                return result;
+            }
+            const_iterator &operator--()
+            {
+                _item = _idx->_prev(_item);
+                return *this;
+            }
+            const_iterator operator--(int)
+            {
+                const_iterator result(*this);
+                --(*this);
+                return result;
+            }
+
+            friend bool operator==(const const_iterator &a, const const_iterator &b) { return a._item == b._item; }
+            friend bool operator!=(const const_iterator &a, const const_iterator &b) { return a._item != b._item; }
+
+            const_iterator() {}
+
+        private:
+            friend struct index;
+            const_iterator(const index *idx, const item *i = nullptr) : _idx(idx), _item(i) {}
+
+            const index *_idx = nullptr;
+            const item *_item = nullptr;
+        };
+
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        const_iterator cbegin() const { return lower_bound(0); }
+        const_iterator begin() const { return cbegin(); }
+        const_iterator cend() const { return const_iterator(this); }
+        const_iterator end() const { return cend(); }
+        const_reverse_iterator crbegin() const { return std::make_reverse_iterator(cend()); }
+        const_reverse_iterator rbegin() const { return crbegin(); }
+        const_reverse_iterator crend() const { return std::make_reverse_iterator(cbegin()); }
+        const_reverse_iterator rend() const { return crend(); }
+
+        const_iterator find(uint64_t key) const
+        {
+            auto itr = lower_bound(key);
+            if (itr == end() || itr._item->secondary[I] != key)
+                return end();
+            return itr;
+        }
+
+        const_iterator lower_bound(uint64_t key) const
+        {
+            sim::table *t = _multidx->_find_table();
+            _multidx->_scan();
+            if (t == nullptr)
+                return end();
+            auto &set = t->indices[I];
+            auto e = set.lower_bound({key, 0});
+            return const_iterator(this, e == set.end() ? nullptr : _multidx->_load(e->second));
+        }
+
+        const_iterator upper_bound(uint64_t key) const
+        {
+            if (key == std::numeric_limits<uint64_t>::max())
+                return end();
+            return lower_bound(key + 1);
+        }
+
+        const_iterator iterator_to(const T &obj) const
+        {
+            const item &i = static_cast<const item &>(obj);
+            eosio_assert(!i.deleted, "cannot iterate to deleted object");
+            return const_iterator(this, &i);
+        }
+
+        template <typename Lambda>
+        void modify(const_iterator itr, name payer, Lambda &&updater)
+        {
+            eosio_assert(itr != cend(), "cannot pass end iterator to modify");
+            _multidx->modify(*itr, payer, std::forward<Lambda>(updater));
+        }
+
+        const_iterator erase(const_iterator itr)
+        {
+            eosio_assert(itr != cend(), "cannot pass end iterator to erase");
+            const_iterator next = itr;
+            ++next;
+            uint64_t next_pk = next._item == nullptr ? 0 : next._item->pk;
+            _multidx->erase(*itr);
+            return next._item == nullptr ? end() : const_iterator(this, _multidx->_load(next_pk));
+        }
+
+        const T &get(uint64_t key, const char *error_msg = "unable to find secondary key") const
+        {
+            auto result = find(key);
+            eosio_assert(result != cend(), error_msg);
+            return *result;
+        }
+
+        name get_code() const { return _multidx->get_code(); }
+        uint64_t get_scope() const { return _multidx->get_scope(); }
+
+    private:
+        friend class multi_index;
+        index(multi_index *mi) : _multidx(mi) {}
+
+        const item *_next(const item *i) const
+        {
+            sim::table *t = _multidx->_find_table();
+            _multidx->_scan();
+            auto &set = t->indices[I];
+            auto e = set.upper_bound({i->secondary[I], i->pk});
+            return e == set.end() ? nullptr : _multidx->_load(e->second);
+        }
+
+        const item *_prev(const item *i) const
+        {
+            sim::table *t = _multidx->_find_table();
+            eosio_assert(t != nullptr && !t->indices[I].empty(), "cannot decrement end iterator when the index is empty");
+            _multidx->_scan();
+            auto &set = t->indices[I];
+            if (i == nullptr)
+                return _multidx->_load(set.rbegin()->second);
+            auto e = set.lower_bound({i->secondary[I], i->pk});
+            eosio_assert(e != set.begin(), "cannot decrement iterator at beginning of index");
+            return _multidx->_load(std::prev(e)->second);
+        }
+
+        multi_index *_multidx;
+    };
+
+    multi_index(name code, uint64_t scope) : _code(code), _scope(scope) {}
+    multi_index(const multi_index &) = delete;
+    multi_index &operator=(const multi_index &) = delete;
+
+    name get_code() const { return _code; }
+    uint64_t get_scope() const { return _scope; }
+
+    const_iterator cbegin() const { return lower_bound(std::numeric_limits<uint64_t>::lowest()); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cend() const { return const_iterator(this); }
+    const_iterator end() const { return cend(); }
+    const_reverse_iterator crbegin() const { return std::make_reverse_iterator(cend()); }
+    const_reverse_iterator rbegin() const { return crbegin(); }
+    const_reverse_iterator crend() const { return std::make_reverse_iterator(cbegin()); }
+    const_reverse_iterator rend() const { return crend(); }
+
+    const_iterator lower_bound(uint64_t primary) const
+    {
+        sim::table *t = _find_table();
+        _scan();
+        if (t == nullptr)
+            return end();
+        auto r = t->rows.lower_bound(primary);
+        return const_iterator(this, r == t->rows.end() ? nullptr : _load(r->first));
+    }
+
+    const_iterator upper_bound(uint64_t primary) const
+    {
+        if (primary == std::numeric_limits<uint64_t>::max())
+            return end();
+        return lower_bound(primary + 1);
+    }
+
+    uint64_t available_primary_key() const
+    {
+        sim::table *t = _find_table();
+        _scan();
+        if (t == nullptr || t->rows.empty())
+            return 0;
+        uint64_t next = t->rows.rbegin()->first + 1;
+        eosio_assert(next < std::numeric_limits<uint64_t>::max() - 1, "next primary key in table is at autoincrement limit");
+        return next;
+    }
+
+    template <name::raw IndexName>
+    auto get_index()
+    {
+        constexpr size_t I = _index_position<IndexName>();
+        static_assert(I < sizeof...(Indices), "name provided is not the name of any secondary index within multi_index");
+        return index<I>(this);
+    }
+
+    template <name::raw IndexName>
+    auto get_index() const
+    {
+        constexpr size_t I = _index_position<IndexName>();
+        static_assert(I < sizeof...(Indices), "name provided is not the name of any secondary index within multi_index");
+        return index<I>(const_cast<multi_index *>(this));
+    }
+
+    const_iterator iterator_to(const T &obj) const
+    {
+        const item &i = static_cast<const item &>(obj);
+        eosio_assert(!i.deleted, "cannot iterate to deleted object");
+        return const_iterator(this, &i);
+    }
+
+    template <typename Lambda>
+    const_iterator emplace(name payer, Lambda &&constructor)
+    {
+        eosio_assert(_code.value == sim::current_receiver(), "cannot create objects in table of another contract");
+
+        auto i = std::make_unique<item>();
+        constructor(static_cast<T &>(*i));
+
+        uint64_t pk = i->primary_key();
+        sim::table &t = _open_table();
+        eosio_assert(t.rows.find(pk) == t.rows.end(), "could not insert object, most likely a uniqueness constraint was violated");
+
+        i->pk = pk;
+        i->secondary = _secondary_keys(*i);
+        sim::db_store(t, pk, payer.value, _pack(*i), i->secondary);
+
+        item *p = i.get();
+        _items.push_back(std::move(i));
+        auto cached = _cache.find(pk);
+        if (cached != _cache.end())
+            cached->second->deleted = true;
+        _cache[pk] = p;
+        return const_iterator(this, p);
+    }
+
+    template <typename Lambda>
+    void modify(const_iterator itr, name payer, Lambda &&updater)
+    {
+        eosio_assert(itr != end(), "cannot pass end iterator to modify");
+        modify(*itr, payer, std::forward<Lambda>(updater));
+    }
+
+    template <typename Lambda>
+    void modify(const T &obj, name payer, Lambda &&updater)
+    {
+        eosio_assert(_code.value == sim::current_receiver(), "cannot modify objects in table of another contract");
+
+        item &i = const_cast<item &>(static_cast<const item &>(obj));
+        eosio_assert(!i.deleted, "cannot modify a deleted object");
+
+        uint64_t pk = i.pk;
+        updater(static_cast<T &>(i));
+        eosio_assert(pk == i.primary_key(), "updater cannot change primary key when modifying an object");
+
+        i.secondary = _secondary_keys(i);
+        sim::db_update(_open_table(), pk, payer.value, _pack(i), i.secondary);
+    }
+
+    const T &get(uint64_t primary, const char *error_msg = "unable to find key") const
+    {
+        auto result = find(primary);
+        eosio_assert(result != cend(), error_msg);
+        return *result;
+    }
+
+    const_iterator find(uint64_t primary) const
+    {
+        sim::db_read(_code.value, _scope, static_cast<uint64_t>(TableName), primary);
+        return const_iterator(this, _load(primary));
+    }
+
+    const_iterator require_find(uint64_t primary, const char *error_msg = "unable to find key") const
+    {
+        auto result = find(primary);
+        eosio_assert(result != cend(), error_msg);
+        return result;
+    }
+
+    const_iterator erase(const_iterator itr)
+    {
+        eosio_assert(itr != end(), "cannot pass end iterator to erase");
+        const_iterator next = itr;
+        ++next;
+        erase(*itr);
+        return next;
+    }
+
+    void erase(const T &obj)
+    {
+        eosio_assert(_code.value == sim::current_receiver(), "cannot erase objects in table of another contract");
+
+        item &i = const_cast<item &>(static_cast<const item &>(obj));
+        eosio_assert(!i.deleted, "cannot erase a deleted object");
+        sim::db_remove(_open_table(), i.pk);
+        i.deleted = true;
+        _cache.erase(i.pk);
+    }
+
+private:
+    template <name::raw IndexName, size_t I = 0>
+    static constexpr size_t _index_position()
+    {
+        if constexpr (I == sizeof...(Indices))
+            return I;
+        else if constexpr (index_t<I>::index_name == static_cast<uint64_t>(IndexName))
+            return I;
+        else
+            return _index_position<IndexName, I + 1>();
+    }
+
+    static std::string _pack(const T &obj)
+    {
+        datastream<size_t> ps;
+        ps << obj;
+        std::string data(ps.tellp(), '\0');
+        datastream<char *> ds(&data[0], data.size());
+        ds << obj;
+        return data;
+    }
+};
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <eosiolib/system.hpp>
+
+namespace eosio
+{
+struct name
+{
+    enum class raw : uint64_t
+    {
+    };
+
+    uint64_t value = 0;
+
+    constexpr name() {}
+    constexpr explicit name(uint64_t v) : value(v) {}
+    constexpr name(raw r) : value((uint64_t)r) {}
+    constexpr explicit name(std::string_view str)
+    {
+        if (str.size() > 13)
+            eosio_assert(false, "string is too long to be a valid name");
+        if (str.empty())
+            return;
+
+        auto n = std::min((uint32_t)str.size(), (uint32_t)12u);
+        for (decltype(n) i = 0; i < n; ++i)
+        {
+            value <<= 5;
+            value |= char_to_value(str[i]);
+        }
+        value <<= (4 + 5 * (12 - n));
+        if (str.size() == 13)
+        {
+            uint64_t v = char_to_value(str[12]);
+            if (v > 0x0Full)
+                eosio_assert(false, "thirteenth character in name cannot be a letter that comes after j");
+            value |= v;
+        }
+    }
+
+    static constexpr uint8_t char_to_value(char c)
+    {
+        if (c == '.')
+            return 0;
+        else if (c >= '1' && c <= '5')
+            return (c - '1') + 1;
+        else if (c >= 'a' && c <= 'z')
+            return (c - 'a') + 6;
+        else
+            eosio_assert(false, "character is not in allowed character set for names");
+        return 0;
+    }
+
+    constexpr uint8_t length() const
+    {
+        constexpr uint64_t mask = 0xF800000000000000ull;
+        if (value == 0)
+            return 0;
+
+        uint8_t l = 0;
+        uint8_t i = 0;
+        for (auto v = value; i < 13; ++i, v <<= 5)
+            if ((v & mask) > 0)
+                l = i;
+        return l + 1;
+    }
+
+    std::string to_string() const
+    {
+        static const char *charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+        char buffer[13];
+        auto v = value;
+        buffer[12] = charmap[v & 0x0F];
+        v >>= 4;
+        for (int i = 11; i >= 0; --i, v >>= 5)
+            buffer[i] = charmap[v & 0x1F];
+        return std::string(buffer, length());
+    }
+
+    constexpr operator raw() const { return raw(value); }
+    constexpr explicit operator bool() const { return value != 0; }
+
+    friend constexpr bool operator==(const name &a, const name &b) { return a.value == b.value; }
+    friend constexpr bool operator!=(const name &a, const name &b) { return a.value != b.value; }
+    friend constexpr bool operator<(const name &a, const name &b) { return a.value < b.value; }
+};
+
+inline namespace literals
+{
+template <typename T, T... Str>
+inline constexpr name operator""_n()
+{
+    constexpr const char buf[] = {Str...};
+    return name(std::string_view(buf, sizeof(buf)));
+}
+}
+}
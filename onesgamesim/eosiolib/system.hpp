@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
+
+// chain intrinsics, implemented by the simulator in chain.cpp
+void eosio_assert(uint32_t test, const char *msg);
+void eosio_assert_message(uint32_t test, const char *msg, uint32_t len);
+[[noreturn]] void eosio_exit(int32_t code);
+uint64_t current_time();
+inline uint32_t now() { return (uint32_t)(current_time() / 1000000); }
+
+uint32_t read_action_data(void *msg, uint32_t len);
+uint32_t action_data_size();
+size_t transaction_size();
+int read_transaction(char *buffer, size_t size);
+
+namespace eosio
+{
+inline void check(bool pred, const char *msg) { eosio_assert(pred, msg); }
+inline void check(bool pred, const std::string &msg) { eosio_assert(pred, msg.c_str()); }
+}
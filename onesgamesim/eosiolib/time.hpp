@@ -0,0 +1,58 @@
+#pragma once
+
+#include <eosiolib/datastream.hpp>
+
+namespace eosio
+{
+class microseconds
+{
+public:
+    explicit microseconds(int64_t c = 0) : _count(c) {}
+    int64_t count() const { return _count; }
+    int64_t to_seconds() const { return _count / 1000000; }
+
+    friend microseconds operator+(const microseconds &l, const microseconds &r) { return microseconds(l._count + r._count); }
+    friend microseconds operator-(const microseconds &l, const microseconds &r) { return microseconds(l._count - r._count); }
+    friend bool operator==(const microseconds &l, const microseconds &r) { return l._count == r._count; }
+    friend bool operator<(const microseconds &l, const microseconds &r) { return l._count < r._count; }
+
+    EOSLIB_SERIALIZE(microseconds, (_count))
+
+    int64_t _count;
+};
+
+inline microseconds seconds(int64_t s) { return microseconds(s * 1000000); }
+inline microseconds milliseconds(int64_t s) { return microseconds(s * 1000); }
+
+class time_point
+{
+public:
+    explicit time_point(microseconds e = microseconds()) : elapsed(e) {}
+    const microseconds &time_since_epoch() const { return elapsed; }
+    uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+
+    friend bool operator<(const time_point &l, const time_point &r) { return l.elapsed < r.elapsed; }
+
+    microseconds elapsed;
+
+    EOSLIB_SERIALIZE(time_point, (elapsed))
+};
+
+class time_point_sec
+{
+public:
+    time_point_sec() : utc_seconds(0) {}
+    explicit time_point_sec(uint32_t seconds) : utc_seconds(seconds) {}
+    time_point_sec(const time_point &t) : utc_seconds(t.sec_since_epoch()) {}
+
+    uint32_t sec_since_epoch() const { return utc_seconds; }
+
+    friend bool operator<(const time_point_sec &l, const time_point_sec &r) { return l.utc_seconds < r.utc_seconds; }
+
+    uint32_t utc_seconds;
+
+    EOSLIB_SERIALIZE(time_point_sec, (utc_seconds))
+};
+
+inline time_point current_time_point() { return time_point(microseconds(current_time())); }
+}
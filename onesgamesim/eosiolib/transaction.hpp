@@ -0,0 +1,39 @@
+#pragma once
+
+#include <eosiolib/action.hpp>
+
+namespace eosio
+{
+struct transaction_header
+{
+    uint32_t expiration = 0;
+    uint16_t ref_block_num = 0;
+    uint32_t ref_block_prefix = 0;
+    unsigned_int max_net_usage_words = 0;
+    uint8_t max_cpu_usage_ms = 0;
+    unsigned_int delay_sec = 0;
+
+    EOSLIB_SERIALIZE(transaction_header, (expiration)(ref_block_num)(ref_block_prefix)(max_net_usage_words)(max_cpu_usage_ms)(delay_sec))
+};
+
+typedef std::vector<std::pair<uint16_t, std::vector<char>>> extensions_type;
+
+struct transaction : public transaction_header
+{
+    std::vector<action> context_free_actions;
+    std::vector<action> actions;
+    extensions_type transaction_extensions;
+
+    template <typename DataStream>
+    friend DataStream &operator<<(DataStream &ds, const transaction &t)
+    {
+        return ds << (const transaction_header &)t << t.context_free_actions << t.actions << t.transaction_extensions;
+    }
+
+    template <typename DataStream>
+    friend DataStream &operator>>(DataStream &ds, transaction &t)
+    {
+        return ds >> (transaction_header &)t >> t.context_free_actions >> t.actions >> t.transaction_extensions;
+    }
+};
+}
@@ -0,0 +1,489 @@
+// random swaps, routes, liquidity, zaps, queue and vault actions against onesgamedefi, checking
+// the pool invariants after every transaction that goes through
+#include "onesgamesim.hpp"
+
+#include <random>
+
+namespace sim
+{
+using eosio::asset;
+using eosio::name;
+using eosio::permission_level;
+using eosio::symbol;
+
+namespace
+{
+const name DEFI("onesgamedefi");
+const name PLAY("onesgameplay");
+const name MINE("onesgamemine");
+
+struct token
+{
+    name contract;
+    symbol sym;
+};
+
+const token EOS{name("eosio.token"), symbol("EOS", 4)};
+const token USDT{name("tethertether"), symbol("USDT", 4)};
+const token USDS{name("fuzzstable11"), symbol("USDS", 6)};
+const token ONES{name("eosonestoken"), symbol("ONES", 4)};
+
+struct token_arg
+{
+    name address;
+    symbol sym;
+
+    EOSLIB_SERIALIZE(token_arg, (address)(sym))
+};
+
+class fuzzer
+{
+public:
+    fuzzer(chain &c, uint64_t seed) : _c(c), _rand(seed) {}
+
+    void setup();
+    std::string step();
+    std::string check(const defi_state &before, const defi_state &after) const;
+
+    std::map<std::string, uint64_t> ran, rejected;
+
+private:
+    template <typename T>
+    eosio::action act(name actor, name contract, name action, T &&args)
+    {
+        return eosio::action(permission_level(actor, name("active")), contract, action, std::forward<T>(args));
+    }
+
+    eosio::action transfer(name from, const token &t, int64_t amount, const std::string &memo)
+    {
+        return act(from, t.contract, name("transfer"), std::make_tuple(from, DEFI, asset(amount, t.sym), memo));
+    }
+
+    void push(std::vector<eosio::action> actions)
+    {
+        eosio::transaction trx;
+        trx.actions = std::move(actions);
+        trx.expiration = _c.time_us / 1000000 + 30;
+        trx.ref_block_num = (uint16_t)++_trx;
+        trx.ref_block_prefix = (uint32_t)(_trx >> 16);
+        _c.push(trx);
+    }
+
+    uint64_t pick(uint64_t n) { return n == 0 ? 0 : _rand() % n; }
+
+    // mostly small against the reserve, now and then dust or a tenth of it
+    int64_t amount(int64_t reserve)
+    {
+        switch (pick(4))
+        {
+        case 0:
+            return 1 + pick(100);
+        case 1:
+            return 1 + pick(std::max<int64_t>(reserve / 10, 1));
+        default:
+            return 1 + pick(std::max<int64_t>(reserve / 1000, 1));
+        }
+    }
+
+    name user() { return _users[pick(_users.size())]; }
+    // one of the pools f accepts
+    template <typename F>
+    const defi_pool &pool(const defi_state &s, F f)
+    {
+        std::vector<const defi_pool *> eligible;
+        for (const auto &p : s.pools)
+            if (f(p.second))
+                eligible.push_back(&p.second);
+        return *eligible[pick(eligible.size())];
+    }
+
+    uint64_t share(uint64_t held) { return held == 0 ? 0 : 1 + pick(held); }
+
+    chain &_c;
+    std::mt19937_64 _rand;
+    uint64_t _trx = 0;
+    std::vector<name> _users;
+    std::set<uint64_t> _lp_pools;
+};
+
+void fuzzer::setup()
+{
+    _c.deploy(USDT.contract, token_apply);
+    _c.deploy(USDS.contract, token_apply);
+    _c.deploy(ONES.contract, token_apply);
+    for (const char *account : {"onesgameplay", "onesgamefund", "fuzzer1", "fuzzer2", "fuzzer3", "fuzzer4"})
+        _c.create_account(name(account));
+    _users = {name("fuzzer1"), name("fuzzer2"), name("fuzzer3"), name("fuzzer4")};
+
+    // the config singleton predates every action of the contract, no action creates it
+    table &config = db_open_table(DEFI.value, DEFI.value, name("config").value);
+    _c.put_row(config, name("config").value, row{DEFI.value, std::string(3 * sizeof(uint64_t), '\0'), {}});
+
+    for (const token &t : {EOS, USDT, USDS})
+    {
+        push({act(t.contract, t.contract, name("create"), std::make_tuple(t.contract, asset(asset::max_amount, t.sym)))});
+        for (name u : _users)
+            push({act(t.contract, t.contract, name("issue"),
+                      std::make_tuple(u, asset(1000000000 * (int64_t)std::pow(10, t.sym.precision()), t.sym), std::string()))});
+    }
+
+    // onesgamemine: its config predates every action too; a large swap pool so swaps in pool 1 feed
+    // market rounds, ONES to pay swap mining from, and EOS as a credited reward so rounds pay a token
+    // the vaults can harvest
+    table &mine_config = db_open_table(MINE.value, MINE.value, name("config").value);
+    std::vector<char> packed = eosio::pack(std::make_tuple(
+        (uint64_t)(_c.time_us / 1000000), (uint64_t)10000000000ULL, (uint64_t)0, (uint64_t)0, (uint64_t)0,
+        std::vector<uint64_t>(), (uint64_t)0, (uint64_t)0, std::vector<uint64_t>(1), (uint64_t)0));
+    _c.put_row(mine_config, name("config").value, row{MINE.value, std::string(packed.begin(), packed.end()), {}});
+    push({act(ONES.contract, ONES.contract, name("create"), std::make_tuple(ONES.contract, asset(asset::max_amount, ONES.sym)))});
+    // issued to the token contract first, onesgamemine takes issue notifications for its own rounds
+    push({act(ONES.contract, ONES.contract, name("issue"),
+              std::make_tuple(ONES.contract, asset(asset::max_amount, ONES.sym), std::string()))});
+    push({act(ONES.contract, ONES.contract, name("transfer"),
+              std::make_tuple(ONES.contract, MINE, asset(asset::max_amount, ONES.sym), std::string()))});
+    push({act(PLAY, MINE, name("init"), std::make_tuple())});
+    push({act(PLAY, MINE, name("addtoken"), std::make_tuple(EOS.sym, EOS.contract))});
+    push({act(name("onesgamedivd"), name("onesgamedivd"), name("init"), std::make_tuple())});
+
+    // 1: EOS/USDT constant product, 2: USDT/USDS stable, 3: EOS/USDS with the EOS price in [1, 20]
+    name creator = _users[0];
+    const std::pair<token, token> pairs[] = {{EOS, USDT}, {USDT, USDS}, {EOS, USDS}};
+    for (const auto &p : pairs)
+        push({act(creator, DEFI, name("newliquidity"),
+                  std::make_tuple(creator, token_arg{p.first.contract, p.first.sym}, token_arg{p.second.contract, p.second.sym}))});
+    push({act(PLAY, DEFI, name("setcurve"), std::make_tuple((uint64_t)2, (uint64_t)2, (uint64_t)200, (uint64_t)0))});
+    push({act(PLAY, DEFI, name("setcurve"), std::make_tuple((uint64_t)3, (uint64_t)1, (uint64_t)100000000, (uint64_t)2000000000))});
+
+    const int64_t seed[][2] = {{10000 * 10000LL, 40000 * 10000LL}, {50000 * 10000LL, 50000 * 1000000LL}, {10000 * 10000LL, 40000 * 1000000LL}};
+    for (uint64_t id = 1; id <= 3; id++)
+    {
+        const auto &p = pairs[id - 1];
+        std::string memo = "addliquidity," + std::to_string(id);
+        push({transfer(creator, p.first, seed[id - 1][0], memo), transfer(creator, p.second, seed[id - 1][1], memo),
+              act(creator, DEFI, name("addliquidity"), std::make_tuple(creator, id))});
+    }
+
+    // pool 1 mines on swaps, the vault pools on liquidity
+    push({act(PLAY, DEFI, name("updateweight"), std::make_tuple((uint64_t)1, (uint64_t)2, 1.0f))});
+    for (uint64_t id : {1, 2})
+        push({act(PLAY, DEFI, name("updateweight"), std::make_tuple((uint64_t)id, (uint64_t)1, 1.0f))});
+
+    _lp_pools = {1, 3};
+    for (uint64_t id : _lp_pools)
+        push({act(PLAY, DEFI, name("lpenable"), std::make_tuple(id))});
+    push({act(PLAY, DEFI, name("vaultopen"), std::make_tuple((uint64_t)1))});
+    push({act(PLAY, DEFI, name("vaultopen"), std::make_tuple((uint64_t)2))});
+}
+
+// runs one random transaction, returns what it was; a rejected one is counted and left at that
+std::string fuzzer::step()
+{
+    _c.time_us += pick(10) * 1000000;
+
+    defi_state s = read_defi();
+    uint64_t kind = pick(16);
+    const defi_pool &p = pool(s, [&](const defi_pool &p) {
+        return kind == 10 ? _lp_pools.count(p.id) > 0 : kind >= 11 ? p.vault : true;
+    });
+    name u = user();
+    std::string id = std::to_string(p.id);
+    token t1{p.contract1, p.symbol1}, t2{p.contract2, p.symbol2};
+    bool first = pick(2) == 0;
+    const token &in = first ? t1 : t2;
+    int64_t in_amount = amount(first ? p.reserve1 : p.reserve2);
+
+    std::string op, text;
+    std::vector<eosio::action> actions;
+    switch (kind)
+    {
+    case 0:
+    case 1:
+    case 2:
+    case 3:
+    {
+        op = "swap";
+        std::string route = id;
+        // a second hop through another pool holding the output token
+        if (pick(3) == 0)
+        {
+            const token &out = first ? t2 : t1;
+            for (const auto &other : s.pools)
+                if (other.first != p.id && ((other.second.contract1 == out.contract && other.second.symbol1 == out.sym) ||
+                                            (other.second.contract2 == out.contract && other.second.symbol2 == out.sym)))
+                {
+                    route += "-" + std::to_string(other.first);
+                    op = "route";
+                    break;
+                }
+        }
+        actions.push_back(transfer(u, in, in_amount, "swap,0,100," + route));
+        break;
+    }
+    case 4:
+    case 5:
+    {
+        op = "addliquidity";
+        int64_t amount1 = amount(p.reserve1);
+        // off the pool ratio by up to 5%, the contract refunds the surplus
+        int64_t amount2 = p.reserve1 == 0 ? 1 : (int64_t)((__int128)amount1 * p.reserve2 / p.reserve1 * (100 + pick(6)) / 100);
+        std::string memo = "addliquidity," + id;
+        actions = {transfer(u, t1, amount1, memo), transfer(u, t2, std::max<int64_t>(amount2, 1), memo),
+                   act(u, DEFI, name("addliquidity"), std::make_tuple(u, p.id))};
+        break;
+    }
+    case 6:
+        op = "zap";
+        actions.push_back(transfer(u, in, in_amount, "zap," + id + ",0"));
+        break;
+    case 7:
+    {
+        op = "subliquidity";
+        auto held = p.holders.find(u.value);
+        actions.push_back(act(u, DEFI, name("subliquidity"),
+                              std::make_tuple(u, p.id, share(held == p.holders.end() ? 0 : held->second))));
+        break;
+    }
+    case 8:
+    {
+        op = "reserve";
+        auto held = p.holders.find(u.value);
+        actions.push_back(
+            act(u, DEFI, name("reserve"), std::make_tuple(u, p.id, share(held == p.holders.end() ? 0 : held->second))));
+        break;
+    }
+    case 9:
+    {
+        if (s.queue.empty() || pick(3) == 0)
+        {
+            op = "processqueue";
+            actions.push_back(act(PLAY, DEFI, name("processqueue"), std::make_tuple((uint64_t)(1 + pick(5)))));
+            break;
+        }
+        op = "claim";
+        const auto &q = s.queue[pick(s.queue.size())];
+        actions.push_back(act(name(q.second), DEFI, name("claim"), std::make_tuple(name(q.second), q.first)));
+        break;
+    }
+    case 10:
+    {
+        auto held = p.holders.find(u.value);
+        if (pick(2) == 0)
+        {
+            op = "wraplp";
+            actions.push_back(
+                act(u, DEFI, name("wraplp"), std::make_tuple(u, p.id, share(held == p.holders.end() ? 0 : held->second))));
+        }
+        else
+        {
+            op = "unwraplp";
+            actions.push_back(act(u, DEFI, name("unwraplp"), std::make_tuple(u, p.id, share(p.wrapped / 4))));
+        }
+        break;
+    }
+    case 11:
+        op = "vault";
+        actions.push_back(transfer(u, in, in_amount, "vault," + id + ",0"));
+        break;
+    case 12:
+    {
+        op = "vaultexit";
+        auto held = p.shareholders.find(u.value);
+        actions.push_back(act(u, DEFI, name("vaultexit"),
+                              std::make_tuple(u, p.id, share(held == p.shareholders.end() ? 0 : held->second))));
+        break;
+    }
+    case 13:
+        op = "compound";
+        actions.push_back(act(PLAY, DEFI, name("compound"), std::make_tuple(p.id, (uint64_t)0)));
+        break;
+    case 14:
+        if (pick(2) == 0)
+        {
+            // an EOS reward for the round, then the round
+            op = "minemarkets";
+            actions.push_back(act(u, EOS.contract, name("transfer"),
+                                  std::make_tuple(u, MINE, asset(1 + pick(1000000), EOS.sym), std::string())));
+            actions.push_back(act(PLAY, MINE, name("minemarkets"), std::make_tuple()));
+        }
+        else
+        {
+            op = "vaultclaim";
+            actions.push_back(act(PLAY, DEFI, name("vaultclaim"), std::make_tuple()));
+        }
+        break;
+    default:
+    {
+        // mined EOS into the vault, through pool 1 at any slippage when the vault's pool has no EOS;
+        // claimed first when nothing is held
+        auto mined = s.mined.find({EOS.contract.value, EOS.sym.raw()});
+        int64_t held = mined == s.mined.end() ? 0 : mined->second;
+        if (held == 0)
+        {
+            op = "vaultclaim";
+            actions.push_back(act(PLAY, DEFI, name("vaultclaim"), std::make_tuple()));
+            break;
+        }
+        op = "vaultharvest";
+        bool direct = p.contract1 == EOS.contract || p.contract2 == EOS.contract;
+        actions.push_back(act(PLAY, DEFI, name("vaultharvest"),
+                              std::make_tuple(p.id, EOS.contract, asset(share(held), EOS.sym), (uint64_t)100,
+                                              std::string(direct ? "" : "1"))));
+        break;
+    }
+    }
+
+    text = op + " pool " + id + " by " + u.to_string();
+    if (!actions.empty() && actions[0].name == name("transfer"))
+        text += " of " + std::to_string(in_amount) + " " + in.sym.code().to_string();
+    ran[op]++;
+    try
+    {
+        push(std::move(actions));
+    }
+    catch (const assertion &)
+    {
+        rejected[op]++;
+        return "";
+    }
+    return text;
+}
+
+// slack for the rounding of each measure: isqrt and D are off by at most a unit, L by float error
+static bool diluted(const defi_pool &before, const defi_pool &after)
+{
+    if (before.liquidity_token == 0 || after.liquidity_token == 0)
+        return false;
+    long double value_before = defi_value(before);
+    long double value_after = defi_value(after);
+    long double slack = after.kind == 1 ? value_after * 1e-12 : after.kind == 2 ? 2 : 1;
+    return (value_after + slack) * before.liquidity_token < value_before * after.liquidity_token;
+}
+
+std::string fuzzer::check(const defi_state &before, const defi_state &after) const
+{
+    for (const auto &kv : after.pools)
+    {
+        const defi_pool &p = kv.second;
+        std::string id = "pool " + std::to_string(p.id) + ": ";
+
+        if (p.reserve1 < 0 || p.reserve2 < 0 || (p.liquidity_token > 0 && (p.reserve1 == 0 || p.reserve2 == 0)))
+            return id + "reserve not positive";
+        if (!p.bounded)
+        {
+            auto old = before.pools.find(p.id);
+            std::string was = old == before.pools.end() ? "" : std::to_string(old->second.reserve1) + ":" +
+                                                                   std::to_string(old->second.reserve2) + " -> ";
+            return id + "stable pool left the bounds of its curve, " + was + std::to_string(p.reserve1) + ":" +
+                   std::to_string(p.reserve2);
+        }
+
+        uint64_t held = 0;
+        for (const auto &h : p.holders)
+            held += h.second;
+        if (held + p.wrapped != p.liquidity_token)
+            return id + "liquidity tokens held " + std::to_string(held) + " + wrapped " + std::to_string(p.wrapped) +
+                   " != supply " + std::to_string(p.liquidity_token);
+
+        uint64_t shares = 0;
+        for (const auto &h : p.shareholders)
+            shares += h.second;
+        if (shares != p.vault_shares)
+            return id + "vault shares held " + std::to_string(shares) + " != " + std::to_string(p.vault_shares);
+
+        auto old = before.pools.find(p.id);
+        if (old == before.pools.end())
+            continue;
+        const defi_pool &o = old->second;
+        bool linear = p.kind == 2;
+
+        // a swap: fees stay in the pool, the invariant at the old offsets must not shrink
+        // (D is solved to within one unit)
+        if (p.liquidity_token == o.liquidity_token && o.liquidity_token > 0)
+        {
+            curve::u128 k_before = defi_k(o, o.reserve1, o.reserve2);
+            curve::u128 k_after = defi_k(o, p.reserve1, p.reserve2);
+            if (k_after + (linear ? 1 : 0) < k_before)
+                return id + "k decreased from " + std::to_string((double)k_before) + " to " + std::to_string((double)k_after);
+        }
+        // minted or burned liquidity: what each liquidity token is worth must not shrink
+        else if (diluted(o, p))
+            return id + "liquidity token diluted, " + std::to_string(o.liquidity_token) + " -> " +
+                   std::to_string(p.liquidity_token);
+
+        // shares issued or redeemed: the vault's liquidity and pending, both in liquidity tokens at
+        // the reserves after, must not shrink per share (pending is floored per side)
+        auto vault_value = [&](const defi_pool &x) {
+            auto h = x.holders.find(DEFI.value);
+            long double value = h == x.holders.end() ? 0 : h->second;
+            if (p.liquidity_token > 0)
+                value += ((long double)x.pending1 * p.liquidity_token / p.reserve1 +
+                          (long double)x.pending2 * p.liquidity_token / p.reserve2) / 2;
+            return value;
+        };
+        if (o.vault_shares > 0 && p.vault_shares > 0 && o.vault_shares != p.vault_shares &&
+            vault_value(p) / p.vault_shares + 1e-9L < vault_value(o) / o.vault_shares)
+            return id + "vault share diluted, " + std::to_string(o.vault_shares) + " -> " + std::to_string(p.vault_shares);
+    }
+
+    for (const auto &owed : after.owed)
+    {
+        name contract(owed.first.first);
+        symbol sym(owed.first.second);
+        int64_t held = balance(contract, DEFI, sym).amount;
+        if (held < owed.second)
+            return "insolvent in " + sym.code().to_string() + ": holds " + std::to_string(held) + ", owes " +
+                   std::to_string(owed.second);
+    }
+
+    for (const auto &queued : after.queued)
+    {
+        auto r = after.reserved.find(queued.first);
+        if ((r == after.reserved.end() ? 0 : r->second) != queued.second)
+            return "reserved " + symbol(queued.first.second).code().to_string() + " out of step with the queue";
+    }
+    return "";
+}
+}
+
+int fuzz(const options &o)
+{
+    uint64_t steps = o.args.size() > 0 ? std::stoull(o.args[0]) : 100000;
+    uint64_t seed = o.args.size() > 1 ? std::stoull(o.args[1]) : std::random_device()();
+
+    chain c;
+    fuzzer f(c, seed);
+    f.setup();
+
+    defi_state before = read_defi();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 1; i <= steps; i++)
+    {
+        std::string text = f.step();
+        if (text.empty())
+            continue;
+
+        defi_state after = read_defi();
+        std::string broken = f.check(before, after);
+        if (!broken.empty())
+        {
+            printf("seed %llu step %llu, %s: %s\n", (unsigned long long)seed, (unsigned long long)i, text.c_str(),
+                   broken.c_str());
+            if (!o.output.empty())
+                c.save(o.output);
+            return 1;
+        }
+        before = std::move(after);
+    }
+    double secs = seconds_since(start);
+
+    uint64_t rejected = 0;
+    for (const auto &r : f.rejected)
+        rejected += r.second;
+    printf("seed %llu: %llu transactions, %llu rejected, in %.3f s: %.0f exec/s\n", (unsigned long long)seed,
+           (unsigned long long)steps, (unsigned long long)rejected, secs, secs > 0 ? steps / secs : 0);
+    for (const auto &r : f.ran)
+        printf("%s %llu ran %llu rejected\n", r.first.c_str(), (unsigned long long)r.second,
+               (unsigned long long)f.rejected[r.first]);
+    return 0;
+}
+}
@@ -0,0 +1,272 @@
+#include "json.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace sim
+{
+class parser
+{
+public:
+    parser(const std::string &s) : s(s) {}
+
+    json value()
+    {
+        space();
+        if (i >= s.size())
+            fail("unexpected end");
+
+        json v;
+        char c = s[i];
+        if (c == '{')
+        {
+            v.kind = json::object_t;
+            i++;
+            space();
+            if (peek('}'))
+                return v;
+            do
+            {
+                space();
+                std::string key = string();
+                space();
+                expect(':');
+                v.object.emplace_back(std::move(key), value());
+                space();
+            } while (peek(','));
+            expect('}');
+        }
+        else if (c == '[')
+        {
+            v.kind = json::array_t;
+            i++;
+            space();
+            if (peek(']'))
+                return v;
+            do
+                v.array.push_back(value());
+            while (space(), peek(','));
+            expect(']');
+        }
+        else if (c == '"')
+        {
+            v.kind = json::string_t;
+            v.text = string();
+        }
+        else if (s.compare(i, 4, "true") == 0 || s.compare(i, 5, "false") == 0)
+        {
+            v.kind = json::bool_t;
+            v.boolean = s[i] == 't';
+            i += v.boolean ? 4 : 5;
+        }
+        else if (s.compare(i, 4, "null") == 0)
+        {
+            i += 4;
+        }
+        else
+        {
+            size_t start = i;
+            while (i < s.size() && (isdigit((unsigned char)s[i]) || strchr("+-.eE", s[i]) != nullptr))
+                i++;
+            if (i == start)
+                fail("unexpected character");
+            v.kind = json::number_t;
+            v.text = s.substr(start, i - start);
+        }
+        return v;
+    }
+
+    void end()
+    {
+        space();
+        if (i != s.size())
+            fail("trailing characters");
+    }
+
+private:
+    const std::string &s;
+    size_t i = 0;
+
+    [[noreturn]] void fail(const char *what) { throw std::runtime_error(std::string("json: ") + what + " at " + std::to_string(i)); }
+
+    void space()
+    {
+        while (i < s.size() && isspace((unsigned char)s[i]))
+            i++;
+    }
+
+    bool peek(char c)
+    {
+        if (i < s.size() && s[i] == c)
+        {
+            i++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (!peek(c))
+            fail("unexpected character");
+    }
+
+    std::string string()
+    {
+        expect('"');
+        std::string r;
+        while (i < s.size() && s[i] != '"')
+        {
+            char c = s[i++];
+            if (c != '\\')
+            {
+                r += c;
+                continue;
+            }
+            if (i >= s.size())
+                break;
+            c = s[i++];
+            switch (c)
+            {
+            case 'n':
+                r += '\n';
+                break;
+            case 't':
+                r += '\t';
+                break;
+            case 'r':
+                r += '\r';
+                break;
+            case 'b':
+                r += '\b';
+                break;
+            case 'f':
+                r += '\f';
+                break;
+            case 'u':
+            {
+                if (i + 4 > s.size())
+                    fail("bad escape");
+                unsigned cp = std::stoul(s.substr(i, 4), nullptr, 16);
+                i += 4;
+                if (cp >= 0xd800 && cp < 0xdc00 && s.compare(i, 2, "\\u") == 0)
+                {
+                    unsigned lo = std::stoul(s.substr(i + 2, 4), nullptr, 16);
+                    i += 6;
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                }
+                if (cp < 0x80)
+                    r += (char)cp;
+                else if (cp < 0x800)
+                    r += (char)(0xc0 | cp >> 6), r += (char)(0x80 | (cp & 0x3f));
+                else if (cp < 0x10000)
+                    r += (char)(0xe0 | cp >> 12), r += (char)(0x80 | (cp >> 6 & 0x3f)), r += (char)(0x80 | (cp & 0x3f));
+                else
+                    r += (char)(0xf0 | cp >> 18), r += (char)(0x80 | (cp >> 12 & 0x3f)),
+                        r += (char)(0x80 | (cp >> 6 & 0x3f)), r += (char)(0x80 | (cp & 0x3f));
+                break;
+            }
+            default:
+                r += c;
+            }
+        }
+        expect('"');
+        return r;
+    }
+};
+
+json json::parse(const std::string &s)
+{
+    parser p(s);
+    json v = p.value();
+    p.end();
+    return v;
+}
+
+const json *json::find(const std::string &key) const
+{
+    for (const auto &kv : object)
+        if (kv.first == key)
+            return &kv.second;
+    return nullptr;
+}
+
+const json &json::operator[](const std::string &key) const
+{
+    const json *v = find(key);
+    if (v == nullptr)
+        throw std::runtime_error("json: missing " + key);
+    return *v;
+}
+
+static void quote(const std::string &s, std::string &out)
+{
+    out += '"';
+    for (unsigned char c : s)
+    {
+        if (c == '"' || c == '\\')
+            (out += '\\') += c;
+        else if (c == '\n')
+            out += "\\n";
+        else if (c < 0x20)
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }
+        else
+            out += c;
+    }
+    out += '"';
+}
+
+static void dump(const json &v, std::string &out)
+{
+    switch (v.kind)
+    {
+    case json::null_t:
+        out += "null";
+        break;
+    case json::bool_t:
+        out += v.boolean ? "true" : "false";
+        break;
+    case json::number_t:
+        out += v.text;
+        break;
+    case json::string_t:
+        quote(v.text, out);
+        break;
+    case json::array_t:
+        out += '[';
+        for (size_t i = 0; i < v.array.size(); i++)
+        {
+            if (i)
+                out += ',';
+            dump(v.array[i], out);
+        }
+        out += ']';
+        break;
+    case json::object_t:
+        out += '{';
+        for (size_t i = 0; i < v.object.size(); i++)
+        {
+            if (i)
+                out += ',';
+            quote(v.object[i].first, out);
+            out += ':';
+            dump(v.object[i].second, out);
+        }
+        out += '}';
+        break;
+    }
+}
+
+std::string json::dump() const
+{
+    std::string out;
+    sim::dump(*this, out);
+    return out;
+}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sim
+{
+// just enough json for cleos output and replay streams; numbers keep their text so
+// 64 bit values survive
+struct json
+{
+    enum kind_t
+    {
+        null_t,
+        bool_t,
+        number_t,
+        string_t,
+        array_t,
+        object_t
+    };
+
+    kind_t kind = null_t;
+    bool boolean = false;
+    std::string text;
+    std::vector<json> array;
+    std::vector<std::pair<std::string, json>> object;
+
+    static json parse(const std::string &s);
+
+    // nullptr when this is not an object or has no such key
+    const json *find(const std::string &key) const;
+    const json &operator[](const std::string &key) const;
+
+    std::string dump() const;
+};
+}
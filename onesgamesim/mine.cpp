@@ -0,0 +1,18 @@
+// onesgamemine compiled for the host against the eosiolib shim
+#include "chain.hpp"
+
+#define apply onesgamemine_apply
+namespace mine
+{
+#include "../onesgamemine/onesgamemine.cpp"
+}
+#undef apply
+
+namespace sim
+{
+// defipools and liquidityv2 are read from onesgamedefi, which registers them
+static registrar _mine(eosio::name("onesgamemine"), &mine::onesgamemine_apply,
+                       table_types<mine::onesgame::tb_defi_config, mine::onesgame::tb_defi_account,
+                                   mine::onesgame::tb_defi_market, mine::onesgame::tb_defi_round,
+                                   mine::onesgame::tb_reward_token, mine::onesgame::tb_vesting>());
+}
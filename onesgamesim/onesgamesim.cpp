@@ -0,0 +1,106 @@
+#include "onesgamesim.hpp"
+
+namespace sim
+{
+const abi &abi_of(const options &o, uint64_t code)
+{
+    auto a = o.abis.find(code);
+    return a == o.abis.end() ? abi::token() : a->second;
+}
+
+void load(chain &c, const std::string &path)
+{
+    auto start = std::chrono::steady_clock::now();
+    c.load(path);
+
+    uint64_t rows = 0;
+    for (const auto &t : c.tables)
+    {
+        rows += t.second.rows.size();
+        if (find_contract(t.first.code) == nullptr && t.first.table == eosio::name("accounts").value)
+            c.deploy(eosio::name(t.first.code), token_apply);
+    }
+
+    fprintf(stderr, "%s: %zu tables, %llu rows loaded in %.3f s\n", path.c_str(), c.tables.size(),
+            (unsigned long long)rows, seconds_since(start));
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+}
+
+using namespace sim;
+
+static int usage()
+{
+    fprintf(stderr,
+            "usage: onesgamesim pack [-a <account>=<abi>]... <dump dir> <snapshot>\n"
+            "       onesgamesim show [-a <account>=<abi>]... <snapshot> <code> <table> [scope]\n"
+            "       onesgamesim replay [-a <account>=<abi>]... [-l] [-e <expected>] [-o <out>] <snapshot> <stream>\n"
+            "       onesgamesim deps [-a <account>=<abi>]... [-l] [-j <workers>] [-x <table>]... <snapshot> <stream>\n"
+            "       onesgamesim ram [-a <account>=<abi>]... [-l] [-c <contract>] <snapshot> [<stream>]\n"
+            "       onesgamesim fuzz [-o <state at the failure>] [<transactions> [<seed>]]\n"
+            "dump dir holds <code>/<table>/<scope>.rows, one cleos row per line, and optionally <code>/abi.json\n");
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        return usage();
+
+    std::string cmd = argv[1];
+    options o;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-a" && i + 1 < argc)
+        {
+            std::string spec = argv[++i];
+            auto eq = spec.find('=');
+            if (eq == std::string::npos)
+                return usage();
+            o.abis[eosio::name(spec.substr(0, eq)).value] = abi::read(spec.substr(eq + 1));
+        }
+        else if (arg == "-l")
+            o.lenient = true;
+        else if (arg == "-e" && i + 1 < argc)
+            o.expected = argv[++i];
+        else if (arg == "-o" && i + 1 < argc)
+            o.output = argv[++i];
+        else if (arg == "-j" && i + 1 < argc)
+            o.jobs = std::stoul(argv[++i]);
+        else if (arg == "-x" && i + 1 < argc)
+            o.exclude.insert(eosio::name(argv[++i]).value);
+        else if (arg == "-c" && i + 1 < argc)
+            o.code = eosio::name(argv[++i]).value;
+        else if (arg.size() > 1 && arg[0] == '-')
+            return usage();
+        else
+            o.args.push_back(arg);
+    }
+
+    try
+    {
+        if (cmd == "pack" && o.args.size() == 2)
+            return pack(o);
+        if (cmd == "show" && (o.args.size() == 3 || o.args.size() == 4))
+            return show(o);
+        if (cmd == "replay" && o.args.size() == 2)
+            return replay(o);
+        if (cmd == "deps" && o.args.size() == 2)
+            return deps(o);
+        if (cmd == "ram" && (o.args.size() == 1 || o.args.size() == 2))
+            return ram(o);
+        if (cmd == "fuzz" && o.args.size() <= 2)
+            return fuzz(o);
+    }
+    catch (const std::exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return usage();
+}
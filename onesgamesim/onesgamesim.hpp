@@ -0,0 +1,113 @@
+#pragma once
+
+#include "abi.hpp"
+#include "chain.hpp"
+
+#include <chrono>
+#include <curve.hpp>
+
+namespace sim
+{
+struct options
+{
+    std::vector<std::string> args;
+
+    // -a <account>=<abi file>, for json rows and action arguments
+    std::map<uint64_t, abi> abis;
+
+    // -l: replay without token state, see chain::lenient
+    bool lenient = false;
+
+    // -e <snapshot>: the state the replay must end in
+    std::string expected;
+
+    // -o <snapshot>: where to save the state the replay ends in
+    std::string output;
+
+    // -j <workers>: processes deps runs the independent components on, 0 for one per core
+    size_t jobs = 0;
+
+    // -x <table>: tables deps ignores conflicts on, to see what they cost
+    std::set<uint64_t> exclude;
+
+    // -c <account>: the contract ram reports on, 0 for all
+    uint64_t code = 0;
+};
+
+// one line of a replay stream, run as one transaction
+struct step
+{
+    size_t line;
+    uint64_t time_us;
+
+    // what costs are reported under: the first action, see replay.cpp
+    std::string label;
+    eosio::transaction trx;
+};
+
+// parses a replay stream: "<contract> <action> <actor>[@<permission>] <json args>" per line,
+// "trx - - <json transaction>" for actions sharing a transaction, "time <unix seconds>" to move
+// the clock and # comments; deploys eosio.token to token contracts it sees for the first time
+std::vector<step> read_stream(const options &o, chain &c, const std::string &path);
+
+// abi for the rows and actions of code: -a, else eosio.token's
+const abi &abi_of(const options &o, uint64_t code);
+
+// loads a snapshot and deploys eosio.token to the token contracts it holds balances of
+void load(chain &c, const std::string &path);
+
+// a pool of onesgamedefi as the fuzzer sees it; read by defi.cpp, the one unit that can include the
+// contract's row types
+struct defi_pool
+{
+    uint64_t id = 0;
+    eosio::name contract1, contract2;
+    eosio::symbol symbol1, symbol2;
+    int64_t reserve1 = 0, reserve2 = 0;
+    uint64_t liquidity_token = 0;
+    uint64_t kind = 0, param1 = 0, param2 = 0;
+
+    // stable pools: reserves within what the stableswap maths handles
+    bool bounded = true;
+
+    // liquidity by holder in defipools, the contract holding the vault's, and the LP token supply
+    std::map<uint64_t, uint64_t> holders;
+    uint64_t wrapped = 0;
+
+    bool vault = false;
+    uint64_t vault_shares = 0;
+    std::map<uint64_t, uint64_t> shareholders;
+    int64_t pending1 = 0, pending2 = 0;
+};
+
+struct defi_state
+{
+    std::map<uint64_t, defi_pool> pools;
+
+    // by token contract and symbol: pool reserves, vault pending, mined rewards and queued withdrawals
+    // the contract holds, its reserved counter and the queue rows that counter stands for
+    std::map<std::pair<uint64_t, uint64_t>, int64_t> owed, reserved, queued;
+
+    // mining rewards in vaultmined, by token contract and symbol
+    std::map<std::pair<uint64_t, uint64_t>, int64_t> mined;
+    std::vector<std::pair<uint64_t, uint64_t>> queue;
+};
+
+defi_state read_defi();
+
+// the invariant a swap keeps, of pool p at reserves x, y: x*y, the product of the virtual reserves
+// with the offsets of p's reserves for range pools, D for stable ones
+curve::u128 defi_k(const defi_pool &p, int64_t x, int64_t y);
+
+// what the liquidity of p is worth, linear in its reserves: sqrt(x*y), the range pool's L, D
+long double defi_value(const defi_pool &p);
+
+double seconds_since(std::chrono::steady_clock::time_point start);
+
+int pack(const options &o);
+int show(const options &o);
+int replay(const options &o);
+int deps(const options &o);
+int fuzz(const options &o);
+int ram(const options &o);
+}
@@ -0,0 +1,139 @@
+// packs a cleos table dump into a binary snapshot and prints snapshot rows back
+#include "onesgamesim.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace sim
+{
+// a dump row is a hex string (get table -b), {"data": hex or object, "payer": name}
+// (--show-payer) or the decoded object
+static row parse_row(const options &o, const abi *dump_abi, uint64_t code, uint64_t table, const json &v)
+{
+    row r;
+    r.payer = code;
+
+    const json *data = &v;
+    if (v.kind == json::object_t && v.object.size() == 2 && v.find("data") && v.find("payer"))
+    {
+        data = &v["data"];
+        r.payer = eosio::name(v["payer"].text).value;
+    }
+
+    if (data->kind == json::string_t)
+    {
+        auto bytes = from_hex(data->text);
+        r.data.assign(bytes.data(), bytes.size());
+    }
+    else
+    {
+        const abi &a = dump_abi != nullptr && dump_abi->has_table(table) ? *dump_abi : abi_of(o, code);
+        r.data = a.pack_row(table, *data);
+    }
+    return r;
+}
+
+int pack(const options &o)
+{
+    auto start = std::chrono::steady_clock::now();
+    chain c;
+    uint64_t rows = 0;
+
+    for (const auto &code_dir : fs::directory_iterator(o.args[0]))
+    {
+        if (!code_dir.is_directory())
+            continue;
+        uint64_t code = eosio::name(code_dir.path().filename().string()).value;
+
+        abi dump_abi;
+        bool has_abi = fs::exists(code_dir.path() / "abi.json");
+        if (has_abi)
+            dump_abi = abi::read((code_dir.path() / "abi.json").string());
+
+        for (const auto &table_dir : fs::directory_iterator(code_dir.path()))
+        {
+            if (!table_dir.is_directory())
+                continue;
+            std::string table_name = table_dir.path().filename().string();
+            uint64_t table = eosio::name(table_name).value;
+
+            const table_type *type = find_table_type(code, table);
+            if (type == nullptr)
+            {
+                fprintf(stderr, "skipping %s %s, no contract here declares it\n", code_dir.path().filename().c_str(),
+                        table_name.c_str());
+                continue;
+            }
+
+            for (const auto &file : fs::directory_iterator(table_dir.path()))
+            {
+                // scopes may hold dots, only the suffix is ours
+                std::string scope_name = file.path().filename().string();
+                if (file.path().extension() != ".rows")
+                    continue;
+                scope_name.resize(scope_name.size() - strlen(".rows"));
+                uint64_t scope = eosio::name(scope_name).value;
+
+                sim::table &t = db_open_table(code, scope, table);
+                t.index_count = type->indices;
+
+                std::ifstream in(file.path());
+                std::string text;
+                for (size_t number = 1; std::getline(in, text); number++)
+                {
+                    if (text.empty())
+                        continue;
+                    try
+                    {
+                        row r = parse_row(o, has_abi ? &dump_abi : nullptr, code, table, json::parse(text));
+                        uint64_t pk = type->primary_key(r.data.data(), r.data.size());
+                        c.put_row(t, pk, std::move(r));
+                        rows++;
+                    }
+                    catch (const std::exception &e)
+                    {
+                        throw std::runtime_error(file.path().string() + ":" + std::to_string(number) + ": " + e.what());
+                    }
+                }
+            }
+        }
+    }
+
+    c.save(o.args[1]);
+    fprintf(stderr, "%llu rows in %zu tables packed in %.3f s\n", (unsigned long long)rows, c.tables.size(),
+            seconds_since(start));
+    return 0;
+}
+
+int show(const options &o)
+{
+    chain c;
+    load(c, o.args[0]);
+
+    uint64_t code = eosio::name(o.args[1]).value;
+    uint64_t table = eosio::name(o.args[2]).value;
+    const abi &a = abi_of(o, code);
+    for (const auto &t : c.tables)
+    {
+        if (t.first.code != code || t.first.table != table ||
+            (o.args.size() > 3 && t.first.scope != eosio::name(o.args[3]).value))
+            continue;
+        for (const auto &r : t.second.rows)
+        {
+            json row;
+            if (a.has_table(table))
+                row = a.unpack_row(table, r.second.data);
+            else
+            {
+                row.kind = json::string_t;
+                row.text = to_hex(r.second.data.data(), r.second.data.size());
+            }
+            printf("%s %llu %s %s\n", eosio::name(t.first.scope).to_string().c_str(), (unsigned long long)r.first,
+                   eosio::name(r.second.payer).to_string().c_str(), row.dump().c_str());
+        }
+    }
+    return 0;
+}
+}
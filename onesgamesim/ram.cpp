@@ -0,0 +1,136 @@
+// ram a snapshot is billed for, per table, scope and payer, and what a replay stream adds to it
+#include "onesgamesim.hpp"
+
+namespace sim
+{
+static std::string table_name(const table_key &key)
+{
+    return eosio::name(key.code).to_string() + ":" + eosio::name(key.table).to_string();
+}
+
+static int64_t total(const std::map<uint64_t, int64_t> &ram)
+{
+    int64_t bytes = 0;
+    for (const auto &r : ram)
+        bytes += r.second;
+    return bytes;
+}
+
+struct usage
+{
+    uint64_t rows = 0;
+    uint64_t scopes = 0;
+    int64_t bytes = 0;
+};
+
+static std::map<std::string, usage> by_table(const options &o, const chain &c)
+{
+    std::map<std::string, usage> tables;
+    for (const auto &t : c.tables)
+    {
+        if ((o.code != 0 && t.first.code != o.code) || t.second.rows.empty())
+            continue;
+        usage &u = tables[table_name(t.first)];
+        u.rows += t.second.rows.size();
+        u.scopes++;
+        u.bytes += c.table_ram(t.second);
+    }
+    return tables;
+}
+
+int ram(const options &o)
+{
+    chain c;
+    c.lenient = o.lenient;
+    load(c, o.args[0]);
+    std::vector<step> steps;
+    if (o.args.size() > 1)
+        steps = read_stream(o, c, o.args[1]);
+
+    // the table and its indices are billed to the first row's payer, each row to its own
+    std::map<uint64_t, int64_t> payers;
+    printf("table scope payer rows data ram\n");
+    for (const auto &t : c.tables)
+    {
+        if ((o.code != 0 && t.first.code != o.code) || t.second.rows.empty())
+            continue;
+
+        std::map<uint64_t, std::pair<uint64_t, int64_t>> rows;
+        int64_t data = 0;
+        for (const auto &r : t.second.rows)
+        {
+            rows[r.second.payer].first++;
+            rows[r.second.payer].second += c.row_ram(t.second, r.second);
+            data += r.second.data.size();
+        }
+        rows[t.second.payer].second += RAM_TABLE_BYTES * (1 + (int64_t)t.second.index_count);
+
+        for (const auto &p : rows)
+        {
+            printf("%s %s %s %llu %lld %lld\n", table_name(t.first).c_str(), eosio::name(t.first.scope).to_string().c_str(),
+                   eosio::name(p.first).to_string().c_str(), (unsigned long long)p.second.first,
+                   (long long)(p.first == t.second.payer ? data : 0), (long long)p.second.second);
+            payers[p.first] += p.second.second;
+        }
+    }
+
+    std::map<std::string, usage> tables = by_table(o, c);
+    printf("\ntable scopes rows ram ram/1k-rows\n");
+    for (const auto &t : tables)
+        printf("%s %llu %llu %lld %lld\n", t.first.c_str(), (unsigned long long)t.second.scopes,
+               (unsigned long long)t.second.rows, (long long)t.second.bytes,
+               (long long)((t.second.bytes - RAM_TABLE_BYTES * (int64_t)t.second.scopes) * 1000 / (int64_t)t.second.rows));
+
+    printf("\npayer ram\n");
+    for (const auto &p : payers)
+        printf("%s %lld\n", eosio::name(p.first).to_string().c_str(), (long long)p.second);
+
+    if (o.args.size() < 2)
+        return 0;
+
+    // growth over the stream, per action and per table
+    if (steps.empty())
+        throw std::runtime_error(o.args[1] + ": no transactions");
+    std::map<std::string, std::pair<uint64_t, int64_t>> actions;
+    uint64_t failed = 0;
+    for (const auto &s : steps)
+    {
+        if (s.time_us != 0)
+            c.time_us = s.time_us;
+        int64_t before = total(c.ram);
+        try
+        {
+            c.push(s.trx);
+        }
+        catch (const assertion &e)
+        {
+            if (failed++ < 20)
+                fprintf(stderr, "line %zu %s: %s\n", s.line, s.label.c_str(), e.what());
+        }
+        actions[s.label].first++;
+        actions[s.label].second += total(c.ram) - before;
+    }
+
+    printf("\n%zu transactions, %llu failed\naction count ram ram/1k-actions\n", steps.size(), (unsigned long long)failed);
+    for (const auto &a : actions)
+        printf("%s %llu %lld %lld\n", a.first.c_str(), (unsigned long long)a.second.first, (long long)a.second.second,
+               (long long)(a.second.second * 1000 / (int64_t)a.second.first));
+
+    std::map<std::string, usage> after = by_table(o, c);
+    printf("\ntable rows ram ram/1k-transactions\n");
+    for (const auto &t : after)
+    {
+        static const usage none;
+        auto found = tables.find(t.first);
+        const usage &was = found == tables.end() ? none : found->second;
+        int64_t grown = t.second.bytes - was.bytes;
+        printf("%s %+lld %+lld %+lld\n", t.first.c_str(), (long long)t.second.rows - (long long)was.rows, (long long)grown,
+               (long long)(grown * 1000 / (int64_t)steps.size()));
+    }
+    for (const auto &t : tables)
+        if (!after.count(t.first))
+            printf("%s %+lld %+lld %+lld\n", t.first.c_str(), -(long long)t.second.rows, -(long long)t.second.bytes,
+                   -(long long)(t.second.bytes * 1000 / (int64_t)steps.size()));
+    return 0;
+}
+}
@@ -0,0 +1,278 @@
+// replays a recorded action stream against a snapshot
+#include "onesgamesim.hpp"
+
+#include <fstream>
+
+namespace sim
+{
+static eosio::action make_action(const options &o, chain &c, eosio::name account, eosio::name act,
+                                 std::vector<eosio::permission_level> auths, const json &data)
+{
+    const abi &a = abi_of(o, account.value);
+    if (!c.deployed(account) && &a == &abi::token() && a.has_action(act.value))
+        c.deploy(account, token_apply);
+
+    eosio::action result;
+    result.account = account;
+    result.name = act;
+    result.authorization = std::move(auths);
+    if (data.kind == json::string_t)
+        result.data = from_hex(data.text);
+    else
+    {
+        std::string packed = a.pack_action(act.value, data);
+        result.data.assign(packed.begin(), packed.end());
+    }
+    return result;
+}
+
+// <contract>:<action>, and for transfers the memo's verb too, "<contract>:transfer:swap", as every
+// memo driven action of onesgamedefi arrives as a transfer; the verb is the memo's leading run of
+// lower case letters and digits, so free text memos stay under the plain label
+static std::string label(const eosio::action &a)
+{
+    std::string text = a.account.to_string() + ":" + a.name.to_string();
+    if (a.name != eosio::name("transfer"))
+        return text;
+
+    std::string memo;
+    try
+    {
+        memo = std::get<3>(eosio::unpack<std::tuple<eosio::name, eosio::name, eosio::asset, std::string>>(a.data));
+    }
+    catch (const std::exception &)
+    {
+        return text;
+    }
+    size_t end = 0;
+    while (end < memo.size() && (std::islower((unsigned char)memo[end]) || std::isdigit((unsigned char)memo[end])))
+        end++;
+    return end == 0 ? text : text + ":" + memo.substr(0, end);
+}
+
+static eosio::permission_level permission(const std::string &s)
+{
+    auto at = s.find('@');
+    if (at == std::string::npos)
+        return eosio::permission_level(eosio::name(s), eosio::name("active"));
+    return eosio::permission_level(eosio::name(s.substr(0, at)), eosio::name(s.substr(at + 1)));
+}
+
+std::vector<step> read_stream(const options &o, chain &c, const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("open " + path);
+
+    std::vector<step> steps;
+    uint64_t time_us = c.time_us;
+    std::string text;
+    for (size_t number = 1; std::getline(in, text); number++)
+    {
+        size_t first = text.find_first_not_of(" \t");
+        if (first == std::string::npos || text[first] == '#')
+            continue;
+
+        try
+        {
+            // three words, then the json
+            std::vector<std::string> words;
+            size_t pos = first;
+            while (words.size() < 3 && pos < text.size())
+            {
+                size_t end = text.find_first_of(" \t", pos);
+                words.push_back(text.substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+                pos = end == std::string::npos ? text.size() : text.find_first_not_of(" \t", end);
+                if (pos == std::string::npos)
+                    pos = text.size();
+                if (words[0] == "time")
+                    break;
+            }
+
+            if (words[0] == "time")
+            {
+                time_us = std::stoull(text.substr(pos)) * 1000000;
+                continue;
+            }
+            if (words.size() < 3 || pos == text.size())
+                throw std::runtime_error("expected <contract> <action> <actor> <json>");
+
+            step s;
+            s.line = number;
+            s.time_us = time_us;
+            json data = json::parse(text.substr(pos));
+            if (words[0] == "trx")
+            {
+                for (const auto &a : data["actions"].array)
+                {
+                    std::vector<eosio::permission_level> auths;
+                    for (const auto &p : a["authorization"].array)
+                        auths.emplace_back(eosio::name(p["actor"].text), eosio::name(p["permission"].text));
+                    s.trx.actions.push_back(
+                        make_action(o, c, eosio::name(a["account"].text), eosio::name(a["name"].text), auths, a["data"]));
+                }
+                if (s.trx.actions.empty())
+                    throw std::runtime_error("transaction without actions");
+            }
+            else
+                s.trx.actions.push_back(make_action(o, c, eosio::name(words[0]), eosio::name(words[1]),
+                                                    {permission(words[2])}, data));
+
+            // distinct transaction ids for otherwise identical lines, as tapos gives them on chain
+            s.trx.expiration = time_us / 1000000 + 30;
+            s.trx.ref_block_num = (uint16_t)number;
+            s.trx.ref_block_prefix = (uint32_t)(number >> 16);
+            s.label = label(s.trx.actions[0]);
+            steps.push_back(std::move(s));
+        }
+        catch (const std::exception &e)
+        {
+            throw std::runtime_error(path + ":" + std::to_string(number) + ": " + e.what());
+        }
+    }
+    return steps;
+}
+
+struct cost
+{
+    std::vector<uint64_t> ns;
+    std::map<uint64_t, uint64_t> buckets;
+};
+
+static void print_costs(const std::map<std::string, cost> &costs)
+{
+    printf("action count avg_us p50_us p99_us max_us\n");
+    for (auto &kv : costs)
+    {
+        std::vector<uint64_t> ns = kv.second.ns;
+        std::sort(ns.begin(), ns.end());
+        uint64_t total = 0;
+        for (uint64_t n : ns)
+            total += n;
+        printf("%s %zu %.1f %.1f %.1f %.1f\n", kv.first.c_str(), ns.size(), total / 1000.0 / ns.size(),
+               ns[ns.size() / 2] / 1000.0, ns[ns.size() * 99 / 100] / 1000.0, ns.back() / 1000.0);
+        for (auto &b : kv.second.buckets)
+            printf("    <=%lluus %llu\n", (unsigned long long)b.first, (unsigned long long)b.second);
+    }
+}
+
+static std::string row_text(const options &o, const table_key &key, const row *r)
+{
+    if (r == nullptr)
+        return "-";
+    const abi &a = abi_of(o, key.code);
+    try
+    {
+        if (a.has_table(key.table))
+            return a.unpack_row(key.table, r->data).dump();
+    }
+    catch (const std::exception &)
+    {
+    }
+    return to_hex(r->data.data(), r->data.size());
+}
+
+// compares the tables the expected snapshot holds, in every scope
+static uint64_t diverged(const options &o, const chain &c)
+{
+    const std::map<table_key, table> &replayed = c.tables;
+    chain expected;
+    expected.load(o.expected);
+
+    std::set<std::pair<uint64_t, uint64_t>> covered;
+    for (const auto &t : expected.tables)
+        covered.insert({t.first.code, t.first.table});
+
+    std::set<table_key> keys;
+    for (const auto &t : replayed)
+        if (covered.count({t.first.code, t.first.table}))
+            keys.insert(t.first);
+    for (const auto &t : expected.tables)
+        keys.insert(t.first);
+
+    static const table empty;
+    uint64_t rows = 0;
+    for (const auto &key : keys)
+    {
+        auto r = replayed.find(key);
+        auto e = expected.tables.find(key);
+        const table &got = r == replayed.end() ? empty : r->second;
+        const table &want = e == expected.tables.end() ? empty : e->second;
+
+        std::set<uint64_t> pks;
+        for (const auto &row : got.rows)
+            pks.insert(row.first);
+        for (const auto &row : want.rows)
+            pks.insert(row.first);
+
+        for (uint64_t pk : pks)
+        {
+            auto g = got.rows.find(pk);
+            auto w = want.rows.find(pk);
+            const row *got_row = g == got.rows.end() ? nullptr : &g->second;
+            const row *want_row = w == want.rows.end() ? nullptr : &w->second;
+            if (got_row != nullptr && want_row != nullptr && got_row->data == want_row->data)
+                continue;
+
+            if (rows++ < 20)
+                printf("%s %s %s %llu\n    replayed %s\n    expected %s\n", eosio::name(key.code).to_string().c_str(),
+                       eosio::name(key.table).to_string().c_str(), eosio::name(key.scope).to_string().c_str(),
+                       (unsigned long long)pk, row_text(o, key, got_row).c_str(), row_text(o, key, want_row).c_str());
+        }
+    }
+    return rows;
+}
+
+int replay(const options &o)
+{
+    chain c;
+    c.lenient = o.lenient;
+    load(c, o.args[0]);
+    std::vector<step> steps = read_stream(o, c, o.args[1]);
+
+    std::map<std::string, cost> costs;
+    uint64_t actions = 0, failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &s : steps)
+    {
+        if (s.time_us != 0)
+            c.time_us = s.time_us;
+
+        auto begin = std::chrono::steady_clock::now();
+        try
+        {
+            c.push(s.trx);
+        }
+        catch (const assertion &e)
+        {
+            if (failed++ < 20)
+                fprintf(stderr, "line %zu %s: %s\n", s.line, s.label.c_str(), e.what());
+        }
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+        cost &k = costs[s.label];
+        k.ns.push_back(ns);
+        uint64_t bucket = 1;
+        while (bucket * 1000 < ns)
+            bucket *= 2;
+        k.buckets[bucket]++;
+        actions += c.last_traces().size();
+    }
+    double secs = seconds_since(start);
+
+    printf("%zu transactions, %llu actions with inline and notifications, %llu failed, in %.3f s: %.0f transactions/sec\n",
+           steps.size(), (unsigned long long)actions, (unsigned long long)failed, secs, secs > 0 ? steps.size() / secs : 0);
+    print_costs(costs);
+
+    if (!o.output.empty())
+        c.save(o.output);
+
+    if (!o.expected.empty())
+    {
+        uint64_t rows = diverged(o, c);
+        printf(rows == 0 ? "no divergence\n" : "%llu rows diverge\n", (unsigned long long)rows);
+        return rows == 0 ? 0 : 1;
+    }
+    return 0;
+}
+}
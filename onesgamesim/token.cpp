@@ -0,0 +1,218 @@
+// eosio.token for the simulator, deployed to every token contract the onesgame contracts
+// touch. issue credits to directly and notifies it, the way eosonestoken does.
+#include "chain.hpp"
+
+using namespace eosio;
+
+namespace token
+{
+class token : public contract
+{
+public:
+    using contract::contract;
+
+    struct account
+    {
+        asset balance;
+
+        uint64_t primary_key() const { return balance.symbol.code().raw(); }
+    };
+    typedef multi_index<"accounts"_n, account> accounts;
+
+    struct currency_stats
+    {
+        asset supply;
+        asset max_supply;
+        name issuer;
+
+        uint64_t primary_key() const { return supply.symbol.code().raw(); }
+    };
+    typedef multi_index<"stat"_n, currency_stats> stats;
+
+    void create(name issuer, asset maximum_supply)
+    {
+        require_auth(_self);
+
+        auto sym = maximum_supply.symbol;
+        eosio_assert(sym.is_valid(), "invalid symbol name");
+        eosio_assert(maximum_supply.is_valid(), "invalid supply");
+        eosio_assert(maximum_supply.amount > 0, "max-supply must be positive");
+
+        stats statstable(_self, sym.code().raw());
+        auto existing = statstable.find(sym.code().raw());
+        eosio_assert(existing == statstable.end(), "token with symbol already exists");
+
+        statstable.emplace(_self, [&](auto &s) {
+            s.supply.symbol = maximum_supply.symbol;
+            s.max_supply = maximum_supply;
+            s.issuer = issuer;
+        });
+    }
+
+    void issue(name to, asset quantity, std::string memo)
+    {
+        auto sym = quantity.symbol;
+        eosio_assert(sym.is_valid(), "invalid symbol name");
+        eosio_assert(memo.size() <= 256, "memo has more than 256 bytes");
+
+        stats statstable(_self, sym.code().raw());
+        auto existing = statstable.find(sym.code().raw());
+        eosio_assert(existing != statstable.end(), "token with symbol does not exist, create token before issue");
+        const auto &st = *existing;
+
+        require_auth(st.issuer);
+        eosio_assert(quantity.is_valid(), "invalid quantity");
+        eosio_assert(quantity.amount > 0, "must issue positive quantity");
+        eosio_assert(quantity.symbol == st.supply.symbol, "symbol precision mismatch");
+        eosio_assert(quantity.amount <= st.max_supply.amount - st.supply.amount, "quantity exceeds available supply");
+
+        statstable.modify(st, same_payer, [&](auto &s) { s.supply += quantity; });
+
+        _add_balance(to, quantity, st.issuer);
+        if (to != st.issuer)
+            require_recipient(to);
+    }
+
+    void retire(asset quantity, std::string memo)
+    {
+        auto sym = quantity.symbol;
+        stats statstable(_self, sym.code().raw());
+        auto existing = statstable.find(sym.code().raw());
+        eosio_assert(existing != statstable.end(), "token with symbol does not exist");
+        const auto &st = *existing;
+
+        require_auth(st.issuer);
+        eosio_assert(quantity.is_valid(), "invalid quantity");
+        eosio_assert(quantity.amount > 0, "must retire positive quantity");
+        eosio_assert(quantity.symbol == st.supply.symbol, "symbol precision mismatch");
+
+        statstable.modify(st, same_payer, [&](auto &s) { s.supply -= quantity; });
+        _sub_balance(st.issuer, quantity);
+    }
+
+    void transfer(name from, name to, asset quantity, std::string memo)
+    {
+        eosio_assert(from != to, "cannot transfer to self");
+        require_auth(from);
+        eosio_assert(is_account(to), "to account does not exist");
+
+        auto sym = quantity.symbol.code();
+        stats statstable(_self, sym.raw());
+        const auto &st = sim::current().lenient ? _lenient_stat(statstable, quantity) : statstable.get(sym.raw(), "no stat");
+
+        require_recipient(from);
+        require_recipient(to);
+
+        eosio_assert(quantity.is_valid(), "invalid quantity");
+        eosio_assert(quantity.amount > 0, "must transfer positive quantity");
+        eosio_assert(quantity.symbol == st.supply.symbol, "symbol precision mismatch");
+        eosio_assert(memo.size() <= 256, "memo has more than 256 bytes");
+
+        auto payer = has_auth(to) ? to : from;
+
+        _sub_balance(from, quantity);
+        _add_balance(to, quantity, payer);
+    }
+
+    void open(name owner, const symbol &symbol, name ram_payer)
+    {
+        require_auth(ram_payer);
+
+        stats statstable(_self, symbol.code().raw());
+        const auto &st = statstable.get(symbol.code().raw(), "symbol does not exist");
+        eosio_assert(st.supply.symbol == symbol, "symbol precision mismatch");
+
+        accounts acnts(_self, owner.value);
+        auto it = acnts.find(symbol.code().raw());
+        if (it == acnts.end())
+            acnts.emplace(ram_payer, [&](auto &a) { a.balance = asset{0, symbol}; });
+    }
+
+    void close(name owner, const symbol &symbol)
+    {
+        require_auth(owner);
+        accounts acnts(_self, owner.value);
+        auto it = acnts.find(symbol.code().raw());
+        eosio_assert(it != acnts.end(), "Balance row already deleted or never existed. Action won't have any effect.");
+        eosio_assert(it->balance.amount == 0, "Cannot close because the balance is not zero.");
+        acnts.erase(it);
+    }
+
+private:
+    static constexpr name same_payer = name();
+
+    // streams replayed without token state: unknown symbols come into existence
+    const currency_stats &_lenient_stat(stats &statstable, const asset &quantity)
+    {
+        auto existing = statstable.find(quantity.symbol.code().raw());
+        if (existing == statstable.end())
+            existing = statstable.emplace(_self, [&](auto &s) {
+                s.supply = asset(0, quantity.symbol);
+                s.max_supply = asset(asset::max_amount, quantity.symbol);
+                s.issuer = _self;
+            });
+        return *existing;
+    }
+
+    void _sub_balance(name owner, asset value)
+    {
+        accounts from_acnts(_self, owner.value);
+
+        auto from = from_acnts.find(value.symbol.code().raw());
+        if (sim::current().lenient && (from == from_acnts.end() || from->balance.amount < value.amount))
+        {
+            // mint what the balance lacks, so the transfer goes through as it did on chain
+            asset missing = from == from_acnts.end() ? value : value - from->balance;
+            stats statstable(_self, value.symbol.code().raw());
+            statstable.modify(statstable.get(value.symbol.code().raw()), same_payer, [&](auto &s) { s.supply += missing; });
+            if (from == from_acnts.end())
+                from = from_acnts.emplace(owner, [&](auto &a) { a.balance = asset(0, value.symbol); });
+            from_acnts.modify(from, same_payer, [&](auto &a) { a.balance += missing; });
+        }
+
+        const auto &from_row = from_acnts.get(value.symbol.code().raw(), "no balance object found");
+        eosio_assert(from_row.balance.amount >= value.amount, "overdrawn balance");
+
+        from_acnts.modify(from_row, owner, [&](auto &a) { a.balance -= value; });
+    }
+
+    void _add_balance(name owner, asset value, name ram_payer)
+    {
+        accounts to_acnts(_self, owner.value);
+        auto to = to_acnts.find(value.symbol.code().raw());
+        if (to == to_acnts.end())
+            to_acnts.emplace(ram_payer, [&](auto &a) { a.balance = value; });
+        else
+            to_acnts.modify(to, same_payer, [&](auto &a) { a.balance += value; });
+    }
+};
+
+extern "C" void token_apply(uint64_t receiver, uint64_t code, uint64_t action)
+{
+    if (code != receiver)
+        return;
+
+    switch (action)
+    {
+        EOSIO_DISPATCH_HELPER(token, (create)(issue)(retire)(transfer)(open)(close))
+    }
+}
+}
+
+namespace sim
+{
+apply_fn token_apply = &token::token_apply;
+
+asset balance(name contract, name owner, symbol sym)
+{
+    table *t = db_find_table(contract.value, owner.value, "accounts"_n.value);
+    if (t == nullptr)
+        return asset(0, sym);
+    auto r = t->rows.find(sym.code().raw());
+    if (r == t->rows.end())
+        return asset(0, sym);
+    return unpack<asset>(r->second.data.data(), r->second.data.size());
+}
+
+static registrar _token(name("eosio.token"), token_apply, table_types<token::token::accounts, token::token::stats>());
+}
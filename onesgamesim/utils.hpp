@@ -0,0 +1,67 @@
+// onesgamedefi/utils.hpp as it behaves compiled to wasm32, found ahead of it on the include
+// path: pointers are 4 bytes, so sha256_to_hex covers 4 bytes of the hash, and libc++ hashes
+// strings with 32 bit murmur2. Keep in step with onesgamedefi/utils.hpp.
+namespace utils {
+using std::string;
+using namespace eosio;
+
+string to_hex(const char *d, uint32_t s) {
+    std::string r;
+    const char *to_hex = "0123456789abcdef";
+    uint8_t *c = (uint8_t *)d;
+    for (uint32_t i = 0; i < s; ++i)
+        (r += to_hex[(c[i] >> 4)]) += to_hex[(c[i] & 0x0f)];
+    return r;
+}
+
+string sha256_to_hex(const checksum256 &sha256) {
+    auto hash_data = sha256.extract_as_byte_array();
+    return to_hex((char *)hash_data.data(), sizeof(uint32_t));
+}
+
+uint64_t uint64_hash(const string &hash) {
+    const uint32_t m = 0x5bd1e995;
+    const uint8_t *data = (const uint8_t *)hash.data();
+    uint32_t len = hash.size();
+    uint32_t h = len;
+    for (; len >= 4; data += 4, len -= 4) {
+        uint32_t k;
+        memcpy(&k, data, sizeof(k));
+        k *= m;
+        k ^= k >> 24;
+        k *= m;
+        h *= m;
+        h ^= k;
+    }
+    switch (len) {
+    case 3:
+        h ^= data[2] << 16;
+        // fall through
+    case 2:
+        h ^= data[1] << 8;
+        // fall through
+    case 1:
+        h ^= data[0];
+        h *= m;
+    }
+    h ^= h >> 13;
+    h *= m;
+    h ^= h >> 15;
+    return h;
+}
+
+uint64_t uint64_hash(const checksum256 &hash) {
+    return uint64_hash(sha256_to_hex(hash));
+}
+
+void split(const std::string &str, char delimiter, std::vector<std::string> &params) {
+    std::size_t cur, prev = 0;
+    cur = str.find(delimiter);
+    while (cur != std::string::npos) {
+        params.push_back(str.substr(prev, cur - prev));
+        prev = cur + 1;
+        cur = str.find(delimiter, prev);
+    }
+    params.push_back(str.substr(prev));
+}
+}